@@ -10,8 +10,10 @@
 
 /* <Includes> */ 
 
+#include "Arduino.h"
 #include "AD569xR.h"
-#include <Wire.h>
+#include "Profiler.h"
+#include "I2C.h"
 
 /* </Includes> */ 
 
@@ -19,6 +21,10 @@
 /* <Module variables> */ 
 
 static ErrorMessaging_Error AD569xRError;
+static uint8_t queuedWrites; /* Writes passed to the I2C queue, intentional wraparound */
+static volatile uint8_t finishedWrites; /* Writes finished, failed or aborted, incremented by the I2C callback, intentional wraparound */
+static volatile uint8_t failedWrites; /* Writes that did not reach the DAC, intentional wraparound */
+static volatile uint32_t writeTime; /* micros() when the last successful write reached the DAC */
 
 /* </Module variables> */ 
 
@@ -26,12 +32,19 @@ static ErrorMessaging_Error AD569xRError;
 /* <Declarations (prototypes)> */ 
 
 /**
- * Sends a 16-bit word to AD569xR
+ * Queues a 16-bit word to AD569xR
  * 
  * @param data - Payload
  */
 void AD569xR_Send(uint8_t command, uint16_t data);
 
+/**
+ * Counts a finished write and its result, called from the I2C interrupt
+ *
+ * @param transaction - finished transaction
+ */
+void AD569xR_Written(const I2C_Transaction * transaction);
+
 /* </Declarations (prototypes)> */ 
 
 
@@ -41,6 +54,10 @@ void AD569xR_Init(void)
 {
   AD569xRError.errorCounter = 0;
   AD569xRError.error = ErrorMessaging_AD569xR_Overload;
+  queuedWrites = 0;
+  finishedWrites = 0;
+  failedWrites = 0;
+  writeTime = micros();
   
   AD569xR_Send(AD569xR_WRITE_CONTROL_REGISTER, AD569xR_RESET);  
 }
@@ -55,19 +72,74 @@ bool AD569xR_Set(uint16_t value)
   else
   {
     AD569xR_Send(AD569xR_WRITE_DAC_AND_INPUT_REGISTERS, AD569xR_MAXIMUM_VALUE); 
-    AD569xRError.errorCounter++;
-    AD569xRError.error = ErrorMessaging_AD569xR_Overload;
+    ErrorMessaging_Raise(&AD569xRError, ErrorMessaging_AD569xR_Overload);
     return false;
   }
 }
 
 void AD569xR_Send(uint8_t command, uint16_t data)
 {
-  Wire.beginTransmission(AD569xR_ADDRESS);  
-  Wire.write(command & 0xFF);
-  Wire.write((data >> 8) & 0xFF); /* MSB first */
-  Wire.write(data & 0xFF);
-  Wire.endTransmission();
+  uint8_t bytes[3];
+
+  bytes[0] = command & 0xFF;
+  bytes[1] = (data >> 8) & 0xFF; /* MSB first */
+  bytes[2] = data & 0xFF;
+  PROFILER_BEGIN();
+  queuedWrites++; /* Counted before queuing, the write may finish before I2C_Queue returns */
+  if (!I2C_Queue(AD569xR_ADDRESS, bytes, 3, 0, &AD569xR_Written))
+  {
+    noInterrupts();
+    finishedWrites++;
+    failedWrites++;
+    interrupts();
+  }
+  PROFILER_END(Probe_AD569xRSend);
+}
+
+void AD569xR_Wait(void)
+{
+  while (finishedWrites != queuedWrites)
+  {
+    I2C_Do(); /* Aborts a stuck transaction */
+  }
+}
+
+uint8_t AD569xR_GetTicket(void)
+{
+  return queuedWrites;
+}
+
+bool AD569xR_IsWritten(uint8_t ticket)
+{
+  return (uint8_t)(finishedWrites - ticket) < 0x80; /* Fewer writes than I2C_QUEUE_SIZE are in progress, the difference does not wrap */
+}
+
+uint8_t AD569xR_GetFailedWrites(void)
+{
+  return failedWrites;
+}
+
+uint32_t AD569xR_GetWriteTime(void)
+{
+  uint32_t time;
+
+  noInterrupts(); /* 32-bit read is not atomic on 8-bit MCU */
+  time = writeTime;
+  interrupts();
+  return time;
+}
+
+void AD569xR_Written(const I2C_Transaction * transaction)
+{
+  if (transaction->status == I2C_Done)
+  {
+    writeTime = micros();
+  }
+  else
+  {
+    failedWrites++;
+  }
+  finishedWrites++;
 }
 
 const ErrorMessaging_Error * AD569xR_GetError(void)
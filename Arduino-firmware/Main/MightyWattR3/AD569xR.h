@@ -46,6 +46,42 @@ void AD569xR_Init(void);
  * @return - true if command succeeded, false otherwise
  */
 bool AD569xR_Set(uint16_t value);
+
+/**
+ * Waits until the queued writes reach the DAC
+ * AD569xR_Set only queues the write, the output changes when the I2C transaction finishes
+ */
+void AD569xR_Wait(void);
+
+/**
+ * Gets the ticket of the last queued write
+ *
+ * @return - Number of queued writes, intentional wraparound
+ */
+uint8_t AD569xR_GetTicket(void);
+
+/**
+ * Checks whether the writes up to a ticket are finished
+ *
+ * @param ticket - Ticket from AD569xR_GetTicket
+ *
+ * @return - True if the write of the ticket and all writes before it finished, successfully or not
+ */
+bool AD569xR_IsWritten(uint8_t ticket);
+
+/**
+ * Gets the number of writes that did not reach the DAC (NACK, bus error, timeout, full queue or bus reset)
+ *
+ * @return - Number of failed writes, intentional wraparound
+ */
+uint8_t AD569xR_GetFailedWrites(void);
+
+/**
+ * Gets the time when the last successful write reached the DAC
+ *
+ * @return - micros() of the end of the write
+ */
+uint32_t AD569xR_GetWriteTime(void);
  
 /**
  * Returns error structure for this module
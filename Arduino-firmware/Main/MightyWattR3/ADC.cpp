@@ -12,6 +12,8 @@
 
 #include "Arduino.h"
 #include "ADC.h"
+#include "Profiler.h"
+#include "Events.h"
 
 /* </Includes> */ 
 
@@ -20,18 +22,43 @@
 
 static ADS1x15_ChannelSetting ChannelSettings[ADC_CHANNEL_COUNT];
 static bool ChannelIsFiltered[ADC_CHANNEL_COUNT];
-static uint8_t ChannelSkipRatio[ADC_CHANNEL_COUNT];
-static uint16_t ChannelCycleCounter[ADC_CHANNEL_COUNT];
+static ADC_ChannelWeights ModeWeights, HostWeights; /* Host weights 0 = not set */
+static int8_t VoltageCredit, CurrentCredit; /* Smooth weighted round-robin: the channel with more credit is converted next */
+static uint16_t ConversionsSinceTemperature;
+static uint16_t SampleCounts[ADC_CHANNEL_COUNT]; /* Samples in the present rate window */
+static uint16_t SampleRates[ADC_CHANNEL_COUNT]; /* Samples per second in the last rate window */
+static uint32_t RateWindowStart;
 static uint32_t LastUpdate;
+static ADS1x15_Ranges ConvertingRange; /* Range of the conversion in progress */
 static TSCADCLong Voltages[ADC_CHANNEL_COUNT];
 static ErrorMessaging_Error ADCError[ADC_CHANNEL_COUNT];
-static int32_t VoltageFilterData[ADC_V_CHANNEL_FILTER_SIZE],
-               CurrentFilterData[ADC_I_CHANNEL_FILTER_SIZE],
-               TemperatureFilterData[ADC_T_CHANNEL_FILTER_SIZE];
-static ADC_TriangleFilterData VoltageFilter = {ADC_V_CHANNEL_FILTER_SIZE, VoltageFilterData, 0, 0, 0, false };
-static ADC_TriangleFilterData CurrentFilter = {ADC_I_CHANNEL_FILTER_SIZE, CurrentFilterData, 0, 0, 0, false };
-static ADC_TriangleFilterData TemperatureFilter = {ADC_T_CHANNEL_FILTER_SIZE, TemperatureFilterData, 0, 0, 0, false };
-static ADC_TriangleFilterData Filters[ADC_CHANNEL_COUNT] = {VoltageFilter, CurrentFilter, TemperatureFilter};
+#ifdef ADC_BURST_SHARES_FILTERS
+static union
+#else
+static struct
+#endif
+{
+  struct
+  {
+    int32_t voltage[ADC_V_CHANNEL_FILTER_SIZE];
+    int32_t current[ADC_I_CHANNEL_FILTER_SIZE];
+  } filters;
+  struct
+  {
+    int16_t samples[ADC_BURST_LENGTH];
+    uint8_t missed[(ADC_BURST_LENGTH + 7) / 8];
+  } burst;
+} History; /* Filter histories of voltage and current and the burst samples */
+#if defined(ADC_BURST_SHARES_FILTERS) && ((2 * ADC_BURST_LENGTH + (ADC_BURST_LENGTH + 7) / 8) > (4 * (ADC_V_CHANNEL_FILTER_SIZE + ADC_I_CHANNEL_FILTER_SIZE)))
+  #error Burst samples do not fit in the filter histories
+#endif
+static int32_t TemperatureFilterData[ADC_T_CHANNEL_FILTER_SIZE];
+static Filter_Data Filters[ADC_CHANNEL_COUNT] = {{History.filters.voltage, ADC_V_CHANNEL_FILTER_SIZE},
+                                                  {History.filters.current, ADC_I_CHANNEL_FILTER_SIZE},
+                                                  {TemperatureFilterData, ADC_T_CHANNEL_FILTER_SIZE}};
+static ADC_Burst Burst;
+static uint16_t BurstSlot; /* Sample of the burst whose result is being read */
+static bool ResultIsBurstSample; /* The requested result belongs to the burst */
 
 /* </Module variables> */ 
 
@@ -39,30 +66,28 @@ static ADC_TriangleFilterData Filters[ADC_CHANNEL_COUNT] = {VoltageFilter, Curre
 /* <Declarations (prototypes)> */ 
 
 /**
- * Adds a value to the triangle filter
- * 
- * @param value - new value to add
- * @param filter - pointer to triangle filter data
+ * Selects the channel of the next conversion
+ * Voltage and current are interleaved by their weights, temperature is inserted every ADC_T_CHANNEL_PERIOD conversions
+ *
+ * @return - ADC channel
  */
-void TriangleFilter_Add(int32_t value, ADC_TriangleFilterData * filter);
+uint8_t ADC_NextChannel(void);
 
 /**
- * Gets filtered value with triangle-weighted filter
- * 
- * @param filter - pointer to triangle filter data
+ * Handles a finished conversion of the burst: reads it or marks it as missed, stops the burst after the last sample
  *
- * @return - filtered value if filter is valid, last value otherwise
+ * @param nextChannel - channel that is measured after the burst
  */
-int32_t TriangleFilter_GetValue(ADC_TriangleFilterData * filter);
+void ADC_BurstConversionReady(uint8_t nextChannel);
 
 /**
- * Gets the last added value to the filter
- * 
- * @param filter - pointer to triangle filter data
+ * Tells whether the filter history of a channel holds the burst samples
  *
- * @return - last value (unfiltered)
+ * @param channel - ADC channel
+ *
+ * @return - True if the filter of the channel cannot be used
  */
-int32_t TriangleFilter_GetUnfilteredValue(ADC_TriangleFilterData * filter);
+bool ADC_IsFilterHeldByBurst(uint8_t channel);
 
 /* </Declarations (prototypes)> */ 
 
@@ -99,109 +124,162 @@ void ADC_Init(void)
   ChannelIsFiltered[ADC_I] = true;
   ChannelIsFiltered[ADC_T] = false;
 
-  ChannelSkipRatio[ADC_V] = ADC_V_CHANNEL_SKIP_RATIO;
-  ChannelSkipRatio[ADC_I] = ADC_I_CHANNEL_SKIP_RATIO;
-  ChannelSkipRatio[ADC_T] = ADC_T_CHANNEL_SKIP_RATIO;
-
-  ChannelCycleCounter[ADC_V] = 0;
-  ChannelCycleCounter[ADC_I] = 0;
-  ChannelCycleCounter[ADC_T] = 0;
+  Filter_Setup(&Filters[ADC_V], Filter_Triangle, ADC_V_CHANNEL_FILTER_SIZE);
+  Filter_Setup(&Filters[ADC_I], Filter_Triangle, ADC_I_CHANNEL_FILTER_SIZE);
+  Filter_Setup(&Filters[ADC_T], Filter_Triangle, ADC_T_CHANNEL_FILTER_SIZE);
+
+  ModeWeights.voltage = ADC_DEFAULT_WEIGHT;
+  ModeWeights.current = ADC_DEFAULT_WEIGHT;
+  HostWeights.voltage = 0;
+  HostWeights.current = 0;
+  VoltageCredit = 0;
+  CurrentCredit = 0;
+  ConversionsSinceTemperature = 0;
   
   int16_t i;
   for (i = 0; i < ADC_CHANNEL_COUNT; i++)
   {
-    Voltages[i].milliseconds = 0;
-    Voltages[i].counter = 0;
-    Voltages[i].value = 0;
-    Voltages[i].unfilteredValue = 0;
+    Data_Clear(&(Voltages[i]));
     ADCError[i].errorCounter = 0;
     ADCError[i].error = ErrorMessaging_ADC_Overload;
+    SampleCounts[i] = 0;
+    SampleRates[i] = 0;
   }
+  RateWindowStart = millis();
+  Burst.samples = History.burst.samples;
+  Burst.missed = History.burst.missed;
+  Burst.state = Burst_Idle;
+  Burst.length = 0;
+  Burst.count = 0;
+  Burst.missedSamples = 0;
+  ResultIsBurstSample = false;
   
   ADS1x15_Init();
+  ConvertingRange = ChannelSettings[0].range;
   ADS1x15_StartConversion(ChannelSettings[0]); /* Start conversion of the first channel */
   LastUpdate = millis();  
 }
 
 void ADC_Do(void) /* Call periodically */
 {
-  static uint8_t i = 0; /* Channel iterator */
+  static uint8_t i = 0; /* Channel iterator, channel of the conversion in progress */
   static bool repeatedConversion = false;
-  static int16_t rawResult;  
+  static uint8_t readChannel; /* Channel of the result being read */
+  static ADS1x15_Ranges readRange; /* Range of the result being read */
   
-  if (ADS1x15_ConversionReady())
+  if (ADS1x15_ConversionReady() && (Burst.state == Burst_Capturing))
+  {
+    PROFILER_ADD(Probe_ADCLatency, micros() - ADS1x15_GetConversionTime());
+    repeatedConversion = false;
+    LastUpdate = millis();
+    ADC_BurstConversionReady(i);
+  }
+  else if (ADS1x15_ConversionReady())
   {
+    PROFILER_ADD(Probe_ADCLatency, micros() - ADS1x15_GetConversionTime());
     repeatedConversion = false;
-    rawResult = ADS1x15_GetRawResult();    
-    int32_t result = ADS1x15_Voltage(rawResult, ChannelSettings[i].range); /* Get the new voltage */         
+    readChannel = i;
+    readRange = ConvertingRange;
+    LastUpdate = millis();
+
+    i = ADC_NextChannel();
+    
+    if (Burst.state == Burst_Starting)
+    {
+      ADS1x15_ChannelSetting burstSetting = {ChannelSettings[Burst.channel].input, ADC_BURST_RANGE, ADC_BURST_DATA_RATE, false};
+      Burst.state = Burst_Capturing;
+      ADS1x15_StartContinuous(burstSetting); /* The burst converts while this result is read, the next channel waits for the end of the burst */
+    }
+    else
+    {
+      ConvertingRange = ChannelSettings[i].range;
+      ADS1x15_StartConversion(ChannelSettings[i]); /* The next channel converts while this result is read and processed */
+    }
+    ResultIsBurstSample = false;
+    ADS1x15_RequestResult(); /* The conversion register keeps the finished result until the next conversion is finished */
+  }
+
+  if (ADS1x15_ResultReady() && ResultIsBurstSample)
+  {
+    Burst.samples[BurstSlot] = ADS1x15_GetRawResult();
+  }
+  else if (ADS1x15_ResultReady())
+  {
+    uint8_t channel = readChannel;
+    Data_Filtered<int32_t> voltage;
+    int16_t rawResult = ADS1x15_GetRawResult();
+    int32_t result = ADS1x15_Voltage(rawResult, readRange); /* Get the new voltage */         
     
+    if (ChannelSettings[channel].autorange) /* Autoranging, if enabled */
+    {
+      ADS1x15_AutoRange(rawResult, &(ChannelSettings[channel].range));
+    }
+    else /* Default range, if autoranging is disabled */
+    {
+      ChannelSettings[channel].range = ADC_DEFAULT_RANGE;
+    }
+
     if ((result > ADC_ABSOLUTEMAXIMUM) || (result < -ADC_ABSOLUTEMAXIMUM))
     {
       /* ADC negative or positive overload */
-      ADCError[i].errorCounter++;
-      ADCError[i].error = ErrorMessaging_ADC_Overload;      
+      ErrorMessaging_Raise(&ADCError[channel], ErrorMessaging_ADC_Overload);      
     }
-    TriangleFilter_Add(result, &Filters[i]);
-    Voltages[i].unfilteredValue = TriangleFilter_GetUnfilteredValue(&Filters[i]);
-    if (ChannelIsFiltered[i])
+    if (ADC_IsFilterHeldByBurst(channel))
     {
-      Voltages[i].value = TriangleFilter_GetValue(&Filters[i]);
+      Filters[channel].lastValue = result; /* The filter restarts from the latest sample when the burst is released */
     }
     else
     {
-      Voltages[i].value = Voltages[i].unfilteredValue;
+      Filter_Add(&Filters[channel], result);
     }
-    
-    Voltages[i].milliseconds = millis();
-    Voltages[i].counter++;    
-
-    if (ChannelSettings[i].autorange) /* Autoranging, if enabled */
+    voltage.unfilteredValue = Filter_GetUnfilteredValue(&Filters[channel]);
+    if (ChannelIsFiltered[channel] && !ADC_IsFilterHeldByBurst(channel))
     {
-      ADS1x15_AutoRange(rawResult, &(ChannelSettings[i].range));
+      voltage.value = Filter_GetValue(&Filters[channel]);
     }
-    else /* Default range, if autoranging is disabled */
+    else
     {
-      ChannelSettings[i].range = ADC_DEFAULT_RANGE;
+      voltage.value = voltage.unfilteredValue;
     }
-    LastUpdate = millis();
-
-    do
-    {      
-      for (uint8_t j = 0; j < ADC_CHANNEL_COUNT; j++)
-      {
-        i++;
-        if (i == ADC_CHANNEL_COUNT) /* Wrap around the number of channels */
-        {
-          i = 0;
-        }
-        ChannelCycleCounter[i]++; /* Increase cycle number */
-
-        if ((ChannelCycleCounter[i] & ((1U << ChannelSkipRatio[i]) - 1U)) == 0) /* Try finding the next channel that is not skipped */
-        {
-          break;
-        }
-      }
-    } while ((ChannelCycleCounter[i] & ((1U << ChannelSkipRatio[i])) - 1U) > 0); /* Channel skipping */
     
-    ADS1x15_StartConversion(ChannelSettings[i]); /* Start converting the next channel */
+    Data_Publish(&(Voltages[channel]), voltage);
+    SampleCounts[channel]++;
+    PROFILER_SAMPLE(channel);
+    Events_Publish(EVENTS_ADC_SAMPLE(channel));
   }
   
   if ((millis() - LastUpdate) > ADC_TIMEOUT)
   {
+    PROFILER_MISSED_SAMPLE(i);
     if (repeatedConversion == false)
     {
       repeatedConversion = true;
       LastUpdate = millis();
+      if (Burst.state == Burst_Capturing)
+      {
+        Burst.state = Burst_Done; /* The burst ends with the samples captured so far */
+      }
+      ConvertingRange = ChannelSettings[i].range;
       ADS1x15_StartConversion(ChannelSettings[i]); /* Try repeating the last conversion */  
     }
     else
     {
       /* Error: ADC not responding */
-      ADCError[i].errorCounter++;
-      ADCError[i].error = ErrorMessaging_ADC_NotResponding;
+      ErrorMessaging_Raise(&ADCError[i], ErrorMessaging_ADC_NotResponding);
       repeatedConversion = false;
     }
   }
+
+  if ((millis() - RateWindowStart) >= ADC_RATE_WINDOW)
+  {
+    uint32_t window = millis() - RateWindowStart;
+    for (uint8_t j = 0; j < ADC_CHANNEL_COUNT; j++)
+    {
+      SampleRates[j] = (uint16_t)((SampleCounts[j] * 1000UL) / window);
+      SampleCounts[j] = 0;
+    }
+    RateWindowStart += window;
+  }
 }
 
 void ADC_SetupChannel(ADC_Channels adcChannel, ADC_RateRangingFilter rateRangingFilter)
@@ -221,63 +299,194 @@ const ErrorMessaging_Error * ADC_GetError(ADC_Channels adcChannel)
   return &(ADCError[adcChannel]);
 }
 
-void TriangleFilter_Add(int32_t value, ADC_TriangleFilterData * filter)
+const ADS1x15_ChannelSetting * ADC_GetChannelSetting(ADC_Channels adcChannel)
 {
-  filter->triangleSum -= filter->sum;
-  filter->sum -= (filter->data)[filter->index];
-  (filter->data)[filter->index] = value;
-  filter->triangleSum += value * (int32_t)(filter->filterSize);
-  filter->sum += value;
-  
-  filter->index++;
-  if (filter->index >= filter->filterSize)
+  return &(ChannelSettings[adcChannel]);
+}
+
+bool ADC_SetFilter(ADC_Channels adcChannel, Filter_Types type, uint8_t length)
+{
+  if ((adcChannel >= ADC_CHANNEL_COUNT) || ADC_IsFilterHeldByBurst(adcChannel))
   {
-    filter->index = 0;
-    filter->valid = true;
+    return false;
   }
+  return Filter_Setup(&(Filters[adcChannel]), type, length);
 }
 
-int32_t TriangleFilter_GetValue(ADC_TriangleFilterData * filter)
+const Filter_Data * ADC_GetFilter(ADC_Channels adcChannel)
 {
-  if (filter->valid)
-  {  
-    int32_t totalWeight = ((int32_t)(filter->filterSize) * ((int32_t)(filter->filterSize) + 1)) / 2;
-    return ((int32_t)(filter->triangleSum) + totalWeight / 2) / totalWeight;
+  return &(Filters[adcChannel]);
+}
+
+bool ADC_IsChannelFiltered(ADC_Channels adcChannel)
+{
+  return ChannelIsFiltered[adcChannel] && !ADC_IsFilterHeldByBurst(adcChannel);
+}
+
+bool ADC_IsSampleReady(void)
+{
+  return ADS1x15_ConversionReady() || ADS1x15_ResultReady();
+}
+
+bool ADC_StartBurst(ADC_Channels adcChannel, uint16_t length)
+{
+  if (((adcChannel != ADC_V) && (adcChannel != ADC_I)) || (length == 0) || (length > ADC_BURST_LENGTH) || 
+      (Burst.state == Burst_Starting) || (Burst.state == Burst_Capturing))
+  {
+    return false;
+  }
+  Burst.channel = adcChannel;
+  Burst.length = length;
+  Burst.count = 0;
+  Burst.missedSamples = 0;
+  memset(Burst.missed, 0, (ADC_BURST_LENGTH + 7) / 8);
+  Burst.firstTime = 0;
+  Burst.lastTime = 0;
+  Burst.state = Burst_Starting; /* Continuous conversions start when the conversion in progress is finished */
+  return true;
+}
+
+const ADC_Burst * ADC_GetBurst(void)
+{
+  return &Burst;
+}
+
+bool ADC_IsBurstSampleMissed(uint16_t index)
+{
+  return (Burst.missed[index >> 3] & (1 << (index & 7))) != 0;
+}
+
+void ADC_ReleaseBurst(void)
+{
+  if (Burst.state != Burst_Done)
+  {
+    return;
+  }
+  Burst.state = Burst_Idle;
+  Burst.length = 0;
+  Burst.count = 0;
+  Burst.missedSamples = 0;
+#ifdef ADC_BURST_SHARES_FILTERS
+  Filter_Reset(&(Filters[ADC_V]));
+  Filter_Reset(&(Filters[ADC_I]));
+#endif
+}
+
+bool ADC_SetWeights(ADC_WeightSources source, uint8_t voltageWeight, uint8_t currentWeight)
+{
+  if ((source == Weights_Host) && (voltageWeight == 0) && (currentWeight == 0))
+  {
+    HostWeights.voltage = 0; /* Return to the mode weights */
+    HostWeights.current = 0;
+  }
+  else if ((voltageWeight == 0) || (currentWeight == 0) || (voltageWeight > ADC_WEIGHT_MAXIMUM) || (currentWeight > ADC_WEIGHT_MAXIMUM))
+  {
+    return false;
+  }
+  else if (source == Weights_Host)
+  {
+    HostWeights.voltage = voltageWeight;
+    HostWeights.current = currentWeight;
+  }
+  else
+  {
+    ModeWeights.voltage = voltageWeight;
+    ModeWeights.current = currentWeight;
+  }
+  VoltageCredit = 0;
+  CurrentCredit = 0;
+  return true;
+}
+
+const ADC_ChannelWeights * ADC_GetWeights(void)
+{
+  return (ADC_GetWeightSource() == Weights_Host) ? &HostWeights : &ModeWeights;
+}
+
+ADC_WeightSources ADC_GetWeightSource(void)
+{
+  return (HostWeights.voltage > 0) ? Weights_Host : Weights_Mode;
+}
+
+uint16_t ADC_GetSampleRate(ADC_Channels adcChannel)
+{
+  return SampleRates[adcChannel];
+}
+
+uint8_t ADC_NextChannel(void)
+{
+  const ADC_ChannelWeights * weights = ADC_GetWeights();
+
+  ConversionsSinceTemperature++;
+  if (ConversionsSinceTemperature >= ADC_T_CHANNEL_PERIOD)
+  {
+    ConversionsSinceTemperature = 0;
+    return ADC_T;
+  }
+
+  /* Each channel gains its weight, the chosen one pays the sum of the weights */
+  VoltageCredit += weights->voltage;
+  CurrentCredit += weights->current;
+  if (CurrentCredit > VoltageCredit)
+  {
+    CurrentCredit -= weights->voltage + weights->current;
+    return ADC_I;
   }
   else
   {
-    return TriangleFilter_GetUnfilteredValue(filter);
+    VoltageCredit -= weights->voltage + weights->current;
+    return ADC_V;
   }
 }
 
-int32_t TriangleFilter_GetUnfilteredValue(ADC_TriangleFilterData * filter)
+void ADC_BurstConversionReady(uint8_t nextChannel)
 {
-  if (filter->index > 0)
+  uint32_t time = ADS1x15_GetConversionTime();
+
+  ADS1x15_ClearConversionReady();
+  if (Burst.count >= Burst.length) /* The last sample was read, return to single conversions of the channels in turn */
+  {
+    Burst.state = Burst_Done;
+    ConvertingRange = ChannelSettings[nextChannel].range;
+    ADS1x15_StartConversion(ChannelSettings[nextChannel]);
+    return;
+  }
+
+  if (Burst.count == 0)
   {
-    return (filter->data)[filter->index - 1];
+    Burst.firstTime = time;
+  }
+  Burst.lastTime = time;
+  if (ADS1x15_ResultPending()) /* The previous result was not read yet, the conversion register already holds this one */
+  {
+    Burst.samples[Burst.count] = 0;
+    Burst.missed[Burst.count >> 3] |= (1 << (Burst.count & 7));
+    Burst.missedSamples++;
   }
   else
   {
-    return (filter->data)[filter->filterSize - 1];
+    BurstSlot = Burst.count;
+    ResultIsBurstSample = true;
+    ADS1x15_RequestNextResult(); /* The register pointer stays at the conversion register */
   }
+  Burst.count++;
 }
 
 void ADC_ResetFilter(ADC_Channels adcChannel)
 {
-  if (adcChannel < ADC_CHANNEL_COUNT)
+  if ((adcChannel < ADC_CHANNEL_COUNT) && !ADC_IsFilterHeldByBurst(adcChannel)) /* A held filter is reset when the burst is released */
   {
-      ADC_TriangleFilterData * filter = &(Filters[adcChannel]);
-      int32_t lastValue = TriangleFilter_GetUnfilteredValue(filter);
-      
-      // Reset filter
-      filter->index = 0;
-      filter->sum = 0;
-      filter->triangleSum = 0;
-      filter->valid = false;
-      memset(filter->data, 0, filter->filterSize * sizeof(int32_t));
-
-      TriangleFilter_Add(lastValue, filter); // add the last value
-   }
+    Filter_Reset(&(Filters[adcChannel]));
+  }
+}
+
+bool ADC_IsFilterHeldByBurst(uint8_t channel)
+{
+#ifdef ADC_BURST_SHARES_FILTERS
+  return (channel != ADC_T) && (Burst.state != Burst_Idle);
+#else
+  return false;
+#endif
 }
 
 /* </Implementations> */ 
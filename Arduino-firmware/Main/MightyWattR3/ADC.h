@@ -13,6 +13,7 @@
  
 #include "MightyWatt.h"
 #include "ADS1x15.h"
+#include "Filter.h"
 #include "Data.h"
 #include "ErrorMessaging.h"
 #include "Configuration.h"
@@ -34,15 +35,36 @@
 #define ADC_I_CHANNEL                ADS1x15_AIN1AIN3
 #define ADC_T_CHANNEL                ADS1x15_AIN0AIN3
 
-/* ADC triangle filter */
-#define ADC_V_CHANNEL_FILTER_SIZE    42
-#define ADC_I_CHANNEL_FILTER_SIZE    42
+/* ADC filter history (samples), channels start with the triangle filter over the whole history */
+#ifdef UNO
+  #define ADC_V_CHANNEL_FILTER_SIZE  24
+  #define ADC_I_CHANNEL_FILTER_SIZE  24
+#elif defined(ZERO)
+  #define ADC_V_CHANNEL_FILTER_SIZE  42
+  #define ADC_I_CHANNEL_FILTER_SIZE  42
+#endif
 #define ADC_T_CHANNEL_FILTER_SIZE    1
 
-/* ADC cycle skipping */
-#define ADC_V_CHANNEL_SKIP_RATIO     0  /* No ADC cycle skipping */
-#define ADC_I_CHANNEL_SKIP_RATIO     0  /* No ADC cycle skipping */
-#define ADC_T_CHANNEL_SKIP_RATIO     7  /* Measure only ever 2**7 = 128th cycle */
+/* ADC channel scheduling */
+#define ADC_T_CHANNEL_SKIP_RATIO     8  /* Measure temperature after every 2**8 = 256th voltage or current conversion */
+#define ADC_T_CHANNEL_PERIOD         (1U << ADC_T_CHANNEL_SKIP_RATIO)
+#define ADC_DEFAULT_WEIGHT           1  /* Voltage and current are measured in turn */
+#define ADC_WEIGHT_MAXIMUM           15 /* Maximum weight of a channel */
+#define ADC_RATE_WINDOW              1000 /* ms, achieved sample rates are calculated over this window */
+
+/* Burst capture */
+#ifdef UNO
+  #define ADC_BURST_LENGTH           88 /* Maximum number of samples of a burst, samples and missed flags fit in the voltage and current filter histories */
+  #define ADC_BURST_SHARES_FILTERS   /* No RAM for a separate burst buffer, voltage and current are not filtered while a burst holds the samples */
+#elif defined(ZERO)
+  #define ADC_BURST_LENGTH           1024 /* Maximum number of samples of a burst, 2 bytes of RAM each */
+#endif
+#define ADC_BURST_RANGE              ADS1x15_PGA4096 /* Widest range, transients must not clip */
+#ifdef ADC_TYPE_ADS1015
+  #define ADC_BURST_DATA_RATE        ADS1015_3300SPS
+#elif defined(ADC_TYPE_ADS1115)
+  #define ADC_BURST_DATA_RATE        ADS1115_860SPS
+#endif
 
 /* </Defines> */ 
 
@@ -59,6 +81,26 @@ enum ADC_Channels
   ADC_T,
 };
 
+/**
+ * State of the burst capture
+ */
+enum ADC_BurstStates : uint8_t
+{
+  Burst_Idle, /* no burst samples, none was captured since reset or they were released */
+  Burst_Starting, /* waiting for the conversion in progress, then the continuous conversions start */
+  Burst_Capturing, /* continuous conversions of the burst channel, the other channels are not measured */
+  Burst_Done /* samples are complete, or there are fewer of them if the ADC stopped responding */
+};
+
+/**
+ * Sources of the voltage and current channel weights
+ */
+enum ADC_WeightSources : uint8_t
+{
+  Weights_Mode, /* set by the control mode */
+  Weights_Host /* set by the host, override the mode weights */
+};
+
 /* </Enums> */ 
 
 
@@ -71,14 +113,29 @@ struct ADC_RateRangingFilter
   bool filter;
 };
 
-struct ADC_TriangleFilterData
+/**
+ * Shares of the voltage and current conversions, temperature is measured every ADC_T_CHANNEL_PERIOD conversions regardless of them
+ */
+struct ADC_ChannelWeights
+{
+  uint8_t voltage;
+  uint8_t current;
+};
+
+/**
+ * Samples of one channel captured at the full data rate
+ */
+struct ADC_Burst
 {
-  const uint16_t filterSize;
-  int32_t * data;
-  int16_t index;
-  int32_t sum;
-  int32_t triangleSum;
-  bool valid;
+  ADC_BurstStates state;
+  ADC_Channels channel;
+  uint16_t length; /* Number of requested samples */
+  uint16_t count; /* Number of captured samples, missed ones included */
+  uint16_t missedSamples; /* Conversions that finished before the previous one was read */
+  uint32_t firstTime; /* micros() of the first conversion */
+  uint32_t lastTime; /* micros() of the last conversion */
+  int16_t * samples; /* ADC_BURST_LENGTH raw results in ADC_BURST_RANGE, a missed sample keeps its slot so the samples stay evenly spaced */
+  uint8_t * missed; /* Bit i is set if sample i was missed, every raw value is a valid result */
 };
 
 /* </Structs> */ 
@@ -121,6 +178,122 @@ const TSCADCLong * ADC_GetVoltage(ADC_Channels adcChannel);
  */
 const ErrorMessaging_Error * ADC_GetError(ADC_Channels adcChannel);
 
+/**
+ * Returns the present input, range, data rate and autoranging of a channel
+ *
+ * @param adcChannel - ADC channel
+ *
+ * @return - Pointer to the channel setting
+ */
+const ADS1x15_ChannelSetting * ADC_GetChannelSetting(ADC_Channels adcChannel);
+
+/**
+ * Selects the filter of a channel, the filter starts again from the last value
+ * The filter is used when the channel is filtered (ADC_SetupChannel)
+ *
+ * @param adcChannel - ADC channel
+ * @param type - filter type
+ * @param length - filter length, see Filter_Setup; limited by the channel filter size
+ *
+ * @return - True if the filter was set, false if it is invalid for the channel
+ */
+bool ADC_SetFilter(ADC_Channels adcChannel, Filter_Types type, uint8_t length);
+
+/**
+ * Returns the filter of a channel
+ *
+ * @param adcChannel - ADC channel
+ *
+ * @return - Pointer to the filter data
+ */
+const Filter_Data * ADC_GetFilter(ADC_Channels adcChannel);
+
+/**
+ * Returns whether the channel values are filtered
+ *
+ * @param adcChannel - ADC channel
+ *
+ * @return - True if filter is used
+ */
+bool ADC_IsChannelFiltered(ADC_Channels adcChannel);
+
+/**
+ * Returns whether a finished conversion or a read result waits for ADC_Do
+ * Cheap enough to be checked between any two tasks
+ *
+ * @return - True if ADC_Do has a new sample to process
+ */
+bool ADC_IsSampleReady(void);
+
+/**
+ * Starts a burst capture: continuous conversions of one channel at ADC_BURST_DATA_RATE into the burst buffer, then the channels are measured in turn again
+ * The voltage, current and temperature are not updated during the burst
+ *
+ * @param adcChannel - ADC_V or ADC_I
+ * @param length - number of samples, 1 to ADC_BURST_LENGTH
+ *
+ * @return - True if the burst was started, false if the arguments are invalid or another burst is in progress
+ */
+bool ADC_StartBurst(ADC_Channels adcChannel, uint16_t length);
+
+/**
+ * Returns the state and samples of the last burst
+ *
+ * @return - Pointer to the burst
+ */
+const ADC_Burst * ADC_GetBurst(void);
+
+/**
+ * Tells whether a burst sample was missed
+ *
+ * @param index - index of the sample, less than the captured count
+ *
+ * @return - True if the conversion finished before the previous one was read and the sample holds no result
+ */
+bool ADC_IsBurstSampleMissed(uint16_t index);
+
+/**
+ * Releases the samples of a finished burst after they were sent, the burst returns to idle
+ * With ADC_BURST_SHARES_FILTERS the voltage and current filters restart with the next samples
+ */
+void ADC_ReleaseBurst(void);
+
+/**
+ * Sets the weights of the voltage and current channels
+ * A channel with weight 3 is converted three times while a channel with weight 1 is converted once, the conversions are interleaved evenly
+ *
+ * @param source - Weights_Mode or Weights_Host
+ * @param voltageWeight - weight of the voltage channel, 1 to ADC_WEIGHT_MAXIMUM
+ * @param currentWeight - weight of the current channel, 1 to ADC_WEIGHT_MAXIMUM
+ *                        both weights 0 clear the host weights so that the mode weights are used again
+ *
+ * @return - True if the weights were set, false if they are invalid
+ */
+bool ADC_SetWeights(ADC_WeightSources source, uint8_t voltageWeight, uint8_t currentWeight);
+
+/**
+ * Returns the weights the channels are scheduled by
+ *
+ * @return - Pointer to the host weights if they are set, to the mode weights otherwise
+ */
+const ADC_ChannelWeights * ADC_GetWeights(void);
+
+/**
+ * Returns which weights the channels are scheduled by
+ *
+ * @return - Weights_Host if the host weights are set, Weights_Mode otherwise
+ */
+ADC_WeightSources ADC_GetWeightSource(void);
+
+/**
+ * Returns the achieved sample rate of a channel
+ *
+ * @param adcChannel - ADC channel
+ *
+ * @return - Samples per second in the last ADC_RATE_WINDOW
+ */
+uint16_t ADC_GetSampleRate(ADC_Channels adcChannel);
+
 /**
  * Resets raw voltage filter for given channel
  * Useful when physical range is switched and the values in filter are from an old range
@@ -12,14 +12,20 @@
 
 #include "Arduino.h"
 #include "ADS1x15.h"
-#include <Wire.h>
+#include "Profiler.h"
+#include "I2C.h"
+#include "FastPin.h"
 
 /* </Includes> */ 
 
 
 /* <Module variables> */ 
 
-static bool conversionReady = false;
+static volatile bool conversionReady = false; /* Set by the interrupt, cleared by the main loop */
+static volatile uint32_t conversionTime; /* micros() when the conversion was finished */
+static volatile bool resultReady = false; /* Set by the I2C callback, cleared by the main loop */
+static volatile bool resultPending = false; /* Set when a result is requested, cleared when it is taken or its read failed */
+static volatile int16_t rawResult = 0; /* the ADS1x15 is bipolar */
 static ErrorMessaging_Error ADS1x15Error;
 
 /* </Module variables> */ 
@@ -28,20 +34,34 @@ static ErrorMessaging_Error ADS1x15Error;
 /* <Declarations (prototypes)> */ 
 
 /**
- * Sends a 16-bit word to ADS1x15
+ * Queues a write of a 16-bit word to ADS1x15
  * 
  * @param reg - Register to which to write
  * @param data - Payload
+ * @param done - function called when the write is finished, may be NULL
  */
-void ADS1x15_Send(ADS1x15_Registers reg, uint16_t data);
+void ADS1x15_Send(ADS1x15_Registers reg, uint16_t data, void (* done)(const I2C_Transaction * transaction));
 
 /**
- * Reads a 16-bit word from ADS1x15
- * @param reg - Register from which to read 
- * 
- * @return Register value
+ * Drops conversion ready flags that came before the new configuration was written, called from the I2C interrupt
+ * Continuous conversions may finish while the configuration that stops them waits for the bus
+ *
+ * @param transaction - finished transaction
+ */
+void ADS1x15_ConfigWritten(const I2C_Transaction * transaction);
+
+/**
+ * Stores the result read from the conversion register, called from the I2C interrupt
+ *
+ * @param transaction - finished transaction
  */
-uint16_t ADS1x15_Read(ADS1x15_Registers reg);
+void ADS1x15_ResultRead(const I2C_Transaction * transaction);
+
+/**
+ * Handles the interrupt of the ALERT/RDY pin
+ * The bus is not accessed here, the result is read and the next conversion is started by ADC_Do
+ */
+void ADS1x15_ReadyInterrupt(void);
 
 /* </Declarations (prototypes)> */ 
 
@@ -51,40 +71,101 @@ uint16_t ADS1x15_Read(ADS1x15_Registers reg);
 void ADS1x15_Init(void)
 {
   pinMode(ADS1x15_READY_PIN, INPUT);
-  ADS1x15_Send(ADS1x15_HiThresholdRegister, ADS1x15_HI_THRESH);
-  ADS1x15_Send(ADS1x15_LoThresholdRegister, ADS1x15_LO_THRESH);  
+  ADS1x15_Send(ADS1x15_HiThresholdRegister, ADS1x15_HI_THRESH, NULL);
+  ADS1x15_Send(ADS1x15_LoThresholdRegister, ADS1x15_LO_THRESH, NULL);  
+  #ifdef UNO
+    /* Pin 11 has no external interrupt, pin change interrupt is used instead */
+    *digitalPinToPCMSK(ADS1x15_READY_PIN) |= _BV(digitalPinToPCMSKbit(ADS1x15_READY_PIN));
+    *digitalPinToPCICR(ADS1x15_READY_PIN) |= _BV(digitalPinToPCICRbit(ADS1x15_READY_PIN));
+  #elif defined(ZERO)
+    attachInterrupt(digitalPinToInterrupt(ADS1x15_READY_PIN), &ADS1x15_ReadyInterrupt, FALLING);
+  #endif
   ADS1x15Error.errorCounter = 0;
   ADS1x15Error.error = ErrorMessaging_ADS1x15_ResultNotReady;
+  conversionReady = false;
+  resultReady = false; /* A read dropped by I2C_Init does not finish */
+  resultPending = false;
 }
 
 void ADS1x15_StartConversion(ADS1x15_ChannelSetting channelSetting)
 { 
   conversionReady = false;
-  ADS1x15_Send(ADS1x15_ConfigRegister, channelSetting.range | channelSetting.input | channelSetting.dataRate | ADS1x15_OS_BEGIN_CONVERSION | ADS1x15_MODE_SINGLE_SHOT | ADS1x15_COMP_LAT_LATCHING | ADS1x15_COMP_MODE_WINDOW);
+  ADS1x15_Send(ADS1x15_ConfigRegister, channelSetting.range | channelSetting.input | channelSetting.dataRate | ADS1x15_OS_BEGIN_CONVERSION | ADS1x15_MODE_SINGLE_SHOT | ADS1x15_COMP_LAT_LATCHING | ADS1x15_COMP_MODE_WINDOW, &ADS1x15_ConfigWritten);
+}
+
+void ADS1x15_StartContinuous(ADS1x15_ChannelSetting channelSetting)
+{ 
+  conversionReady = false;
+  ADS1x15_Send(ADS1x15_ConfigRegister, channelSetting.range | channelSetting.input | channelSetting.dataRate | ADS1x15_COMP_LAT_LATCHING | ADS1x15_COMP_MODE_WINDOW, &ADS1x15_ConfigWritten);
 }
 
 bool ADS1x15_ConversionReady(void)
 {
-  if (!conversionReady)
-  {    
-    conversionReady = (digitalRead(ADS1x15_READY_PIN) == LOW);
-  }
   return conversionReady;
 }
 
+void ADS1x15_ClearConversionReady(void)
+{
+  conversionReady = false;
+}
+
+void ADS1x15_RequestResult(void)
+{
+  uint8_t reg = ADS1x15_ConversionRegister;
+
+  resultReady = false;
+  resultPending = true;
+  PROFILER_BEGIN();
+  if (!I2C_Queue(ADS1x15_ADDRESS, &reg, 1, 2, &ADS1x15_ResultRead))
+  {
+    resultPending = false; /* The result is requested again with the next conversion */
+  }
+  PROFILER_END(Probe_ADS1x15Read);
+}
+
+void ADS1x15_RequestNextResult(void)
+{
+  resultReady = false;
+  resultPending = true;
+  PROFILER_BEGIN();
+  if (!I2C_Queue(ADS1x15_ADDRESS, NULL, 0, 2, &ADS1x15_ResultRead))
+  {
+    resultPending = false; /* The result is requested again with the next conversion */
+  }
+  PROFILER_END(Probe_ADS1x15Read);
+}
+
+bool ADS1x15_ResultPending(void)
+{
+  return resultPending;
+}
+
+bool ADS1x15_ResultReady(void)
+{
+  return resultReady;
+}
+
+uint32_t ADS1x15_GetConversionTime(void)
+{
+  uint32_t time;
+
+  noInterrupts(); /* 32-bit read is not atomic on 8-bit MCU */
+  time = conversionTime;
+  interrupts();
+  return time;
+}
+
 int16_t ADS1x15_GetRawResult(void)
 {
-  static int16_t rawResult = 0; /* the ADS1x15 is bipolar */
-  if (conversionReady) /* update raw result if conversion ready */
+  if (resultReady)
   {
-    conversionReady = false; 
-    rawResult = (int16_t)ADS1x15_Read(ADS1x15_ConversionRegister);
+    resultReady = false; 
+    resultPending = false;
   }
   else
   {
     /* Requested result but ADC is not ready */
-    ADS1x15Error.errorCounter++;
-    ADS1x15Error.error = ErrorMessaging_ADS1x15_ResultNotReady;    
+    ErrorMessaging_Raise(&ADS1x15Error, ErrorMessaging_ADS1x15_ResultNotReady);
   }
   return rawResult; /* Result is left-aligned */
 }
@@ -169,29 +250,34 @@ void ADS1x15_AutoRange(int16_t rawResult, ADS1x15_Ranges * range)
   }
 }
 
-void ADS1x15_Send(ADS1x15_Registers reg, uint16_t data)
+void ADS1x15_Send(ADS1x15_Registers reg, uint16_t data, void (* done)(const I2C_Transaction * transaction))
 {
-  Wire.beginTransmission(ADS1x15_ADDRESS);  
-  Wire.write(reg & 0xFF);
-  Wire.write((data >> 8) & 0xFF); /* MSB first */
-  Wire.write(data & 0xFF); 
-  Wire.endTransmission();
+  uint8_t bytes[3];
+
+  bytes[0] = reg & 0xFF;
+  bytes[1] = (data >> 8) & 0xFF; /* MSB first */
+  bytes[2] = data & 0xFF;
+  PROFILER_BEGIN();
+  I2C_Queue(ADS1x15_ADDRESS, bytes, 3, 0, done);
+  PROFILER_END(Probe_ADS1x15Send);
 }
 
-uint16_t ADS1x15_Read(ADS1x15_Registers reg)
+void ADS1x15_ResultRead(const I2C_Transaction * transaction)
 {
-  /* set read register */
-  Wire.beginTransmission(ADS1x15_ADDRESS);
-  Wire.write(reg & 0xFF);
-  Wire.endTransmission();
+  if (transaction->status == I2C_Done)
+  {
+    rawResult = (int16_t)((transaction->readData[0] << 8) | transaction->readData[1]); /* MSB first */
+    resultReady = true;
+  }
+  else
+  {
+    resultPending = false;
+  }
+}
 
-  /* read from the register */
-  Wire.requestFrom(ADS1x15_ADDRESS, 2);
-  while(Wire.available() == 0) {}
-  uint16_t value;
-  value = (Wire.read() << 8); /* MSB first */
-  value |= Wire.read();
-  return value;
+void ADS1x15_ConfigWritten(const I2C_Transaction * transaction)
+{
+  conversionReady = false;
 }
 
 const ErrorMessaging_Error * ADS1x15_GetError(void)
@@ -199,4 +285,29 @@ const ErrorMessaging_Error * ADS1x15_GetError(void)
   return &ADS1x15Error;
 }
 
+void ADS1x15_ReadyInterrupt(void)
+{
+  #ifdef UNO
+    /* Pin change interrupt fires on both edges. A pulse of the continuous mode (8 us) may be over before the interrupt runs,
+       a high pin that was high also in the previous interrupt means that such a pulse was missed. */
+    static bool pinLow = false;
+    bool wasLow = pinLow;
+
+    pinLow = !FastPin_Read<ADS1x15_READY_PIN>();
+    if (wasLow && !pinLow) /* Rising edge of a conversion already flagged */
+    {
+      return;
+    }
+  #endif
+  conversionTime = micros();
+  conversionReady = true;
+}
+
+#ifdef UNO
+ISR(ADS1x15_READY_VECTOR)
+{
+  ADS1x15_ReadyInterrupt();
+}
+#endif
+
 /* </Implementations> */ 
@@ -27,7 +27,15 @@
 #define ADS1x15_NEGATIVE_OVERLOAD   -32768
 
 #define ADS1x15_ADDRESS             0b01001000
-#define ADS1x15_READY_PIN           11
+#define ADS1x15_READY_PIN           11 /* ALERT/RDY, low when a conversion is finished */
+
+/* Conversion ready interrupt */
+#ifdef UNO
+  #define ADS1x15_READY_VECTOR      PCINT0_vect /* pin change interrupt of pins 8 to 13 */
+  #if (ADS1x15_READY_PIN < 8) || (ADS1x15_READY_PIN > 13)
+    #error ADS1x15_READY_VECTOR does not match ADS1x15_READY_PIN
+  #endif
+#endif
 
 #define ADS1x15_HI_THRESH           0x8000
 #define ADS1x15_LO_THRESH           0
@@ -152,19 +160,66 @@ struct ADS1x15_ChannelSetting
 void ADS1x15_Init(void);
 
 /**
- * Start a single conversion 
+ * Start a single conversion, the configuration is queued on the I2C bus
  *
  * @param channelSetting - structure with input, range and dataRate
  */
 void ADS1x15_StartConversion(ADS1x15_ChannelSetting channelSetting);
 
+/**
+ * Starts continuous conversions of one channel, the configuration is queued on the I2C bus
+ * Every finished conversion is flagged like a single conversion, ADS1x15_StartConversion returns to single conversions
+ *
+ * @param channelSetting - structure with input, range and dataRate
+ */
+void ADS1x15_StartContinuous(ADS1x15_ChannelSetting channelSetting);
+
 /**
  * Returns whether conversion is ready and can be read
+ * The flag is set by the interrupt of the ALERT/RDY pin, this function does not access the pin or the bus
  *
  * @return - True if result is ready, false otherwise
  */
 bool ADS1x15_ConversionReady(void);
 
+/**
+ * Clears the conversion ready flag of a continuous conversion, a single conversion clears it by starting the next one
+ */
+void ADS1x15_ClearConversionReady(void);
+
+/**
+ * Returns the time when the last conversion was finished
+ *
+ * @return - micros() captured by the interrupt of the ALERT/RDY pin
+ */
+uint32_t ADS1x15_GetConversionTime(void);
+
+/**
+ * Queues reading of the finished conversion
+ * The next conversion can be started before this, the conversion register keeps the result until the next conversion is finished
+ */
+void ADS1x15_RequestResult(void);
+
+/**
+ * Queues reading of the finished conversion without setting the register pointer
+ * Saves the pointer write of ADS1x15_RequestResult, valid only if no other register was accessed since the last ADS1x15_RequestResult
+ */
+void ADS1x15_RequestNextResult(void);
+
+/**
+ * Returns whether a requested result was not taken yet
+ *
+ * @return - True if a result read is queued or the read result waits for ADS1x15_GetRawResult, false otherwise
+ */
+bool ADS1x15_ResultPending(void);
+
+/**
+ * Returns whether the result requested by ADS1x15_RequestResult was read
+ *
+ * @return - True if result was read and can be taken by ADS1x15_GetRawResult, false otherwise
+ */
+bool ADS1x15_ResultReady(void);
+
 /**
  * Returns the raw read value from the ADC
  *
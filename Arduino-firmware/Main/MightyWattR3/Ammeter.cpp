@@ -16,6 +16,7 @@
 #include "DACC.h"
 #include "RangeSwitcher.h"
 #include "Control.h"
+#include "Events.h"
 
 /* </Includes> */ 
 
@@ -38,11 +39,8 @@ void Ammeter_Init(void)
 { 
   Ammeter_SetSpeed(AMMETER_DEFAULT_MEASUREMENT_SPEED);
   ADCRaw = ADC_GetVoltage(ADC_I);
-  adcCounter = ADCRaw->counter;
-  current.value = 0;
-  current.unfilteredValue = 0;
-  current.counter = 0;
-  current.milliseconds = 0;
+  adcCounter = Data_GetCounter(ADCRaw);
+  Data_Clear(&current);
   AmmeterError.errorCounter = 0;
   AmmeterError.error = ErrorMessaging_Ammeter_CurrentOverload;
   ADCError = ADC_GetError(ADC_I);
@@ -53,12 +51,11 @@ void Ammeter_Init(void)
 void Ammeter_Do(void)
 {
   int32_t signedCurrent, signedUnfilteredCurrent;    
+  Data_Filtered<int32_t> raw;
   RangeSwitcher_CurrentRanges range = RangeSwitcher_GetCurrentRange();
   
-  if (adcCounter != ADCRaw->counter) /* Process only new reading from ADC */
+  if (Data_ReadNew(ADCRaw, &adcCounter, &raw)) /* Process only new reading from ADC */
   {      
-    adcCounter = ADCRaw->counter;
-        
     if (resetFilter)
     {
       resetFilter = false;
@@ -76,14 +73,13 @@ void Ammeter_Do(void)
           adcErrorCounter = ADCError->errorCounter;
           if (ADCError->error == ErrorMessaging_ADC_Overload)
           {
-              AmmeterError.errorCounter++;
-              AmmeterError.error = ErrorMessaging_Ammeter_CurrentOverload;
+              ErrorMessaging_Raise(&AmmeterError, ErrorMessaging_Ammeter_CurrentOverload);
           }          
         }        
             
         /* calculate new voltage value and save it to local variable "signed current" */
-        signedCurrent = (((int64_t)(AMMETER_SLOPE_HI)) * ((int64_t)(ADCRaw->value))) / (DAC_REFERENCE_VOLTAGE * ADC_RECIPROCAL_LSB) + AMMETER_OFFSET_HI;   
-        signedUnfilteredCurrent = (((int64_t)(AMMETER_SLOPE_HI)) * ((int64_t)(ADCRaw->unfilteredValue))) / (DAC_REFERENCE_VOLTAGE * ADC_RECIPROCAL_LSB) + AMMETER_OFFSET_HI;
+        signedCurrent = Ammeter_GetCurrentFromADC(raw.value, CurrentRange_HighCurrent);   
+        signedUnfilteredCurrent = Ammeter_GetCurrentFromADC(raw.unfilteredValue, CurrentRange_HighCurrent);
       break;
       case CurrentRange_LowCurrent:
         if (adcErrorCounter != ADCError->errorCounter) /* ADC overload in low current range only switches to high current range, without updating the current value */
@@ -98,8 +94,8 @@ void Ammeter_Do(void)
         }
       
         /* calculate new voltage value and save it to local variable "signed current" */
-        signedCurrent = (((int64_t)(AMMETER_SLOPE_LO)) * ((int64_t)(ADCRaw->value))) / (DAC_REFERENCE_VOLTAGE * ADC_RECIPROCAL_LSB) + AMMETER_OFFSET_LO;    
-        signedUnfilteredCurrent = (((int64_t)(AMMETER_SLOPE_LO)) * ((int64_t)(ADCRaw->unfilteredValue))) / (DAC_REFERENCE_VOLTAGE * ADC_RECIPROCAL_LSB) + AMMETER_OFFSET_LO;     
+        signedCurrent = Ammeter_GetCurrentFromADC(raw.value, CurrentRange_LowCurrent);    
+        signedUnfilteredCurrent = Ammeter_GetCurrentFromADC(raw.unfilteredValue, CurrentRange_LowCurrent);     
       break;
       default:
       return;
@@ -108,8 +104,7 @@ void Ammeter_Do(void)
     if (signedUnfilteredCurrent < AMMETER_MINIMUM_CURRENT)
     {
       /* Signal negative current */
-      AmmeterError.errorCounter++;      
-      AmmeterError.error = ErrorMessaging_Ammeter_NegativeCurrent;
+      ErrorMessaging_Raise(&AmmeterError, ErrorMessaging_Ammeter_NegativeCurrent);
     }
 
     uint32_t newFilteredCurrent;
@@ -150,10 +145,9 @@ void Ammeter_Do(void)
 
     if (false == resetFilter)
     {
-      current.value = newFilteredCurrent;
-      current.unfilteredValue = newUnfilteredCurrent;
-      current.counter++;
-      current.milliseconds = millis();
+      Data_Filtered<uint32_t> newCurrent = {newFilteredCurrent, newUnfilteredCurrent};
+      Data_Publish(&current, newCurrent);
+      Events_Publish(Event_Current);
     }
   }
 }
@@ -168,6 +162,18 @@ const TSCADCULong * Ammeter_GetCurrent(void)
   return &current;  
 }
 
+int32_t Ammeter_GetCurrentFromADC(int32_t adcVoltage, RangeSwitcher_CurrentRanges range)
+{
+  if (range == CurrentRange_HighCurrent)
+  {
+    return (((int64_t)(AMMETER_SLOPE_HI)) * ((int64_t)adcVoltage)) / (DAC_REFERENCE_VOLTAGE * ADC_RECIPROCAL_LSB) + AMMETER_OFFSET_HI;
+  }
+  else
+  {
+    return (((int64_t)(AMMETER_SLOPE_LO)) * ((int64_t)adcVoltage)) / (DAC_REFERENCE_VOLTAGE * ADC_RECIPROCAL_LSB) + AMMETER_OFFSET_LO;
+  }
+}
+
 const ErrorMessaging_Error * Ammeter_GetError(void)
 {
   return &AmmeterError;
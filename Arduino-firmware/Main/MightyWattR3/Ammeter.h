@@ -16,6 +16,7 @@
 #include "Configuration.h"
 #include "Measurement.h"
 #include "ErrorMessaging.h"
+#include "RangeSwitcher.h"
  
 /* </Includes> */ 
  
@@ -63,6 +64,16 @@ void Ammeter_SetSpeed(Measurement_Speeds msp);
  */
 const TSCADCULong * Ammeter_GetCurrent(void);
 
+/**
+ * Calculates the current from an ADC voltage
+ *
+ * @param adcVoltage - ADC voltage (ADS1x15_Voltage)
+ * @param range - hardware current range the ADC voltage was measured in
+ *
+ * @return - Current in microamps, negative values are not clipped
+ */
+int32_t Ammeter_GetCurrentFromADC(int32_t adcVoltage, RangeSwitcher_CurrentRanges range);
+
 /**
  * Returns error structure for this module
  *
@@ -28,6 +28,14 @@
 #include "Flashreader.h"
 #include "MightyWatt.h"
 #include "PinController.h"
+#include "ADC.h"
+#include "DACC.h"
+#include "FanController.h"
+#include "LEDController.h"
+#include "Scheduler.h"
+#include "Profiler.h"
+#include "ControlTick.h"
+#include "Events.h"
 
 /* </Includes> */
 
@@ -35,19 +43,64 @@
 /* <Module variables> */
 
 static const uint8_t dataLengthMapping[] = {0, 1, 2, COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH};
-static Communication_WriteCommand writeCommand; /* Present command from the PC */
+static Communication_Command commandQueue[COMMUNICATION_COMMAND_QUEUE_SIZE]; /* Received write commands, each module reads them with its own cursor */
+static uint8_t commandQueueHead; /* Sequence number of the next command written to the queue, intentional wraparound */
+static uint8_t payloadPool[COMMUNICATION_PAYLOAD_POOL_SIZE]; /* Data of the queued commands, each frame takes a contiguous block */
+static uint8_t payloadHead; /* Index of the next free byte of the payload pool */
+static Communication_WriteCommandCursor * commandCursors[COMMUNICATION_COMMAND_CURSORS_MAXIMUM]; /* Cursors of all modules reading the queue */
+static uint8_t commandCursorCount;
+static bool commandQueueBlocked; /* True if the oldest received frame waits for space in the queue */
+static bool acknowledge; /* True if write commands are acknowledged */
+static Communication_PendingAcknowledge acknowledgeQueue[COMMUNICATION_ACKNOWLEDGE_QUEUE_SIZE]; /* Acknowledges waiting to be sent */
+static uint8_t acknowledgeTail, acknowledgeCount; /* Index of the oldest waiting acknowledge, number of waiting acknowledges */
 static Communication_ReadCommand readCommand; /* Present command from the PC */
 static uint8_t lastSent;
 static ErrorMessaging_Error communicationError;
-static uint8_t measurementMessage[COMMUNICATION_MEASUREMENT_MESSAGE_LENGTH];
+static Communication_Statistics statistics;
+static uint32_t timingStart; /* millis() when the timing counters were cleared */
+static uint8_t rxBuffer[COMMUNICATION_RX_BUFFER_SIZE]; /* Ring buffer of received bytes that were not processed yet */
+static uint8_t rxTail, rxCount; /* Index of the oldest byte in the ring buffer, number of bytes in the ring buffer */
+static bool frameInProgress; /* True if the oldest byte is a header of an incomplete frame */
+static bool synchronized; /* False after CRC failure until a valid frame is found */
+static uint32_t frameStartTime; /* Time when the incomplete frame was first seen */
+static Communication_Framings framing; /* Framing of the frames in both directions */
+static uint8_t slipLength; /* Number of decoded bytes of the SLIP frame being received, they are stored after the bytes in the ring buffer */
+static bool slipEscape; /* True if the last received byte was COMMUNICATION_SLIP_ESC */
+static bool slipDiscard; /* True if the SLIP frame being received is invalid and is skipped until the next COMMUNICATION_SLIP_END */
+static bool baudRateUnconfirmed; /* True if the baud rate was changed and no valid frame was received at the new baud rate yet */
+static uint32_t baudRateChangeTime; /* Time of the last baud rate change */
+static uint8_t measurementMessage[COMMUNICATION_MESSAGE_BUFFER_LENGTH]; /* Measurement message, telemetry fields message or state snapshot message */
+static uint16_t telemetryFields; /* Communication_TelemetryFields sent in measurement messages, 0 = fixed measurement message */
+static Communication_WriteCommandCursor commandCursor; /* Position of this module in the received write commands */
+static uint8_t streamDecimation; /* Number of measurements averaged into one streamed frame, 0 = streaming off */
+static uint16_t streamCount; /* Number of measurements accumulated for the next streamed frame, more than streamDecimation while a response is transmitted */
+static uint64_t streamCurrentSum, streamVoltageSum; /* Sums of measurements accumulated for the next streamed frame */
+static uint8_t streamBatchSize; /* Number of samples in one batched message, 0 or 1 = no batching */
+static uint8_t batchMessage[COMMUNICATION_BATCH_MAXIMUM_LENGTH];
+static uint8_t batchCount, batchLength; /* Number of samples in the batch and length of the batch message so far */
+static uint32_t batchLastCurrent, batchLastVoltage; /* Last sample in the batch, the next one is encoded as a difference to it */
+static uint8_t batchStatus[3]; /* Last sent temperature, status and pins */
+static bool batchStatusValid; /* False if no status was sent in this stream yet */
 static const Measurement_Values * measurementValues;
 static const TSCUChar * temperature;
-static char textMessage[64];
+static uint8_t txCommand; /* Read command whose response is being transmitted, ReadCommand_Invalid = no response in progress */
+static const uint8_t * txFrame; /* Measurement, telemetry fields or batch message transmitted as the ReadCommand_Measurement response */
+static uint8_t txFrameLength;
+static uint8_t txPart, txOffset; /* Part of the response being transmitted and number of its bytes already transmitted */
+static uint16_t txCRC; /* CRC of the binary response transmitted so far */
+static uint8_t * const txBuffer = measurementMessage; /* Response part composed in RAM (numbers, burst samples), messages in measurementMessage are only composed when no response is in progress */
+#if (4 * COMMUNICATION_BURST_PART_SAMPLES) > COMMUNICATION_MESSAGE_BUFFER_LENGTH
+  #error Burst response part does not fit in measurementMessage
+#endif
+static const uint8_t lineEnd[] = {'\r', '\n'};
 
 static const char Name[] FLASHMEMORY = NAME " (" SN ")";
 static const char CalibrationDate[] FLASHMEMORY = CALIBRATION_DATE;
 static const char FirmwareVersion[] FLASHMEMORY = FIRMWARE_VERSION;
 static const char BoardRevision[] FLASHMEMORY = BOARD_REVISION;
+static const char SerialNumber[] FLASHMEMORY = SN;
+static const char * const DescriptorTexts[] = {SerialNumber, CalibrationDate, FirmwareVersion, BoardRevision};
+static const uint8_t DescriptorTextLengths[] = {sizeof(SerialNumber) - 1, sizeof(CalibrationDate) - 1, sizeof(FirmwareVersion) - 1, sizeof(BoardRevision) - 1};
 
 /* </Module variables> */
 
@@ -56,14 +109,343 @@ static const char BoardRevision[] FLASHMEMORY = BOARD_REVISION;
 
 /**
    Receive part of the executable "Do" function handles incoming commands to set values to the load
+   Never waits for data, incomplete frames stay in the ring buffer until the next call
 */
 void Communication_Receive(void);
 
+/**
+   Gets a byte from the receive ring buffer
+
+   @param index - position of the byte counted from the oldest byte
+
+   @return - received byte
+*/
+uint8_t Communication_GetReceivedByte(uint8_t index);
+
+/**
+   Drops the header of a frame that failed CRC check and counts the CRC error
+*/
+void Communication_DropCorruptedFrame(void);
+
+/**
+   Restarts the serial port at a baud rate and drops everything received so far
+   The data in the transmit buffer are transmitted at the old baud rate before
+
+   @param baudRate - new baud rate
+*/
+void Communication_SetBaudRate(uint32_t baudRate);
+
+/**
+   Checks whether the serial port can run at a baud rate without error
+
+   @param baudRate - baud rate
+
+   @return - True if the baud rate can be used
+*/
+bool Communication_IsBaudRateSupported(uint32_t baudRate);
+
+/**
+   Decodes received SLIP bytes behind the bytes in the ring buffer
+   A frame is passed to the ring buffer only when it is complete and valid, so the parser never sees a corrupted frame
+*/
+void Communication_ReceiveSLIP(void);
+
+/**
+   Checks the length and CRC of the decoded SLIP frame, counts the error if it is invalid
+
+   @return - True if the frame is valid
+*/
+bool Communication_CheckSLIPFrame(void);
+
+/**
+   Writes a byte, escaped if SLIP framing is used
+
+   @param data - byte to write
+
+   @return - Number of bytes written to the serial port
+*/
+uint8_t Communication_WriteByte(uint8_t data);
+
+/**
+   Writes a whole message as one frame
+
+   @param data - message
+   @param length - length of the message
+*/
+void Communication_WriteFrame(const uint8_t * data, uint8_t length);
+
+/**
+   Writes the frame delimiter if SLIP framing is used
+*/
+void Communication_WriteDelimiter(void);
+
+/**
+   Starts the transmission of a measurement, telemetry fields or batch message as the ReadCommand_Measurement response
+   Only as many bytes as fit into the serial transmit buffer are written, the rest is transmitted in the next loop passes
+   The message must not be changed until the response is finished
+
+   @param data - message
+   @param length - length of the message
+*/
+void Communication_StartFrame(const uint8_t * data, uint8_t length);
+
+/**
+   Removes bytes from the start of the receive ring buffer
+
+   @param count - number of bytes to remove
+*/
+void Communication_DropReceivedBytes(uint8_t count);
+
+/**
+   Counts sub-commands of a batch write command in the receive ring buffer
+
+   @param start - position of the batch data in the receive ring buffer
+   @param dataLength - length of the batch data
+
+   @return - Number of sub-commands, 0 if the batch is empty, malformed or does not fit into the command queue
+*/
+uint8_t Communication_CountBatchCommands(uint8_t start, uint8_t dataLength);
+
+/**
+   Gets the number of free slots in the command queue (slots already read by all cursors)
+
+   @return - Number of free slots
+*/
+uint8_t Communication_GetFreeQueueSlots(void);
+
+/**
+   Reserves a contiguous block of the payload pool for the commands of one frame, blocks of commands already read by all cursors are reused
+
+   @param length - number of bytes, the sum of COMMUNICATION_PAYLOAD_SLOT_LENGTH of the commands
+
+   @return - False if the pool has no such free block
+*/
+bool Communication_ReservePayload(uint8_t length);
+
+/**
+   Adds a write command to the command queue, its data are copied to the reserved payload block and padded with zeroes
+   The caller must check that there is a free slot and reserve the payload
+
+   @param command - Number of the command
+   @param start - position of the data in the receive ring buffer
+   @param dataLength - length of the data
+*/
+void Communication_QueueCommand(uint8_t command, uint8_t start, uint8_t dataLength);
+
 /**
    Send part of the executable "Do" function handles sending requested data
 */
 void Communication_Send(void);
 
+/**
+   Processes communication command addressed to this module
+   Part of the "Do" loop
+*/
+void Communication_ProcessCommunication(void);
+
+/**
+   Streams measurements without request, averaged over streamDecimation measurements
+   Part of the "Do" loop
+*/
+void Communication_Stream(void);
+
+/**
+   Composes the measurement message and starts its transmission, see Communication_StartFrame
+
+   @param current - current in uA to send
+   @param voltage - voltage in uV to send
+*/
+void Communication_SendMeasurement(uint32_t current, uint32_t voltage);
+
+/**
+   Composes the telemetry fields message with the fields selected by telemetryFields and starts its transmission
+
+   @param current - current in uA to send
+   @param voltage - voltage in uV to send
+*/
+void Communication_SendFields(uint32_t current, uint32_t voltage);
+
+/**
+   Writes an unsigned long (LSB first) to a message
+
+   @param message - the message
+   @param position - position of the first byte
+   @param value - value to write
+
+   @return - Position after the written value
+*/
+uint8_t Communication_PutLong(uint8_t * message, uint8_t position, uint32_t value);
+
+/**
+   Adds a sample to the batched measurement message, sends the message when it is full
+   Batch contains base current and voltage followed by 16-bit differences to the previous sample
+   Temperature, status and pins are only appended when they change, error flags only when an error occured
+
+   @param current - current in uA to add
+   @param voltage - voltage in uV to add
+
+   @return - False if the difference did not fit, the batch is being sent and the sample must be added when it is finished
+*/
+bool Communication_AddToBatch(uint32_t current, uint32_t voltage);
+
+/**
+   Starts the transmission of the batched measurement message, the next sample starts a new one
+*/
+void Communication_SendBatch(void);
+
+/**
+   Composes the state snapshot message with its CRC into the measurement message buffer
+   The buffer is not used by measurements while the snapshot is being transmitted
+*/
+void Communication_ComposeState(void);
+
+/**
+   Checks whether any module (other than the ones reading all commands) reads the write command
+
+   @param command - Number of the command
+
+   @return - True if a module reads the command
+*/
+bool Communication_IsCommandHandled(uint8_t command);
+
+/**
+   Transmits the response in progress, only as many bytes as fit into the serial transmit buffer
+   The rest is transmitted in the next loop passes so that the loop is never blocked by a long response
+
+   @param block - True to transmit the whole rest of the response even if it has to wait for the serial transmit buffer
+*/
+void Communication_Transmit(bool block);
+
+/**
+   Sends the waiting acknowledges, only if no response is in progress
+
+   @param block - True to send all of them even if it has to wait for the serial transmit buffer, otherwise only those that fit into it
+*/
+void Communication_SendAcknowledges(bool block);
+
+/**
+   Gets a part of the response in progress
+
+   @param index - index of the part
+   @param part - filled with the part
+
+   @return - False if the response has no more parts
+*/
+bool Communication_GetResponsePart(uint8_t index, Communication_ResponsePart * part);
+
+/**
+   Gets a line of the text response in progress (without line end)
+
+   @param line - index of the line
+   @param part - filled with the line
+
+   @return - False if the response has no more lines
+*/
+bool Communication_GetResponseLine(uint8_t line, Communication_ResponsePart * part);
+
+/**
+   Gets a part of the binary capability descriptor
+
+   @param index - index of the part
+   @param part - filled with the part
+
+   @return - False if the descriptor has no more parts
+*/
+bool Communication_GetDescriptorPart(uint8_t index, Communication_ResponsePart * part);
+
+/**
+   Gets a part of the burst message
+   The samples are sent only when the burst is done, their number is taken when the header is composed
+
+   @param index - index of the part
+   @param part - filled with the part
+
+   @return - False if the burst message has no more parts
+*/
+bool Communication_GetBurstPart(uint8_t index, Communication_ResponsePart * part);
+
+/**
+   Gets a part of the timing message
+   The part is composed only when its transmission starts so that it does not change while it is being transmitted
+   Scheduler and control tick counters are cleared when the CRC is transmitted
+
+   @param index - index of the part
+   @param part - filled with the part
+
+   @return - False if the timing message has no more parts
+*/
+bool Communication_GetTimingPart(uint8_t index, Communication_ResponsePart * part);
+
+#ifdef PROFILER
+/**
+   Gets a part of the profile message
+   The part is composed only when its transmission starts so that it does not change while it is being transmitted
+   All profiler values are cleared when the CRC is transmitted
+
+   @param index - index of the part
+   @param part - filled with the part
+
+   @return - False if the profile has no more parts
+*/
+bool Communication_GetProfilePart(uint8_t index, Communication_ResponsePart * part);
+
+/**
+   Writes the execution times of a profiler probe to the response buffer
+
+   @param probe - Profiler_Probes
+*/
+void Communication_PutProbe(uint8_t probe);
+#endif
+
+/**
+   Sets the response part to text in flash memory
+
+   @param part - response part
+   @param text - text in flash memory
+   @param textLength - length of the text without the terminating zero
+
+   @return - True
+*/
+bool Communication_SetFlashPart(Communication_ResponsePart * part, const char * text, uint8_t textLength);
+
+/**
+   Sets the response part to decimal text of a number
+
+   @param part - response part
+   @param value - number
+
+   @return - True
+*/
+bool Communication_SetNumberPart(Communication_ResponsePart * part, uint32_t value);
+
+/**
+   Sets the response part to an unsigned long (LSB first)
+
+   @param part - response part
+   @param value - number
+
+   @return - True
+*/
+bool Communication_SetLongPart(Communication_ResponsePart * part, uint32_t value);
+
+/**
+   Checks whether the host can tell acknowledge messages from measurement messages
+   Raw frames have no delimiters and the fixed measurement message has no header, its first byte may equal COMMUNICATION_ACKNOWLEDGE_HEADER
+
+   @param newFraming - framing of the frames
+   @param newTelemetryFields - telemetry fields, 0 = fixed measurement message
+
+   @return - True if the frames are SLIP framed or the measurement message starts with COMMUNICATION_FIELDS_HEADER
+*/
+bool Communication_IsAcknowledgeDistinct(Communication_Framings newFraming, uint16_t newTelemetryFields);
+
+/**
+   Gets the status flag word of the load
+
+   @return - Status flag word (mode, ranges, LED, fan, 4-wire)
+*/
+uint8_t Communication_GetStatusFlag(void);
+
 /* </Declarations (prototypes)> */
 
 
@@ -71,251 +453,1731 @@ void Communication_Send(void);
 
 void Communication_Init(void)
 {
-  writeCommand.commandCounter = 0;
+  commandQueueHead = 0;
+  payloadHead = 0;
+  commandCursorCount = 0;
+  commandQueueBlocked = false;
+  acknowledge = false;
+  acknowledgeTail = 0;
+  acknowledgeCount = 0;
   readCommand.commandCounter = 0;
   lastSent = 0;
+  txCommand = ReadCommand_Invalid;
+  Communication_InitWriteCommandCursor(&commandCursor, COMMUNICATION_ALL_COMMANDS); /* Acknowledges commands that no module applies */
+  streamDecimation = 0;
+  streamCount = 0;
+  streamCurrentSum = 0;
+  streamVoltageSum = 0;
+  streamBatchSize = 0;
+  telemetryFields = 0;
+  batchCount = 0;
+  batchStatusValid = false;
 
   Communication_Reset();
 
   communicationError.errorCounter = 0;
   communicationError.error = ErrorMessaging_Communication_CommandTimeout;
+  statistics.timeouts = 0;
+  statistics.crcErrors = 0;
+  statistics.rejectedCommands = 0;
+  statistics.queueOverflows = 0;
+  statistics.framingErrors = 0;
+  statistics.baudRateFallbacks = 0;
+  timingStart = millis();
   measurementValues = Measurement_GetValues();
   temperature = Thermometer_GetTemperature();
 }
 
 void Communication_Do(void)
 {
-  if (SerialPort.available() > 0)  /* Receive message if data is available */
+  if ((rxCount > 0) || (SerialPort.available() > 0))  /* Receive message if data is available */
   {
     Communication_Receive();
   }
+  Communication_ProcessCommunication();
   Communication_Send();
+  Communication_Stream();
+
+  if (baudRateUnconfirmed && ((millis() - baudRateChangeTime) > COMMUNICATION_BAUDRATE_CONFIRM_TIMEOUT))
+  {
+    /* Host does not communicate at the new baud rate, fall back to the default one */
+    statistics.baudRateFallbacks++;
+    Communication_SetBaudRate(COMMUNICATION_BAUDRATE);
+  }
 }
 
 void Communication_Reset(void)
 {
+  framing = Framing_Raw;
+  Communication_SetBaudRate(COMMUNICATION_BAUDRATE);
+}
+
+void Communication_SetBaudRate(uint32_t baudRate)
+{
+  SerialPort.flush(); /* Finish transmission at the old baud rate */
   SerialPort.end();
-  SerialPort.begin(COMMUNICATION_BAUDRATE);
+  SerialPort.begin(baudRate);
   while(!SerialPort){}; /* Wait for the initialization of serial port */
   while(SerialPort.read() >= 0){}; /* Read all junk data already at the port */  
+  rxTail = 0;
+  rxCount = 0;
+  frameInProgress = false;
+  synchronized = true;
+  slipLength = 0;
+  slipEscape = false;
+  slipDiscard = (framing == Framing_SLIP); /* Bytes before the first delimiter are not a frame */
+  baudRateUnconfirmed = false;
+}
+
+bool Communication_IsBaudRateSupported(uint32_t baudRate)
+{
+#ifdef UNO
+  /* UART in double speed mode divides F_CPU by 8 * (UBRR + 1) */
+  return (baudRate >= COMMUNICATION_BAUDRATE) && (baudRate <= (F_CPU / 8)) && ((F_CPU % (8UL * baudRate)) == 0);
+#elif defined(ZERO)
+  return (baudRate >= COMMUNICATION_BAUDRATE); /* USB serial port does not use the baud rate */
+#endif
 }
 
 void Communication_Receive(void)
 {
-  int16_t data;
-  uint32_t startTime;
-  uint8_t i, dataLength; // dataLength is length of data payload without header and CRC
-  uint16_t receivedCRC;
-  static uint8_t message[COMMUNICATION_PAYLOAD_MAXIMUM_LENGTH + 1]; // payload + header
+  uint8_t i, command, headerLength, dataLength, queueLength, payloadLength; // dataLength is length of data payload without header and CRC
+  uint16_t receivedCRC, crc;
+  uint8_t header;
 
-  data = SerialPort.read();
-  if (data < 0)
+  /* Move the received bytes to the ring buffer, never wait for more */
+  if (framing == Framing_SLIP)
   {
-    return;
+    Communication_ReceiveSLIP();
   }
-
-  if (COMMUNICATION_COMMAND(data) == 0)
+  else
   {
-     // null command is invalid
-    return;
+    while ((rxCount < COMMUNICATION_RX_BUFFER_SIZE) && (SerialPort.available() > 0))
+    {
+      rxBuffer[(rxTail + rxCount) & COMMUNICATION_RX_BUFFER_MASK] = (uint8_t)SerialPort.read();
+      rxCount++;
+    }
   }
 
-  /* First byte is header */
-  message[0] = (uint8_t)data;
-  dataLength = dataLengthMapping[COMMUNICATION_DATA_LENGTH(message[0])];
-
-  /* Read all incoming bytes */
-  i = 0;
-  startTime = millis();
-  while (i < dataLength + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH)
+  while (rxCount > 0)
   {
-    data = SerialPort.read();
-    if (data >= 0)
+    /* First byte is header */
+    header = rxBuffer[rxTail];
+    if (COMMUNICATION_COMMAND(header) == 0)
     {
-      message[i + 1] = (uint8_t)data;
-      i++;
+      // null command is invalid
+      Communication_DropReceivedBytes(1);
+      continue;
     }
-    else if ((millis() - startTime) > COMMUNICATION_TIMEOUT)
+
+    if (COMMUNICATION_COMMAND(header) == COMMUNICATION_COMMAND_EXTENDED)
     {
-      /* timeout - error */
-      communicationError.errorCounter++;
-      communicationError.error = ErrorMessaging_Communication_CommandTimeout;
-      return;
+      /* Extended frame: header, command, data length */
+      headerLength = COMMUNICATION_EXTENDED_HEADER_LENGTH;
+      if (rxCount >= headerLength)
+      {
+        command = Communication_GetReceivedByte(1);
+        dataLength = Communication_GetReceivedByte(2);
+        if ((command == 0) || (dataLength > COMMUNICATION_EXTENDED_MAXIMUM_DATA_LENGTH))
+        {
+          // invalid extended header - drop it as if the CRC check failed
+          Communication_DropCorruptedFrame();
+          continue;
+        }
+      }
+      else
+      {
+        dataLength = 0; // not known yet, wait for the rest of the header
+      }
+    }
+    else
+    {
+      headerLength = 1;
+      command = COMMUNICATION_COMMAND(header);
+      dataLength = dataLengthMapping[COMMUNICATION_DATA_LENGTH(header)];
     }
-  }
 
-  /* Check CRC */
-  receivedCRC = (uint16_t)message[dataLength + 1] | (((uint16_t)message[dataLength + 2]) << 8);
-  if (receivedCRC != CRC16(COMMUNICATION_CRC_POLYNOMIAL_VALUE, message, 1 + dataLength)) // header + data
-  {
-    // CRC check fail - drop the message
-    return;
-  }
+    if (rxCount < headerLength + dataLength + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH)
+    {
+      /* Incomplete frame - check the per-frame timeout and return, the rest will be processed on next call */
+      if (!frameInProgress)
+      {
+        frameInProgress = true;
+        frameStartTime = millis();
+      }
+      else if ((millis() - frameStartTime) > COMMUNICATION_TIMEOUT)
+      {
+        /* timeout - error, drop the header and try to resynchronize on the next byte */
+        ErrorMessaging_Raise(&communicationError, ErrorMessaging_Communication_CommandTimeout);
+        statistics.timeouts++;
+        Communication_DropReceivedBytes(1);
+        continue;
+      }
+      return;
+    }
 
-  /* Fill command structures */
-  if (COMMUNICATION_RW(message[0]) == COMMUNICATION_WRITE)
-  {
-    /* Write to load */
-    writeCommand.commandCounter++;
-    writeCommand.command = COMMUNICATION_COMMAND(message[0]);
-    for (i = 0; i < dataLength; i++) /* copy data */
+    /* Complete frame - check CRC of header + data */
+    crc = 0;
+    for (i = 0; i < headerLength + dataLength; i++)
     {
-      writeCommand.data[i] = message[i + 1];
+      crc = CRC16_AddByte(COMMUNICATION_CRC_POLYNOMIAL_VALUE, crc, Communication_GetReceivedByte(i));
     }
-    for (i; i < COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH; i++) /* fill the rest with zeroes data */
+    receivedCRC = (uint16_t)Communication_GetReceivedByte(headerLength + dataLength) | (((uint16_t)Communication_GetReceivedByte(headerLength + dataLength + 1)) << 8);
+    if (receivedCRC != crc)
     {
-      writeCommand.data[i] = 0;
+      Communication_DropCorruptedFrame();
+      continue;
     }
-  }
-  else /* COMMUNICATION_READ */
-  {
-    /* Read from load (payload data discarded in this version) */
-    readCommand.commandCounter++;
-    readCommand.command = COMMUNICATION_COMMAND(message[0]);
-  }
-}
+    synchronized = true;
+    baudRateUnconfirmed = false; /* Valid frame confirms the baud rate */
 
-void Communication_Send(void)
-{
-  static uint8_t measurementValuesCounter = 0;    
-  
-  if (lastSent != readCommand.commandCounter)
-  {
-    uint8_t statusFlag = 0;
-    uint32_t l;
-    switch (readCommand.command)
+    /* Fill command structures */
+    if (COMMUNICATION_RW(header) == COMMUNICATION_WRITE)
     {
-      case ReadCommand_IDN:
-        Flashreader_Read((uint8_t*)textMessage, (uint8_t*)Name, sizeof(Name)/sizeof(Name[0]));
-        SerialPort.println(textMessage);
-        lastSent = readCommand.commandCounter;
-        break;
-      case ReadCommand_QDC:      
-        Flashreader_Read((uint8_t*)textMessage, (uint8_t*)CalibrationDate, sizeof(CalibrationDate)/sizeof(CalibrationDate[0]));
-        SerialPort.println(textMessage);
-        Flashreader_Read((uint8_t*)textMessage, (uint8_t*)FirmwareVersion, sizeof(FirmwareVersion)/sizeof(FirmwareVersion[0]));
-        SerialPort.println(textMessage);
-        Flashreader_Read((uint8_t*)textMessage, (uint8_t*)BoardRevision, sizeof(BoardRevision)/sizeof(BoardRevision[0]));
-        SerialPort.println(textMessage);
-        SerialPort.println(CURRENT_SETTER_MAXIMUM_HICURRENT + CURRENT_SETTER_MAXIMUM_HICURRENT / 65535);
-        SerialPort.println(AMMETER_MAXIMUM_CURRENT + AMMETER_MAXIMUM_CURRENT / 65535);
-        SerialPort.println(VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE + VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE / 65535);
-        SerialPort.println(VOLTMETER_MAXIMUM_VOLTAGE + VOLTMETER_MAXIMUM_VOLTAGE / 65535);
-        SerialPort.println(MAXIMUM_POWER);
-        SerialPort.println(VOLTMETER_INPUT_RESISTANCE);
-        SerialPort.println(LIMITER_MAXIMUM_TEMPERATURE);
-        lastSent = readCommand.commandCounter;
-        break;
-      case ReadCommand_ErrorMessages:        
-        uint8_t i;
-        SerialPort.write(ErrorMessaging_ErrorNamesCount()); /* Send the message length in lines as the first byte */
-        for (i = 0; i < ErrorMessaging_ErrorNamesCount(); i++)
+      /* Write to load */
+      if (command == WriteCommand_Batch)
+      {
+        queueLength = Communication_CountBatchCommands(headerLength, dataLength);
+        payloadLength = queueLength * COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH; /* sub-commands have standard data */
+      }
+      else
+      {
+        queueLength = 1;
+        payloadLength = COMMUNICATION_PAYLOAD_SLOT_LENGTH(dataLength);
+      }
+      if (queueLength == 0)
+      {
+        payloadLength = COMMUNICATION_PAYLOAD_SLOT_LENGTH(0);
+      }
+
+      if ((Communication_GetFreeQueueSlots() < ((queueLength > 0) ? queueLength : 1)) || !Communication_ReservePayload(payloadLength))
+      {
+        /* Queue is full - keep the frame in the receive buffer until all modules read their commands */
+        if (!commandQueueBlocked)
         {
-          ErrorMessaging_GetError(i, textMessage);
-          SerialPort.println(textMessage);
+          commandQueueBlocked = true;
+          statistics.queueOverflows++;
         }
-        lastSent = readCommand.commandCounter;
-        break;
-      case ReadCommand_Measurement:
-        uint16_t crc;
-        if (measurementValuesCounter != measurementValues->counter) /* Only send new measurement values */
+        return;
+      }
+      commandQueueBlocked = false;
+
+      if (queueLength == 0)
+      {
+        /* Rejected command is not applied at all, it still feeds the watchdog */
+        Communication_QueueCommand(WriteCommand_Invalid, headerLength, 0);
+        statistics.rejectedCommands++;
+      }
+      else if (command == WriteCommand_Batch)
+      {
+        /* All sub-commands are queued at once so that the modules apply them within one loop pass */
+        i = headerLength;
+        while (i < headerLength + dataLength)
         {
-          l = measurementValues->current;
-          measurementMessage[0] = l & 0xFF;
-          measurementMessage[1] = (l >> 8) & 0xFF;
-          measurementMessage[2] = (l >> 16) & 0xFF;
-          measurementMessage[3] = (l >> 24) & 0xFF;
-
-          l = measurementValues->voltage;
-          measurementMessage[4] = l & 0xFF;
-          measurementMessage[5] = (l >> 8) & 0xFF;
-          measurementMessage[6] = (l >> 16) & 0xFF;
-          measurementMessage[7] = (l >> 24) & 0xFF;
-
-          measurementMessage[8] = temperature->value;
-
-          if (Control_GetCCCV() == Control_CCCV_CV) /* Bit 0: Mode CV */
-          {
-            statusFlag |= 1 << 0;
-          }
-          if (RangeSwitcher_GetVoltageRange() == VoltageRange_LowVoltage) /* Bit 1: Low voltage range */
-          {
-            statusFlag |= 1 << 1;
-          }
-          if (RangeSwitcher_GetCurrentRange() == CurrentRange_LowCurrent) /* Bit 2: Low current range */
-          {
-            statusFlag |= 1 << 2;
-          }
-          if (LED_Get()) /* Bit 3: LED on */
-          {
-            statusFlag |= 1 << 3;
-          }
-          if (Fan_Get() == Fan_On) /* Bit 4: Fan on */
-          {
-            statusFlag |= 1 << 4;
-          }
-          if (Voltmeter_GetMode() == Voltmeter_4Terminal) /* Bit 5: 4-wire mode */
-          {
-            statusFlag |= 1 << 5;
-          }
-          measurementMessage[9] = statusFlag;
-
-          measurementMessage[10] = PinController_GetPins();
-
-          l = ErrorMessaging_GetErrorFlags();
-          measurementMessage[11] = l & 0xFF;
-          measurementMessage[12] = (l >> 8) & 0xFF;
-          measurementMessage[13] = (l >> 16) & 0xFF;
-          measurementMessage[14] = (l >> 24) & 0xFF;          
-
-          // compute CRC of the measurement message body and append it to the end
-          crc = CRC16(COMMUNICATION_CRC_POLYNOMIAL_VALUE, (const uint8_t *)measurementMessage, COMMUNICATION_MEASUREMENT_MESSAGE_DATA_LENGTH);
-          measurementMessage[15] = crc & 0xFF;
-          measurementMessage[16] = (crc >> 8) & 0xFF;
-
-          SerialPort.write(measurementMessage, COMMUNICATION_MEASUREMENT_MESSAGE_LENGTH);
-          measurementValuesCounter = measurementValues->counter;
-          lastSent = readCommand.commandCounter;
+          header = Communication_GetReceivedByte(i);
+          Communication_QueueCommand(COMMUNICATION_COMMAND(header), i + 1, dataLengthMapping[COMMUNICATION_DATA_LENGTH(header)]);
+          i += 1 + dataLengthMapping[COMMUNICATION_DATA_LENGTH(header)];
         }
-        break;
-      default:
-        lastSent = readCommand.commandCounter;
-        break;
+      }
+      else
+      {
+        Communication_QueueCommand(command, headerLength, dataLength);
+      }
+      Communication_DropReceivedBytes(headerLength + dataLength + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH);
+    }
+    else /* COMMUNICATION_READ */
+    {
+      /* Read from load (payload data discarded in this version) */
+      readCommand.commandCounter++;
+      readCommand.command = command;
+      Events_Publish(Event_ReadCommand);
+      Communication_DropReceivedBytes(headerLength + dataLength + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH);
+      return; /* One read command per call, it must be answered before it is overwritten */
     }
   }
 }
 
-const Communication_WriteCommand * Communication_GetWriteCommand(void)
+uint8_t Communication_GetReceivedByte(uint8_t index)
 {
-  return &writeCommand;
+  return rxBuffer[(rxTail + index) & COMMUNICATION_RX_BUFFER_MASK];
 }
 
-const Communication_ReadCommand * Communication_GetReadCommand(void)
+uint8_t Communication_CountBatchCommands(uint8_t start, uint8_t dataLength)
 {
-  return &readCommand;
+  uint8_t position = start;
+  uint8_t count = 0;
+  uint8_t subCommand;
+
+  while (position < start + dataLength)
+  {
+    subCommand = COMMUNICATION_COMMAND(Communication_GetReceivedByte(position));
+    if ((subCommand == WriteCommand_Invalid) || (subCommand == WriteCommand_Batch) || (subCommand == COMMUNICATION_COMMAND_EXTENDED))
+    {
+      return 0;
+    }
+    position += 1 + dataLengthMapping[COMMUNICATION_DATA_LENGTH(Communication_GetReceivedByte(position))];
+    count++;
+  }
+  if ((position != start + dataLength) || (count > COMMUNICATION_COMMAND_QUEUE_SIZE)) /* last sub-command must not be truncated */
+  {
+    return 0;
+  }
+  return count;
 }
 
-const ErrorMessaging_Error * Communication_GetError(void)
+uint8_t Communication_GetFreeQueueSlots(void)
 {
-  return &communicationError;
+  uint8_t i, unread;
+  uint8_t used = 0;
+
+  for (i = 0; i < commandCursorCount; i++)
+  {
+    unread = commandQueueHead - commandCursors[i]->position;
+    if (unread > used)
+    {
+      used = unread;
+    }
+  }
+  return COMMUNICATION_COMMAND_QUEUE_SIZE - used;
 }
 
-uint16_t CRC16(const uint16_t polynomial, const uint8_t * data, uint8_t dataLength)
+bool Communication_ReservePayload(uint8_t length)
+{
+  uint8_t tail;
+  uint8_t used = COMMUNICATION_COMMAND_QUEUE_SIZE - Communication_GetFreeQueueSlots();
+
+  if (used == 0)
+  {
+    payloadHead = 0; /* all data were read, the whole pool is free */
+    return true;
+  }
+
+  tail = commandQueue[(commandQueueHead - used) & COMMUNICATION_COMMAND_QUEUE_MASK].data - payloadPool; /* data of the oldest unread command */
+  if (payloadHead > tail)
+  {
+    if ((COMMUNICATION_PAYLOAD_POOL_SIZE - payloadHead) >= length)
+    {
+      return true;
+    }
+    payloadHead = 0; /* the end of the pool is too short, wrap around */
+  }
+  return (payloadHead < tail) && ((tail - payloadHead) >= length); /* equal indices mean that the pool is full */
+}
+
+void Communication_QueueCommand(uint8_t command, uint8_t start, uint8_t dataLength)
+{
+  uint8_t i;
+  uint8_t * data = payloadPool + payloadHead;
+  Communication_Command * queuedCommand = &commandQueue[commandQueueHead & COMMUNICATION_COMMAND_QUEUE_MASK];
+
+  queuedCommand->command = command;
+  queuedCommand->dataLength = dataLength;
+  queuedCommand->sequence = commandQueueHead;
+  queuedCommand->data = data;
+  for (i = 0; i < COMMUNICATION_PAYLOAD_SLOT_LENGTH(dataLength); i++)
+  {
+    data[i] = (i < dataLength) ? Communication_GetReceivedByte(start + i) : 0;
+  }
+  payloadHead += COMMUNICATION_PAYLOAD_SLOT_LENGTH(dataLength);
+  commandQueueHead++;
+  Events_Publish(Event_Command);
+}
+
+bool Communication_IsCommandHandled(uint8_t command)
+{
+  uint8_t i;
+
+  for (i = 0; i < commandCursorCount; i++)
+  {
+    if ((commandCursors[i]->commands != COMMUNICATION_ALL_COMMANDS) && COMMUNICATION_IS_ADDRESSED(command, commandCursors[i]->commands))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Communication_DropCorruptedFrame(void)
+{
+  // drop the header only, the next frame may start within the dropped data
+  if (synchronized) /* count only the first failure, the following ones are resynchronization attempts */
+  {
+    statistics.crcErrors++;
+    synchronized = false;
+  }
+  Communication_DropReceivedBytes(1);
+}
+
+void Communication_ReceiveSLIP(void)
+{
+  uint8_t data;
+
+  while ((rxCount + slipLength < COMMUNICATION_RX_BUFFER_SIZE) && (SerialPort.available() > 0))
+  {
+    data = (uint8_t)SerialPort.read();
+    if (data == COMMUNICATION_SLIP_END)
+    {
+      if (slipEscape && !slipDiscard)
+      {
+        statistics.framingErrors++; /* Escape must be followed by an escaped byte, the frame is incomplete */
+      }
+      else if ((slipLength > 0) && !slipDiscard && Communication_CheckSLIPFrame())
+      {
+        rxCount += slipLength; /* Pass the whole frame to the parser */
+      }
+      slipLength = 0;
+      slipEscape = false;
+      slipDiscard = false;
+      continue;
+    }
+    if (slipDiscard)
+    {
+      continue;
+    }
+
+    if (slipEscape)
+    {
+      slipEscape = false;
+      if (data == COMMUNICATION_SLIP_ESC_END)
+      {
+        data = COMMUNICATION_SLIP_END;
+      }
+      else if (data == COMMUNICATION_SLIP_ESC_ESC)
+      {
+        data = COMMUNICATION_SLIP_ESC;
+      }
+      else
+      {
+        statistics.framingErrors++;
+        slipDiscard = true;
+        continue;
+      }
+    }
+    else if (data == COMMUNICATION_SLIP_ESC)
+    {
+      slipEscape = true;
+      continue;
+    }
+
+    if (slipLength >= COMMUNICATION_FRAME_MAXIMUM_LENGTH)
+    {
+      statistics.framingErrors++;
+      slipDiscard = true;
+      continue;
+    }
+    rxBuffer[(rxTail + rxCount + slipLength) & COMMUNICATION_RX_BUFFER_MASK] = data;
+    slipLength++;
+  }
+}
+
+bool Communication_CheckSLIPFrame(void)
 {
+  uint8_t i, header, frameLength;
   uint16_t crc = 0;
-  for (uint8_t i = 0; i < dataLength; i++)
+
+  /* Length of the frame given by its header */
+  header = Communication_GetReceivedByte(rxCount);
+  if (COMMUNICATION_COMMAND(header) == 0)
+  {
+    frameLength = 0;
+  }
+  else if (COMMUNICATION_COMMAND(header) == COMMUNICATION_COMMAND_EXTENDED)
+  {
+    if ((slipLength < COMMUNICATION_EXTENDED_HEADER_LENGTH) || (Communication_GetReceivedByte(rxCount + 2) > COMMUNICATION_EXTENDED_MAXIMUM_DATA_LENGTH))
+    {
+      frameLength = 0;
+    }
+    else
+    {
+      frameLength = COMMUNICATION_EXTENDED_HEADER_LENGTH + Communication_GetReceivedByte(rxCount + 2) + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH;
+    }
+  }
+  else
+  {
+    frameLength = 1 + dataLengthMapping[COMMUNICATION_DATA_LENGTH(header)] + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH;
+  }
+  if (frameLength != slipLength)
+  {
+    statistics.framingErrors++;
+    return false;
+  }
+
+  for (i = 0; i < slipLength - COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH; i++)
+  {
+    crc = CRC16_AddByte(COMMUNICATION_CRC_POLYNOMIAL_VALUE, crc, Communication_GetReceivedByte(rxCount + i));
+  }
+  if (crc != ((uint16_t)Communication_GetReceivedByte(rxCount + i) | (((uint16_t)Communication_GetReceivedByte(rxCount + i + 1)) << 8)))
+  {
+    statistics.crcErrors++;
+    return false;
+  }
+  return true;
+}
+
+uint8_t Communication_WriteByte(uint8_t data)
+{
+  if (framing == Framing_SLIP)
+  {
+    if (data == COMMUNICATION_SLIP_END)
+    {
+      SerialPort.write(COMMUNICATION_SLIP_ESC);
+      SerialPort.write(COMMUNICATION_SLIP_ESC_END);
+      return 2;
+    }
+    if (data == COMMUNICATION_SLIP_ESC)
+    {
+      SerialPort.write(COMMUNICATION_SLIP_ESC);
+      SerialPort.write(COMMUNICATION_SLIP_ESC_ESC);
+      return 2;
+    }
+  }
+  SerialPort.write(data);
+  return 1;
+}
+
+void Communication_WriteFrame(const uint8_t * data, uint8_t length)
+{
+  uint8_t i;
+
+  if (framing == Framing_Raw)
+  {
+    SerialPort.write(data, length);
+    return;
+  }
+
+  SerialPort.write(COMMUNICATION_SLIP_END);
+  for (i = 0; i < length; i++)
+  {
+    Communication_WriteByte(data[i]);
+  }
+  SerialPort.write(COMMUNICATION_SLIP_END);
+}
+
+void Communication_WriteDelimiter(void)
+{
+  if (framing == Framing_SLIP)
+  {
+    SerialPort.write(COMMUNICATION_SLIP_END);
+  }
+}
+
+void Communication_StartFrame(const uint8_t * data, uint8_t length)
+{
+  txFrame = data;
+  txFrameLength = length;
+  txCommand = ReadCommand_Measurement;
+  txPart = 0;
+  txOffset = 0;
+  txCRC = 0;
+  Communication_WriteDelimiter();
+  Communication_Transmit(false);
+}
+
+void Communication_DropReceivedBytes(uint8_t count)
+{
+  if (count > rxCount)
+  {
+    count = rxCount;
+  }
+  rxTail = (rxTail + count) & COMMUNICATION_RX_BUFFER_MASK;
+  rxCount -= count;
+  frameInProgress = false;
+}
+
+void Communication_Send(void)
+{
+  static uint8_t measurementValuesCounter = 0;    
+  
+  if (lastSent != readCommand.commandCounter)
+  {
+    switch (readCommand.command)
+    {
+      case ReadCommand_IDN:
+      case ReadCommand_QDC:
+      case ReadCommand_ErrorMessages:
+      case ReadCommand_Descriptor:
+      case ReadCommand_Burst:
+      case ReadCommand_Timing:
+#ifdef PROFILER
+      case ReadCommand_Profile:
+#endif
+        if (txCommand == ReadCommand_Invalid) /* Start the response when the previous one is finished */
+        {
+          txCommand = readCommand.command;
+          txPart = 0;
+          txOffset = 0;
+          txCRC = 0;
+          lastSent = readCommand.commandCounter;
+          Communication_WriteDelimiter();
+        }
+        break;
+      case ReadCommand_State:
+        if (txCommand == ReadCommand_Invalid)
+        {
+          Communication_ComposeState(); /* Snapshot is taken at once so that it is consistent */
+          txCommand = readCommand.command;
+          txPart = 0;
+          txOffset = 0;
+          txCRC = 0;
+          lastSent = readCommand.commandCounter;
+          Communication_WriteDelimiter();
+        }
+        break;
+      case ReadCommand_Measurement:
+        if (streamDecimation > 0) /* Measurements are streamed, do not interleave them with requested ones */
+        {
+          lastSent = readCommand.commandCounter;
+        }
+        else if ((measurementValuesCounter != measurementValues->counter) && (txCommand == ReadCommand_Invalid)) /* Only send new measurement values, not within another response */
+        {
+          Communication_SendMeasurement(measurementValues->current, measurementValues->voltage);
+          measurementValuesCounter = measurementValues->counter;
+          lastSent = readCommand.commandCounter;
+        }
+        break;
+      default:
+        lastSent = readCommand.commandCounter;
+        break;
+    }
+  }
+
+  Communication_Transmit(false);
+}
+
+void Communication_ProcessCommunication(void)
+{
+  const Communication_Command * newCommand;
+
+  /* Check new commands */
+  while ((newCommand = Communication_GetNextWriteCommand(&commandCursor)) != NULL)
+  {
+    /* LSB first */
+    switch (newCommand->command)
+    {
+      case WriteCommand_MeasurementStream:
+        streamDecimation = newCommand->data[0];
+        streamCount = 0;
+        streamCurrentSum = 0;
+        streamVoltageSum = 0;
+        streamBatchSize = newCommand->data[1];
+        if (streamBatchSize > COMMUNICATION_BATCH_MAXIMUM_SAMPLES)
+        {
+          streamBatchSize = COMMUNICATION_BATCH_MAXIMUM_SAMPLES;
+        }
+        batchCount = 0;
+        batchStatusValid = false;
+        Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
+      break;
+      case WriteCommand_TelemetryFields:
+        if (!acknowledge || Communication_IsAcknowledgeDistinct(framing, Data_GetUIntFromUCharArray(newCommand->data)))
+        {
+          telemetryFields = Data_GetUIntFromUCharArray(newCommand->data);
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
+        }
+        else
+        {
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_InvalidValue);
+        }
+      break;
+      case WriteCommand_Acknowledge:
+        if ((newCommand->data[0] == 0) || Communication_IsAcknowledgeDistinct(framing, telemetryFields))
+        {
+          acknowledge = newCommand->data[0] > 0;
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied); /* Acknowledges only enabling */
+        }
+        else
+        {
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_InvalidValue); /* Not sent, acknowledging stays off */
+        }
+      break;
+      case WriteCommand_Framing:
+        if ((newCommand->data[0] <= Framing_SLIP) && (!acknowledge || Communication_IsAcknowledgeDistinct((Communication_Framings)newCommand->data[0], telemetryFields)))
+        {
+          framing = (Communication_Framings)newCommand->data[0];
+          slipLength = 0;
+          slipEscape = false;
+          slipDiscard = true; /* Bytes before the first delimiter are not a frame */
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
+        }
+        else
+        {
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_InvalidValue);
+        }
+      break;
+      case WriteCommand_BaudRate:
+      {
+        uint32_t newBaudRate = Data_GetULongFromUCharArray(newCommand->data);
+        if (Communication_IsBaudRateSupported(newBaudRate))
+        {
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied); /* Acknowledged at the present baud rate */
+          Communication_Transmit(true);
+          Communication_SetBaudRate(newBaudRate);
+          baudRateUnconfirmed = (newBaudRate != COMMUNICATION_BAUDRATE);
+          baudRateChangeTime = millis();
+        }
+        else
+        {
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_InvalidValue);
+        }
+        break;
+      }
+      case WriteCommand_Invalid:
+        Communication_AcknowledgeCommand(newCommand, Acknowledge_Rejected);
+      break;
+      default:
+        if (!Communication_IsCommandHandled(newCommand->command))
+        {
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_Unknown);
+        }
+        /* otherwise command handled by other modules */
+      break;
+    }
+  }
+}
+
+void Communication_Stream(void)
+{
+  static uint8_t measurementValuesCounter = 0;
+
+  if ((streamDecimation > 0) && (measurementValuesCounter != measurementValues->counter)) /* Only stream new measurement values */
   {
-    crc ^= (((uint16_t)data[i]) << 8);
-    for (uint8_t j = 0; j < 8; j++)
+    measurementValuesCounter = measurementValues->counter;
+    if (streamCount == 0xFFFF) /* Transmission of a response took too long, restart averaging instead of wrapping the count */
+    {
+      streamCount = 0;
+      streamCurrentSum = 0;
+      streamVoltageSum = 0;
+    }
+    streamCurrentSum += measurementValues->current;
+    streamVoltageSum += measurementValues->voltage;
+    streamCount++;
+
+    if ((streamCount >= streamDecimation) && (txCommand == ReadCommand_Invalid)) /* Keep averaging while a response or the previous frame is transmitted */
     {
-      if ((crc & 0x8000U) > 0)
+      uint32_t current = (uint32_t)((streamCurrentSum + streamCount / 2) / streamCount);
+      uint32_t voltage = (uint32_t)((streamVoltageSum + streamCount / 2) / streamCount);
+      if (streamBatchSize > 1)
       {
-        crc = (crc << 1) ^ polynomial;
+        if (!Communication_AddToBatch(current, voltage))
+        {
+          return; /* The full batch is transmitted first, the sample keeps averaging */
+        }
       }
       else
       {
-        crc = crc << 1;
+        Communication_SendMeasurement(current, voltage);
       }
+      streamCount = 0;
+      streamCurrentSum = 0;
+      streamVoltageSum = 0;
+    }
+  }
+}
+
+void Communication_SendMeasurement(uint32_t current, uint32_t voltage)
+{
+  uint16_t crc;
+  uint32_t l;
+
+  if (telemetryFields != 0)
+  {
+    Communication_SendFields(current, voltage);
+    return;
+  }
+
+  l = current;
+  measurementMessage[0] = l & 0xFF;
+  measurementMessage[1] = (l >> 8) & 0xFF;
+  measurementMessage[2] = (l >> 16) & 0xFF;
+  measurementMessage[3] = (l >> 24) & 0xFF;
+
+  l = voltage;
+  measurementMessage[4] = l & 0xFF;
+  measurementMessage[5] = (l >> 8) & 0xFF;
+  measurementMessage[6] = (l >> 16) & 0xFF;
+  measurementMessage[7] = (l >> 24) & 0xFF;
+
+  measurementMessage[8] = Data_GetValue(temperature);
+
+  measurementMessage[9] = Communication_GetStatusFlag();
+
+  measurementMessage[10] = PinController_GetPins();
+
+  l = ErrorMessaging_GetErrorFlags();
+  measurementMessage[11] = l & 0xFF;
+  measurementMessage[12] = (l >> 8) & 0xFF;
+  measurementMessage[13] = (l >> 16) & 0xFF;
+  measurementMessage[14] = (l >> 24) & 0xFF;          
+
+  // compute CRC of the measurement message body and append it to the end
+  crc = CRC16(COMMUNICATION_CRC_POLYNOMIAL_VALUE, (const uint8_t *)measurementMessage, COMMUNICATION_MEASUREMENT_MESSAGE_DATA_LENGTH);
+  measurementMessage[15] = crc & 0xFF;
+  measurementMessage[16] = (crc >> 8) & 0xFF;
+
+  Communication_StartFrame(measurementMessage, COMMUNICATION_MEASUREMENT_MESSAGE_LENGTH);
+}
+
+void Communication_SendFields(uint32_t current, uint32_t voltage)
+{
+  uint8_t length;
+  uint16_t crc;
+
+  measurementMessage[0] = COMMUNICATION_FIELDS_HEADER;
+  measurementMessage[1] = telemetryFields & 0xFF;
+  measurementMessage[2] = (telemetryFields >> 8) & 0xFF;
+  length = 3;
+
+  /* Fields in the order of their bits */
+  if (telemetryFields & Field_Current)
+  {
+    length = Communication_PutLong(measurementMessage, length, current);
+  }
+  if (telemetryFields & Field_Voltage)
+  {
+    length = Communication_PutLong(measurementMessage, length, voltage);
+  }
+  if (telemetryFields & Field_Power)
+  {
+    length = Communication_PutLong(measurementMessage, length, measurementValues->power);
+  }
+  if (telemetryFields & Field_Resistance)
+  {
+    length = Communication_PutLong(measurementMessage, length, measurementValues->resistance);
+  }
+  if (telemetryFields & Field_UnfilteredCurrent)
+  {
+    length = Communication_PutLong(measurementMessage, length, measurementValues->unfilteredCurrent);
+  }
+  if (telemetryFields & Field_UnfilteredVoltage)
+  {
+    length = Communication_PutLong(measurementMessage, length, measurementValues->unfilteredVoltage);
+  }
+  if (telemetryFields & Field_UnfilteredPower)
+  {
+    length = Communication_PutLong(measurementMessage, length, measurementValues->unfilteredPower);
+  }
+  if (telemetryFields & Field_UnfilteredResistance)
+  {
+    length = Communication_PutLong(measurementMessage, length, measurementValues->unfilteredResistance);
+  }
+  if (telemetryFields & Field_DAC)
+  {
+    uint16_t dac = DACC_GetValue();
+    measurementMessage[length++] = dac & 0xFF;
+    measurementMessage[length++] = (dac >> 8) & 0xFF;
+  }
+  if (telemetryFields & Field_Temperature)
+  {
+    measurementMessage[length++] = Data_GetValue(temperature);
+  }
+  if (telemetryFields & Field_Status)
+  {
+    measurementMessage[length++] = Communication_GetStatusFlag();
+  }
+  if (telemetryFields & Field_Pins)
+  {
+    measurementMessage[length++] = PinController_GetPins();
+  }
+  if (telemetryFields & Field_ErrorFlags)
+  {
+    length = Communication_PutLong(measurementMessage, length, ErrorMessaging_GetErrorFlags());
+  }
+  if (telemetryFields & Field_Timestamp)
+  {
+    length = Communication_PutLong(measurementMessage, length, measurementValues->microseconds);
+  }
+  if (telemetryFields & Field_Sequence)
+  {
+    measurementMessage[length++] = measurementValues->sequence & 0xFF;
+    measurementMessage[length++] = (measurementValues->sequence >> 8) & 0xFF;
+  }
+
+  // compute CRC of the message body and append it to the end
+  crc = CRC16(COMMUNICATION_CRC_POLYNOMIAL_VALUE, (const uint8_t *)measurementMessage, length);
+  measurementMessage[length] = crc & 0xFF;
+  measurementMessage[length + 1] = (crc >> 8) & 0xFF;
+
+  Communication_StartFrame(measurementMessage, length + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH);
+}
+
+uint8_t Communication_PutLong(uint8_t * message, uint8_t position, uint32_t value)
+{
+  message[position] = value & 0xFF;
+  message[position + 1] = (value >> 8) & 0xFF;
+  message[position + 2] = (value >> 16) & 0xFF;
+  message[position + 3] = (value >> 24) & 0xFF;
+  return position + 4;
+}
+
+bool Communication_AddToBatch(uint32_t current, uint32_t voltage)
+{
+  int32_t currentDifference, voltageDifference;
+
+  if (batchCount > 0)
+  {
+    currentDifference = (int32_t)(current - batchLastCurrent);
+    voltageDifference = (int32_t)(voltage - batchLastVoltage);
+    if ((currentDifference > COMMUNICATION_BATCH_DIFFERENCE_MAXIMUM) || (currentDifference < COMMUNICATION_BATCH_DIFFERENCE_MINIMUM) ||
+        (voltageDifference > COMMUNICATION_BATCH_DIFFERENCE_MAXIMUM) || (voltageDifference < COMMUNICATION_BATCH_DIFFERENCE_MINIMUM))
+    {
+      /* Difference does not fit, this sample starts a new batch when the present one is transmitted */
+      Communication_SendBatch();
+      return false;
+    }
+  }
+
+  if (batchCount == 0)
+  {
+    /* Base values */
+    batchMessage[1] = current & 0xFF;
+    batchMessage[2] = (current >> 8) & 0xFF;
+    batchMessage[3] = (current >> 16) & 0xFF;
+    batchMessage[4] = (current >> 24) & 0xFF;
+    batchMessage[5] = voltage & 0xFF;
+    batchMessage[6] = (voltage >> 8) & 0xFF;
+    batchMessage[7] = (voltage >> 16) & 0xFF;
+    batchMessage[8] = (voltage >> 24) & 0xFF;
+    batchLength = 9;
+  }
+  else
+  {
+    /* Differences to the previous sample */
+    batchMessage[batchLength] = currentDifference & 0xFF;
+    batchMessage[batchLength + 1] = (currentDifference >> 8) & 0xFF;
+    batchMessage[batchLength + 2] = voltageDifference & 0xFF;
+    batchMessage[batchLength + 3] = (voltageDifference >> 8) & 0xFF;
+    batchLength += 4;
+  }
+
+  batchLastCurrent = current;
+  batchLastVoltage = voltage;
+  batchCount++;
+
+  if (batchCount >= streamBatchSize)
+  {
+    Communication_SendBatch();
+  }
+  return true;
+}
+
+void Communication_SendBatch(void)
+{
+  uint8_t status[3];
+  uint16_t crc;
+  uint32_t l;
+
+  if (batchCount == 0)
+  {
+    return;
+  }
+
+  batchMessage[0] = batchCount;
+
+  /* Temperature, status and pins only if changed */
+  status[0] = Data_GetValue(temperature);
+  status[1] = Communication_GetStatusFlag();
+  status[2] = PinController_GetPins();
+  if ((!batchStatusValid) || (status[0] != batchStatus[0]) || (status[1] != batchStatus[1]) || (status[2] != batchStatus[2]))
+  {
+    batchMessage[0] |= COMMUNICATION_BATCH_STATUS_FLAG;
+    batchMessage[batchLength] = status[0];
+    batchMessage[batchLength + 1] = status[1];
+    batchMessage[batchLength + 2] = status[2];
+    batchLength += 3;
+    batchStatus[0] = status[0];
+    batchStatus[1] = status[1];
+    batchStatus[2] = status[2];
+    batchStatusValid = true;
+  }
+
+  /* Error flags only if there are any */
+  l = ErrorMessaging_GetErrorFlags();
+  if (l != 0)
+  {
+    batchMessage[0] |= COMMUNICATION_BATCH_ERRORS_FLAG;
+    batchMessage[batchLength] = l & 0xFF;
+    batchMessage[batchLength + 1] = (l >> 8) & 0xFF;
+    batchMessage[batchLength + 2] = (l >> 16) & 0xFF;
+    batchMessage[batchLength + 3] = (l >> 24) & 0xFF;
+    batchLength += 4;
+  }
+
+  // compute CRC of the batch message body and append it to the end
+  crc = CRC16(COMMUNICATION_CRC_POLYNOMIAL_VALUE, (const uint8_t *)batchMessage, batchLength);
+  batchMessage[batchLength] = crc & 0xFF;
+  batchMessage[batchLength + 1] = (crc >> 8) & 0xFF;
+
+  batchCount = 0;
+  Communication_StartFrame(batchMessage, batchLength + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH);
+}
+
+void Communication_ComposeState(void)
+{
+  uint8_t length, i;
+  uint8_t autorange = 0;
+  uint16_t crc;
+  const ADS1x15_ChannelSetting * channelSetting;
+  const uint16_t counters[COMMUNICATION_STATE_STATISTICS_COUNT] = {statistics.timeouts, statistics.crcErrors, statistics.rejectedCommands,
+                                                                   statistics.queueOverflows, statistics.framingErrors, statistics.baudRateFallbacks};
+
+  measurementMessage[0] = COMMUNICATION_STATE_HEADER;
+  measurementMessage[1] = COMMUNICATION_STATE_MESSAGE_DATA_LENGTH - 2;
+  measurementMessage[2] = COMMUNICATION_STATE_VERSION;
+  measurementMessage[3] = Control_GetMode();
+  length = Communication_PutLong(measurementMessage, 4, Control_GetSetCurrent());
+  length = Communication_PutLong(measurementMessage, length, Control_GetSetVoltage());
+  length = Communication_PutLong(measurementMessage, length, Control_GetSetPower());
+  length = Communication_PutLong(measurementMessage, length, Control_GetSetResistance());
+  measurementMessage[length++] = DACC_GetValue() & 0xFF;
+  measurementMessage[length++] = (DACC_GetValue() >> 8) & 0xFF;
+  measurementMessage[length++] = Communication_GetStatusFlag();
+  if (RangeSwitcher_CanAutorangeCurrent())
+  {
+    autorange |= 1 << 0;
+  }
+  if (RangeSwitcher_CanAutorangeVoltage())
+  {
+    autorange |= 1 << 1;
+  }
+  measurementMessage[length++] = autorange;
+
+  for (i = 0; i < ADC_CHANNEL_COUNT; i++)
+  {
+    channelSetting = ADC_GetChannelSetting((ADC_Channels)i);
+    measurementMessage[length] = ((channelSetting->range >> 9) & 0x07) | (((channelSetting->dataRate >> 5) & 0x07) << 3);
+    if (channelSetting->autorange)
+    {
+      measurementMessage[length] |= COMMUNICATION_STATE_CHANNEL_AUTORANGE;
+    }
+    if (ADC_IsChannelFiltered((ADC_Channels)i))
+    {
+      measurementMessage[length] |= COMMUNICATION_STATE_CHANNEL_FILTERED;
+    }
+    length++;
+  }
+
+  measurementMessage[length++] = FanController_GetRules();
+  measurementMessage[length++] = LEDController_GetRules();
+  measurementMessage[length++] = LEDController_GetBrightness();
+  measurementMessage[length++] = Limiter_GetSeriesResistance() & 0xFF;
+  measurementMessage[length++] = (Limiter_GetSeriesResistance() >> 8) & 0xFF;
+  measurementMessage[length++] = PinController_GetPins();
+  measurementMessage[length++] = streamDecimation;
+  measurementMessage[length++] = streamBatchSize;
+  measurementMessage[length++] = telemetryFields & 0xFF;
+  measurementMessage[length++] = (telemetryFields >> 8) & 0xFF;
+  measurementMessage[length++] = acknowledge ? 1 : 0;
+  measurementMessage[length++] = ADC_GetWeights()->voltage;
+  measurementMessage[length++] = ADC_GetWeights()->current;
+  measurementMessage[length++] = ADC_GetWeightSource();
+  for (i = 0; i < ADC_CHANNEL_COUNT; i++)
+  {
+    measurementMessage[length++] = ADC_GetSampleRate((ADC_Channels)i) & 0xFF;
+    measurementMessage[length++] = (ADC_GetSampleRate((ADC_Channels)i) >> 8) & 0xFF;
+  }
+  for (i = 0; i < ADC_CHANNEL_COUNT; i++)
+  {
+    measurementMessage[length++] = ADC_GetFilter((ADC_Channels)i)->type;
+    measurementMessage[length++] = ADC_GetFilter((ADC_Channels)i)->length;
+  }
+  for (i = 0; i < COMMUNICATION_STATE_STATISTICS_COUNT; i++)
+  {
+    measurementMessage[length++] = counters[i] & 0xFF;
+    measurementMessage[length++] = (counters[i] >> 8) & 0xFF;
+  }
+
+  crc = CRC16(COMMUNICATION_CRC_POLYNOMIAL_VALUE, (const uint8_t *)measurementMessage, length);
+  measurementMessage[length++] = crc & 0xFF;
+  measurementMessage[length] = (crc >> 8) & 0xFF;
+}
+
+void Communication_Transmit(bool block)
+{
+  Communication_ResponsePart part;
+  int space;
+  uint8_t data;
+  uint8_t minimumSpace = (framing == Framing_SLIP) ? 2 : 1; /* escaped byte takes two bytes */
+
+  while (txCommand != ReadCommand_Invalid)
+  {
+    if (!Communication_GetResponsePart(txPart, &part))
+    {
+      Communication_WriteDelimiter();
+      txCommand = ReadCommand_Invalid; /* response finished */
+      break;
+    }
+
+    space = block ? COMMUNICATION_FRAME_MAXIMUM_LENGTH : SerialPort.availableForWrite();
+    while ((txOffset < part.length) && (space >= minimumSpace))
+    {
+      if (part.flash)
+      {
+        data = Flashreader_ReadByte(part.data + txOffset);
+      }
+      else
+      {
+        data = part.data[txOffset];
+      }
+      if (part.checksum)
+      {
+        txCRC = CRC16_AddByte(COMMUNICATION_CRC_POLYNOMIAL_VALUE, txCRC, data);
+      }
+      space -= Communication_WriteByte(data);
+      txOffset++;
+    }
+
+    if (txOffset < part.length)
+    {
+      return; /* transmit buffer is full, continue in the next loop pass */
+    }
+    txPart++;
+    txOffset = 0;
+  }
+
+  Communication_SendAcknowledges(block); /* Acknowledges do not split a response */
+}
+
+void Communication_SendAcknowledges(bool block)
+{
+  uint8_t acknowledgeMessage[COMMUNICATION_ACKNOWLEDGE_MESSAGE_LENGTH];
+  const Communication_PendingAcknowledge * pending;
+  uint16_t crc;
+
+  while ((acknowledgeCount > 0) && (txCommand == ReadCommand_Invalid))
+  {
+    if (!block && (SerialPort.availableForWrite() < ((framing == Framing_SLIP) ? COMMUNICATION_ACKNOWLEDGE_FRAME_MAXIMUM_LENGTH : COMMUNICATION_ACKNOWLEDGE_MESSAGE_LENGTH)))
+    {
+      return; /* transmit buffer is full, continue in the next loop pass */
+    }
+
+    pending = &acknowledgeQueue[acknowledgeTail];
+    acknowledgeMessage[0] = COMMUNICATION_ACKNOWLEDGE_HEADER;
+    acknowledgeMessage[1] = pending->sequence;
+    acknowledgeMessage[2] = pending->command;
+    acknowledgeMessage[3] = pending->status;
+    acknowledgeMessage[4] = pending->time & 0xFF;
+    acknowledgeMessage[5] = (pending->time >> 8) & 0xFF;
+    acknowledgeMessage[6] = (pending->time >> 16) & 0xFF;
+    acknowledgeMessage[7] = (pending->time >> 24) & 0xFF;
+
+    crc = CRC16(COMMUNICATION_CRC_POLYNOMIAL_VALUE, acknowledgeMessage, COMMUNICATION_ACKNOWLEDGE_MESSAGE_DATA_LENGTH);
+    acknowledgeMessage[8] = crc & 0xFF;
+    acknowledgeMessage[9] = (crc >> 8) & 0xFF;
+
+    Communication_WriteFrame(acknowledgeMessage, COMMUNICATION_ACKNOWLEDGE_MESSAGE_LENGTH);
+    acknowledgeTail = (acknowledgeTail + 1) & COMMUNICATION_ACKNOWLEDGE_QUEUE_MASK;
+    acknowledgeCount--;
+  }
+}
+
+bool Communication_GetResponsePart(uint8_t index, Communication_ResponsePart * part)
+{
+  part->flash = false;
+  part->checksum = true;
+
+  switch (txCommand)
+  {
+    case ReadCommand_Descriptor:
+      return Communication_GetDescriptorPart(index, part);
+    case ReadCommand_Burst:
+      return Communication_GetBurstPart(index, part);
+    case ReadCommand_Timing:
+      return Communication_GetTimingPart(index, part);
+#ifdef PROFILER
+    case ReadCommand_Profile:
+      return Communication_GetProfilePart(index, part);
+#endif
+    case ReadCommand_State:
+      part->data = measurementMessage;
+      part->length = COMMUNICATION_STATE_MESSAGE_LENGTH;
+      part->checksum = false;
+      return (index == 0);
+    case ReadCommand_Measurement:
+      part->data = txFrame;
+      part->length = txFrameLength;
+      part->checksum = false;
+      return (index == 0);
+    case ReadCommand_ErrorMessages:
+      if (index == 0)
+      {
+        txBuffer[0] = ErrorMessaging_ErrorNamesCount(); /* Send the message length in lines as the first byte */
+        part->data = txBuffer;
+        part->length = 1;
+        return true;
+      }
+      index--;
+      break;
+    default:
+      break;
+  }
+
+  /* Text lines, each line is followed by line end */
+  if (!Communication_GetResponseLine(index / 2, part))
+  {
+    return false;
+  }
+  if ((index & 1) == 1)
+  {
+    part->data = lineEnd;
+    part->length = sizeof(lineEnd);
+    part->flash = false;
+  }
+  return true;
+}
+
+bool Communication_GetResponseLine(uint8_t line, Communication_ResponsePart * part)
+{
+  switch (txCommand)
+  {
+    case ReadCommand_IDN:
+      if (line == 0)
+      {
+        return Communication_SetFlashPart(part, Name, sizeof(Name) - 1);
+      }
+      break;
+    case ReadCommand_QDC:
+      switch (line)
+      {
+        case 0:
+          return Communication_SetFlashPart(part, CalibrationDate, sizeof(CalibrationDate) - 1);
+        case 1:
+          return Communication_SetFlashPart(part, FirmwareVersion, sizeof(FirmwareVersion) - 1);
+        case 2:
+          return Communication_SetFlashPart(part, BoardRevision, sizeof(BoardRevision) - 1);
+        case 3:
+          return Communication_SetNumberPart(part, CURRENT_SETTER_MAXIMUM_HICURRENT + CURRENT_SETTER_MAXIMUM_HICURRENT / 65535);
+        case 4:
+          return Communication_SetNumberPart(part, AMMETER_MAXIMUM_CURRENT + AMMETER_MAXIMUM_CURRENT / 65535);
+        case 5:
+          return Communication_SetNumberPart(part, VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE + VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE / 65535);
+        case 6:
+          return Communication_SetNumberPart(part, VOLTMETER_MAXIMUM_VOLTAGE + VOLTMETER_MAXIMUM_VOLTAGE / 65535);
+        case 7:
+          return Communication_SetNumberPart(part, MAXIMUM_POWER);
+        case 8:
+          return Communication_SetNumberPart(part, VOLTMETER_INPUT_RESISTANCE);
+        case 9:
+          return Communication_SetNumberPart(part, LIMITER_MAXIMUM_TEMPERATURE);
+        default:
+          break;
+      }
+      break;
+    case ReadCommand_ErrorMessages:
+      if (line < ErrorMessaging_ErrorNamesCount())
+      {
+        return Communication_SetFlashPart(part, ErrorMessaging_GetErrorName(line), ErrorMessaging_GetErrorSize(line) - 1);
+      }
+      break;
+    default:
+      break;
+  }
+  return false;
+}
+
+bool Communication_GetDescriptorPart(uint8_t index, Communication_ResponsePart * part)
+{
+  part->data = txBuffer;
+
+  if ((index >= 1) && (index <= 8))
+  {
+    /* Strings: length followed by text */
+    if ((index & 1) == 1)
+    {
+      txBuffer[0] = DescriptorTextLengths[(index - 1) / 2];
+      part->length = 1;
+      return true;
+    }
+    return Communication_SetFlashPart(part, DescriptorTexts[(index - 1) / 2], DescriptorTextLengths[(index - 1) / 2]);
+  }
+
+  switch (index)
+  {
+    case 0:
+      txBuffer[0] = COMMUNICATION_DESCRIPTOR_HEADER;
+      txBuffer[1] = COMMUNICATION_DESCRIPTOR_DATA_LENGTH(sizeof(SerialNumber) + sizeof(CalibrationDate) + sizeof(FirmwareVersion) + sizeof(BoardRevision) - 4);
+      txBuffer[2] = COMMUNICATION_DESCRIPTOR_VERSION;
+      part->length = 3;
+      return true;
+    case 9:
+      return Communication_SetLongPart(part, CURRENT_SETTER_MAXIMUM_HICURRENT + CURRENT_SETTER_MAXIMUM_HICURRENT / 65535);
+    case 10:
+      return Communication_SetLongPart(part, AMMETER_MAXIMUM_CURRENT + AMMETER_MAXIMUM_CURRENT / 65535);
+    case 11:
+      return Communication_SetLongPart(part, VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE + VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE / 65535);
+    case 12:
+      return Communication_SetLongPart(part, VOLTMETER_MAXIMUM_VOLTAGE + VOLTMETER_MAXIMUM_VOLTAGE / 65535);
+    case 13:
+      return Communication_SetLongPart(part, MAXIMUM_POWER);
+    case 14:
+      return Communication_SetLongPart(part, VOLTMETER_INPUT_RESISTANCE);
+    case 15:
+      txBuffer[0] = LIMITER_MAXIMUM_TEMPERATURE;
+#ifdef ADC_TYPE_ADS1015
+      txBuffer[1] = 12; /* ADC resolution in bits */
+#elif defined(ADC_TYPE_ADS1115)
+      txBuffer[1] = 16;
+#endif
+#ifdef UNO
+      txBuffer[2] = Descriptor_UNO;
+#elif defined(ZERO)
+      txBuffer[2] = Descriptor_ZERO;
+#endif
+      txBuffer[3] = ADC_V_CHANNEL_FILTER_SIZE;
+      txBuffer[4] = ADC_I_CHANNEL_FILTER_SIZE;
+      txBuffer[5] = ADC_T_CHANNEL_FILTER_SIZE;
+      part->length = 6;
+      return true;
+    case 16:
+      /* Buffer sizes differ between the boards */
+      txBuffer[0] = COMMUNICATION_EXTENDED_MAXIMUM_DATA_LENGTH;
+      txBuffer[1] = COMMUNICATION_COMMAND_QUEUE_SIZE;
+      txBuffer[2] = COMMUNICATION_BATCH_MAXIMUM_SAMPLES;
+      txBuffer[3] = ADC_BURST_LENGTH & 0xFF;
+      txBuffer[4] = (ADC_BURST_LENGTH >> 8) & 0xFF;
+      part->length = 5;
+      return true;
+    case 17:
+      return Communication_SetLongPart(part, COMMUNICATION_FEATURES);
+    case 18:
+      /* CRC of everything transmitted before, it does not change while it is being transmitted */
+      txBuffer[0] = txCRC & 0xFF;
+      txBuffer[1] = (txCRC >> 8) & 0xFF;
+      part->length = COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH;
+      part->checksum = false;
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool Communication_GetBurstPart(uint8_t index, Communication_ResponsePart * part)
+{
+  static uint16_t sampleCount; /* Samples sent in this message */
+  const ADC_Burst * burst = ADC_GetBurst();
+  bool compose = (txOffset == 0);
+  uint8_t sampleParts;
+  uint8_t i;
+
+  part->data = txBuffer;
+
+  if (index == 0)
+  {
+    part->length = 15;
+    if (compose)
+    {
+      sampleCount = (burst->state == Burst_Done) ? burst->count : 0;
+      txBuffer[0] = COMMUNICATION_BURST_HEADER;
+      txBuffer[1] = COMMUNICATION_BURST_VERSION;
+      txBuffer[2] = burst->state;
+      txBuffer[3] = burst->channel;
+      txBuffer[4] = Measurement_GetBurstRange();
+      txBuffer[5] = burst->length & 0xFF;
+      txBuffer[6] = (burst->length >> 8) & 0xFF;
+      txBuffer[7] = burst->count & 0xFF;
+      txBuffer[8] = (burst->count >> 8) & 0xFF;
+      txBuffer[9] = burst->missedSamples & 0xFF;
+      txBuffer[10] = (burst->missedSamples >> 8) & 0xFF;
+      Communication_PutLong(txBuffer, 11, (burst->count > 0) ? (burst->lastTime - burst->firstTime) : 0);
+    }
+    return true;
+  }
+  index--;
+
+  sampleParts = (sampleCount + COMMUNICATION_BURST_PART_SAMPLES - 1) / COMMUNICATION_BURST_PART_SAMPLES;
+  if (index < sampleParts)
+  {
+    uint16_t first = (uint16_t)index * COMMUNICATION_BURST_PART_SAMPLES;
+    uint8_t samples = ((sampleCount - first) < COMMUNICATION_BURST_PART_SAMPLES) ? (sampleCount - first) : COMMUNICATION_BURST_PART_SAMPLES;
+    part->length = 4 * samples;
+    if (compose)
+    {
+      for (i = 0; i < samples; i++)
+      {
+        Communication_PutLong(txBuffer, 4 * i, (uint32_t)Measurement_GetBurstSample(first + i));
+      }
+    }
+    return true;
+  }
+  index -= sampleParts;
+
+  if (index == 0)
+  {
+    part->length = COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH;
+    part->checksum = false;
+    if (compose)
+    {
+      txBuffer[0] = txCRC & 0xFF;
+      txBuffer[1] = (txCRC >> 8) & 0xFF;
+      if (sampleCount > 0)
+      {
+        ADC_ReleaseBurst(); /* Every sample was sent */
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+bool Communication_GetTimingPart(uint8_t index, Communication_ResponsePart * part)
+{
+  uint8_t taskCount = Scheduler_GetTaskCount();
+  bool compose = (txOffset == 0);
+
+  part->data = txBuffer;
+
+  if (index == 0)
+  {
+    part->length = 7;
+    if (compose)
+    {
+      txBuffer[0] = COMMUNICATION_TIMING_HEADER;
+      txBuffer[1] = COMMUNICATION_TIMING_VERSION;
+      Communication_PutLong(txBuffer, 2, millis() - timingStart);
+      txBuffer[6] = taskCount;
+    }
+    return true;
+  }
+  index--;
+
+  if (index < taskCount)
+  {
+    part->length = 8;
+    if (compose)
+    {
+      const Scheduler_TaskStatistics * statistics = Scheduler_GetStatistics(index);
+      Communication_PutLong(txBuffer, 0, statistics->runs);
+      txBuffer[4] = statistics->lateRuns & 0xFF;
+      txBuffer[5] = (statistics->lateRuns >> 8) & 0xFF;
+      txBuffer[6] = statistics->maximumLateness & 0xFF;
+      txBuffer[7] = (statistics->maximumLateness >> 8) & 0xFF;
+    }
+    return true;
+  }
+  index -= taskCount;
+
+  if (index < 3)
+  {
+    /* Control tick: counters and two halves of the jitter histogram */
+    part->length = 8;
+    if (compose)
+    {
+      const ControlTick_Statistics * statistics = ControlTick_GetStatistics();
+      uint8_t i;
+      if (index == 0)
+      {
+        Communication_PutLong(txBuffer, 0, statistics->ticks);
+        txBuffer[4] = statistics->overruns & 0xFF;
+        txBuffer[5] = (statistics->overruns >> 8) & 0xFF;
+        txBuffer[6] = statistics->maximumJitter & 0xFF;
+        txBuffer[7] = (statistics->maximumJitter >> 8) & 0xFF;
+      }
+      else
+      {
+        for (i = 0; i < (CONTROLTICK_HISTOGRAM_BINS / 2); i++)
+        {
+          uint16_t bin = statistics->histogram[(index - 1) * (CONTROLTICK_HISTOGRAM_BINS / 2) + i];
+          txBuffer[2 * i] = bin & 0xFF;
+          txBuffer[2 * i + 1] = (bin >> 8) & 0xFF;
+        }
+      }
+    }
+    return true;
+  }
+  index -= 3;
+
+  if (index == 0)
+  {
+    part->length = COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH;
+    part->checksum = false;
+    if (compose)
+    {
+      txBuffer[0] = txCRC & 0xFF;
+      txBuffer[1] = (txCRC >> 8) & 0xFF;
+      Scheduler_ResetStatistics(); /* Start a new window */
+      ControlTick_ResetStatistics();
+      timingStart = millis();
+    }
+    return true;
+  }
+  return false;
+}
+
+#ifdef PROFILER
+bool Communication_GetProfilePart(uint8_t index, Communication_ResponsePart * part)
+{
+  uint8_t taskCount = Scheduler_GetTaskCount();
+  bool compose = (txOffset == 0);
+  uint32_t window;
+
+  part->data = txBuffer;
+
+  if (index == 0)
+  {
+    part->length = 8;
+    if (compose)
+    {
+      txBuffer[0] = COMMUNICATION_PROFILE_HEADER;
+      txBuffer[1] = COMMUNICATION_PROFILE_VERSION;
+      Communication_PutLong(txBuffer, 2, Profiler_GetWindow());
+      txBuffer[6] = PROFILER_FIXED_PROBES_COUNT;
+      txBuffer[7] = taskCount;
+    }
+    return true;
+  }
+  index--;
+
+  if (index < PROFILER_FIXED_PROBES_COUNT)
+  {
+    part->length = 10;
+    if (compose)
+    {
+      Communication_PutProbe(index);
+    }
+    return true;
+  }
+  index -= PROFILER_FIXED_PROBES_COUNT;
+
+  if (index < taskCount)
+  {
+    part->length = 10;
+    if (compose)
+    {
+      Communication_PutProbe(Probe_Tasks + index);
+    }
+    return true;
+  }
+  index -= taskCount;
+
+  if (index < ADC_CHANNEL_COUNT)
+  {
+    part->length = 8;
+    if (compose)
+    {
+      const Profiler_Channel * channel = Profiler_GetChannel(index);
+      uint32_t rate = 0;
+      window = Profiler_GetWindow();
+      if (window > 0)
+      {
+        rate = (uint32_t)(((uint64_t)channel->samples * 1000ULL) / window);
+      }
+      Communication_PutLong(txBuffer, 0, channel->samples);
+      txBuffer[4] = channel->missedSamples & 0xFF;
+      txBuffer[5] = (channel->missedSamples >> 8) & 0xFF;
+      txBuffer[6] = (rate > 0xFFFF) ? 0xFF : (rate & 0xFF);
+      txBuffer[7] = (rate > 0xFFFF) ? 0xFF : ((rate >> 8) & 0xFF);
+    }
+    return true;
+  }
+  index -= ADC_CHANNEL_COUNT;
+
+  if (index == 0)
+  {
+    part->length = 2 * FILTER_TYPES_COUNT;
+    if (compose)
+    {
+      for (index = 0; index < FILTER_TYPES_COUNT; index++)
+      {
+        txBuffer[2 * index] = Profiler_GetFilterCycles(index) & 0xFF;
+        txBuffer[2 * index + 1] = (Profiler_GetFilterCycles(index) >> 8) & 0xFF;
+      }
+    }
+    return true;
+  }
+  index--;
+
+  if (index == 0)
+  {
+    part->length = COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH;
+    part->checksum = false;
+    if (compose)
+    {
+      txBuffer[0] = txCRC & 0xFF;
+      txBuffer[1] = (txCRC >> 8) & 0xFF;
+      Profiler_Reset(); /* Start a new window */
+    }
+    return true;
+  }
+  return false;
+}
+
+void Communication_PutProbe(uint8_t probe)
+{
+  const Profiler_Probe * profilerProbe = Profiler_GetProbe(probe);
+  uint16_t minimum = (profilerProbe->calls > 0) ? profilerProbe->minimum : 0;
+  uint16_t mean = Profiler_GetMean(probe);
+
+  Communication_PutLong(txBuffer, 0, profilerProbe->calls);
+  txBuffer[4] = minimum & 0xFF;
+  txBuffer[5] = (minimum >> 8) & 0xFF;
+  txBuffer[6] = profilerProbe->maximum & 0xFF;
+  txBuffer[7] = (profilerProbe->maximum >> 8) & 0xFF;
+  txBuffer[8] = mean & 0xFF;
+  txBuffer[9] = (mean >> 8) & 0xFF;
+}
+#endif
+
+bool Communication_SetFlashPart(Communication_ResponsePart * part, const char * text, uint8_t textLength)
+{
+  part->data = (const uint8_t *)text;
+  part->length = textLength;
+  part->flash = true;
+  return true;
+}
+
+bool Communication_SetNumberPart(Communication_ResponsePart * part, uint32_t value)
+{
+  ultoa(value, (char *)txBuffer, 10);
+  part->data = txBuffer;
+  part->length = strlen((const char *)txBuffer);
+  return true;
+}
+
+bool Communication_SetLongPart(Communication_ResponsePart * part, uint32_t value)
+{
+  txBuffer[0] = value & 0xFF;
+  txBuffer[1] = (value >> 8) & 0xFF;
+  txBuffer[2] = (value >> 16) & 0xFF;
+  txBuffer[3] = (value >> 24) & 0xFF;
+  part->data = txBuffer;
+  part->length = 4;
+  return true;
+}
+
+uint8_t Communication_GetStatusFlag(void)
+{
+  uint8_t statusFlag = 0;
+
+  if (Control_GetCCCV() == Control_CCCV_CV) /* Bit 0: Mode CV */
+  {
+    statusFlag |= 1 << 0;
+  }
+  if (RangeSwitcher_GetVoltageRange() == VoltageRange_LowVoltage) /* Bit 1: Low voltage range */
+  {
+    statusFlag |= 1 << 1;
+  }
+  if (RangeSwitcher_GetCurrentRange() == CurrentRange_LowCurrent) /* Bit 2: Low current range */
+  {
+    statusFlag |= 1 << 2;
+  }
+  if (LED_Get()) /* Bit 3: LED on */
+  {
+    statusFlag |= 1 << 3;
+  }
+  if (Fan_Get() == Fan_On) /* Bit 4: Fan on */
+  {
+    statusFlag |= 1 << 4;
+  }
+  if (Voltmeter_GetMode() == Voltmeter_4Terminal) /* Bit 5: 4-wire mode */
+  {
+    statusFlag |= 1 << 5;
+  }
+  return statusFlag;
+}
+
+void Communication_InitWriteCommandCursor(Communication_WriteCommandCursor * cursor, uint32_t commands)
+{
+  uint8_t i;
+
+  cursor->position = commandQueueHead;
+  cursor->commands = commands;
+  for (i = 0; i < commandCursorCount; i++)
+  {
+    if (commandCursors[i] == cursor)
+    {
+      return; /* already registered */
+    }
+  }
+  if (commandCursorCount < COMMUNICATION_COMMAND_CURSORS_MAXIMUM)
+  {
+    commandCursors[commandCursorCount++] = cursor;
+  }
+}
+
+const Communication_Command * Communication_GetNextWriteCommand(Communication_WriteCommandCursor * cursor)
+{
+  const Communication_Command * queuedCommand;
+
+  while (cursor->position != commandQueueHead)
+  {
+    queuedCommand = &commandQueue[cursor->position & COMMUNICATION_COMMAND_QUEUE_MASK];
+    cursor->position++;
+    if (COMMUNICATION_IS_ADDRESSED(queuedCommand->command, cursor->commands))
+    {
+      return queuedCommand;
+    }
+  }
+  return NULL; /* no new command */
+}
+
+void Communication_AcknowledgeCommand(const Communication_Command * command, Communication_AcknowledgeStatus status)
+{
+  Communication_PendingAcknowledge pending;
+
+  pending.sequence = command->sequence;
+  pending.command = command->command;
+  pending.status = status;
+  pending.time = micros(); /* Time when the module applied the command, not when the message is sent */
+  Communication_Acknowledge(&pending);
+}
+
+void Communication_Acknowledge(const Communication_PendingAcknowledge * pending)
+{
+  if (!acknowledge)
+  {
+    return;
+  }
+
+  if (acknowledgeCount >= COMMUNICATION_ACKNOWLEDGE_QUEUE_SIZE)
+  {
+    Communication_Transmit(true); /* Queue is full, finish the response in progress and send the waiting acknowledges */
+  }
+
+  acknowledgeQueue[(acknowledgeTail + acknowledgeCount) & COMMUNICATION_ACKNOWLEDGE_QUEUE_MASK] = *pending;
+  acknowledgeCount++;
+}
+
+bool Communication_IsAcknowledgeDistinct(Communication_Framings newFraming, uint16_t newTelemetryFields)
+{
+  return (newFraming == Framing_SLIP) || (newTelemetryFields != 0);
+}
+
+const Communication_ReadCommand * Communication_GetReadCommand(void)
+{
+  return &readCommand;
+}
+
+const Communication_Statistics * Communication_GetStatistics(void)
+{
+  return &statistics;
+}
+
+const ErrorMessaging_Error * Communication_GetError(void)
+{
+  return &communicationError;
+}
+
+uint16_t CRC16(const uint16_t polynomial, const uint8_t * data, uint8_t dataLength)
+{
+  uint16_t crc = 0;
+  for (uint8_t i = 0; i < dataLength; i++)
+  {
+    crc = CRC16_AddByte(polynomial, crc, data[i]);
+  }
+  return crc;
+}
+
+uint16_t CRC16_AddByte(const uint16_t polynomial, uint16_t crc, uint8_t data)
+{
+  crc ^= (((uint16_t)data) << 8);
+  for (uint8_t j = 0; j < 8; j++)
+  {
+    if ((crc & 0x8000U) > 0)
+    {
+      crc = (crc << 1) ^ polynomial;
+    }
+    else
+    {
+      crc = crc << 1;
     }
   }
   return crc;
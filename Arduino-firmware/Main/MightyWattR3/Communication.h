@@ -21,15 +21,99 @@
 
 #define COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH       4
 #define COMMUNICATION_PAYLOAD_MAXIMUM_LENGTH            (COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH)
-#define COMMUNICATION_BAUDRATE                          500000
-#define COMMUNICATION_TIMEOUT                           200 /* ms */
+#define COMMUNICATION_BAUDRATE                          500000 /* Default baud rate, used after reset and as the fallback of unconfirmed baud rate change */
+#define COMMUNICATION_BAUDRATE_CONFIRM_TIMEOUT          500 /* ms, a valid frame must be received at the new baud rate within this time, otherwise the default baud rate is restored */
+#define COMMUNICATION_TIMEOUT                           200 /* ms, maximum time between the header and the last byte of a frame */
+#ifdef UNO
+  #define COMMUNICATION_RX_BUFFER_SIZE                  64 /* Receive ring buffer, must be a power of two and hold at least one whole extended frame */
+#elif defined(ZERO)
+  #define COMMUNICATION_RX_BUFFER_SIZE                  128 /* Receive ring buffer, must be a power of two and hold at least one whole extended frame */
+#endif
+#define COMMUNICATION_RX_BUFFER_MASK                    (COMMUNICATION_RX_BUFFER_SIZE - 1)
 #define COMMUNICATION_RW(x)                             ((x & 0x80) >> 7)
 #define COMMUNICATION_DATA_LENGTH(x)                    ((x & 0x60) >> 5) /* 0 = 0 bytes, 1 = 1 byte, 2 = 2 bytes, 3 = 4 bytes*/
 #define COMMUNICATION_COMMAND(x)                        (x & 0x1F)
+#define COMMUNICATION_COMMAND_EXTENDED                  0x1F /* Header command of extended frame: header, command, data length, data, CRC */
+#define COMMUNICATION_EXTENDED_HEADER_LENGTH            3 /* header, command and data length */
+#ifdef UNO
+  #define COMMUNICATION_EXTENDED_MAXIMUM_DATA_LENGTH    32
+#elif defined(ZERO)
+  #define COMMUNICATION_EXTENDED_MAXIMUM_DATA_LENGTH    64
+#endif
 #define COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH        2
+#define COMMUNICATION_FRAME_MAXIMUM_LENGTH              (COMMUNICATION_EXTENDED_HEADER_LENGTH + COMMUNICATION_EXTENDED_MAXIMUM_DATA_LENGTH + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH)
+#define COMMUNICATION_SLIP_END                          0xC0 /* SLIP frame delimiter, sent before and after every frame */
+#define COMMUNICATION_SLIP_ESC                          0xDB /* SLIP escape, followed by COMMUNICATION_SLIP_ESC_END or COMMUNICATION_SLIP_ESC_ESC */
+#define COMMUNICATION_SLIP_ESC_END                      0xDC /* Escaped COMMUNICATION_SLIP_END */
+#define COMMUNICATION_SLIP_ESC_ESC                      0xDD /* Escaped COMMUNICATION_SLIP_ESC */
 #define COMMUNICATION_CRC_POLYNOMIAL_VALUE              0x1021U /* CRC-16 CCITT */
 #define COMMUNICATION_MEASUREMENT_MESSAGE_DATA_LENGTH   15
 #define COMMUNICATION_MEASUREMENT_MESSAGE_LENGTH        (COMMUNICATION_MEASUREMENT_MESSAGE_DATA_LENGTH + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH)
+#define COMMUNICATION_FIELDS_HEADER                     0xFC /* First byte of the telemetry fields message, followed by the 16-bit field mask */
+#define COMMUNICATION_FIELDS_MESSAGE_MAXIMUM_DATA_LENGTH (3 + 8 * 4 + 2 + 3 + 4 + 4 + 2) /* header and mask, 8 long values, DAC, temperature + status + pins, error flags, timestamp, sequence */
+#define COMMUNICATION_FIELDS_MESSAGE_MAXIMUM_LENGTH     (COMMUNICATION_FIELDS_MESSAGE_MAXIMUM_DATA_LENGTH + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH)
+#ifdef UNO
+  #define COMMUNICATION_BATCH_MAXIMUM_SAMPLES           8 /* Maximum number of samples in one batched measurement message */
+#elif defined(ZERO)
+  #define COMMUNICATION_BATCH_MAXIMUM_SAMPLES           16 /* Maximum number of samples in one batched measurement message */
+#endif
+#define COMMUNICATION_BATCH_STATUS_FLAG                 0x20 /* Batch header flag: temperature, status and pins are appended */
+#define COMMUNICATION_BATCH_ERRORS_FLAG                 0x40 /* Batch header flag: error flags are appended */
+#define COMMUNICATION_BATCH_SAMPLES(x)                  (x & 0x1F)
+#define COMMUNICATION_BATCH_DIFFERENCE_MAXIMUM          32767L /* Differences are sent as int16_t */
+#define COMMUNICATION_BATCH_DIFFERENCE_MINIMUM          (-32768L)
+#define COMMUNICATION_BATCH_MAXIMUM_DATA_LENGTH         (1 + 8 + 4 * (COMMUNICATION_BATCH_MAXIMUM_SAMPLES - 1) + 3 + 4) /* header, base I and V, I and V deltas, status, errors */
+#define COMMUNICATION_BATCH_MAXIMUM_LENGTH              (COMMUNICATION_BATCH_MAXIMUM_DATA_LENGTH + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH)
+#define COMMUNICATION_ACKNOWLEDGE_HEADER                0xFA /* First byte of the acknowledge message */
+#define COMMUNICATION_ACKNOWLEDGE_MESSAGE_DATA_LENGTH   8 /* header, sequence, command, status, micros */
+#define COMMUNICATION_ACKNOWLEDGE_MESSAGE_LENGTH        (COMMUNICATION_ACKNOWLEDGE_MESSAGE_DATA_LENGTH + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH)
+#define COMMUNICATION_ACKNOWLEDGE_FRAME_MAXIMUM_LENGTH  (2 * COMMUNICATION_ACKNOWLEDGE_MESSAGE_LENGTH + 2) /* Acknowledge message with every byte escaped and both SLIP delimiters */
+#ifdef UNO
+  #define COMMUNICATION_ACKNOWLEDGE_QUEUE_SIZE          4 /* Acknowledges waiting for the response in progress, must be a power of two */
+#elif defined(ZERO)
+  #define COMMUNICATION_ACKNOWLEDGE_QUEUE_SIZE          8 /* Acknowledges waiting for the response in progress, must be a power of two */
+#endif
+#define COMMUNICATION_ACKNOWLEDGE_QUEUE_MASK            (COMMUNICATION_ACKNOWLEDGE_QUEUE_SIZE - 1)
+#define COMMUNICATION_DESCRIPTOR_HEADER                 0xFB /* First byte of the capability descriptor message */
+#define COMMUNICATION_DESCRIPTOR_VERSION                2 /* Version of the capability descriptor layout */
+#define COMMUNICATION_DESCRIPTOR_DATA_LENGTH(texts)     (1 + 4 + (texts) + 6 * 4 + 3 + 3 + 5 + 4) /* version, 4 string lengths and texts, 6 limits, temperature + ADC + board, filter sizes, buffer sizes, features */
+#define COMMUNICATION_STATE_HEADER                      0xFD /* First byte of the state snapshot message */
+#define COMMUNICATION_STATE_VERSION                     4 /* Version of the state snapshot layout */
+#define COMMUNICATION_STATE_STATISTICS_COUNT            6 /* Counters of Communication_Statistics in the state snapshot message */
+#define COMMUNICATION_STATE_MESSAGE_DATA_LENGTH         (3 + 1 + 4 * 4 + 2 + 2 + 3 + 3 + 2 + 1 + 2 + 2 + 1 + 3 + 3 * 2 + 3 * 2 + COMMUNICATION_STATE_STATISTICS_COUNT * 2) /* header, length and version, mode, set values, DAC, status + autorange, ADC channels, rules and brightness, series resistance, pins, stream, telemetry fields, acknowledge, channel weights, sample rates, filters, communication statistics */
+#define COMMUNICATION_STATE_MESSAGE_LENGTH              (COMMUNICATION_STATE_MESSAGE_DATA_LENGTH + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH)
+#define COMMUNICATION_MESSAGE_BUFFER_LENGTH             ((COMMUNICATION_STATE_MESSAGE_LENGTH > COMMUNICATION_FIELDS_MESSAGE_MAXIMUM_LENGTH) ? COMMUNICATION_STATE_MESSAGE_LENGTH : COMMUNICATION_FIELDS_MESSAGE_MAXIMUM_LENGTH) /* Measurement, telemetry fields or state snapshot message */
+#define COMMUNICATION_STATE_CHANNEL_AUTORANGE           0x40 /* ADC channel byte of the state snapshot: autoranging is on */
+#define COMMUNICATION_STATE_CHANNEL_FILTERED            0x80 /* ADC channel byte of the state snapshot: values are filtered */
+#define COMMUNICATION_FEATURES                          (Feature_MeasurementStream | Feature_BatchedMeasurements | Feature_ExtendedFrames | Feature_BatchCommands | Feature_CommandQueue | Feature_Acknowledge | Feature_TelemetryFields | Feature_StateReadback | Feature_SLIPFraming | Feature_BaudRate | Feature_Burst | Feature_ChannelWeights | Feature_FilterBank | Feature_Timing | COMMUNICATION_PROFILER_FEATURE)
+#ifdef PROFILER
+  #define COMMUNICATION_PROFILER_FEATURE                Feature_Profiler
+#else
+  #define COMMUNICATION_PROFILER_FEATURE                0
+#endif
+#define COMMUNICATION_PROFILE_HEADER                    0xF9 /* First byte of the profile message */
+#define COMMUNICATION_PROFILE_VERSION                   5 /* Version of the profile message layout */
+#define COMMUNICATION_BURST_HEADER                      0xF8 /* First byte of the burst message */
+#define COMMUNICATION_BURST_VERSION                     1 /* Version of the burst message layout */
+#define COMMUNICATION_BURST_PART_SAMPLES                8 /* Burst samples composed at once */
+#define COMMUNICATION_TIMING_HEADER                     0xF7 /* First byte of the timing message */
+#define COMMUNICATION_TIMING_VERSION                    1 /* Version of the timing message layout */
+#ifdef UNO
+  #define COMMUNICATION_COMMAND_QUEUE_SIZE              8 /* Received write commands waiting for the modules, must be a power of two, at most 128 */
+#elif defined(ZERO)
+  #define COMMUNICATION_COMMAND_QUEUE_SIZE              16 /* Received write commands waiting for the modules, must be a power of two, at most 128 */
+#endif
+#define COMMUNICATION_COMMAND_QUEUE_MASK                (COMMUNICATION_COMMAND_QUEUE_SIZE - 1)
+#ifdef UNO
+  #define COMMUNICATION_PAYLOAD_POOL_SIZE               64 /* Data of the queued commands, holds at least two frames, at most 255 */
+#elif defined(ZERO)
+  #define COMMUNICATION_PAYLOAD_POOL_SIZE               128 /* Data of the queued commands, holds at least two frames, at most 255 */
+#endif
+#define COMMUNICATION_PAYLOAD_SLOT_LENGTH(dataLength)   (((dataLength) > COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH) ? (dataLength) : COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH) /* Pool bytes of a command, shorter data are padded */
+#define COMMUNICATION_COMMAND_CURSORS_MAXIMUM           12 /* Maximum number of modules reading the command queue */
+#define COMMUNICATION_COMMAND_BIT(x)                    (1UL << (x)) /* Command mask bit of a write command lower than 32 */
+#define COMMUNICATION_ALL_COMMANDS                      0xFFFFFFFFUL /* Command mask of a module that reads all write commands including the extended ones */
+#define COMMUNICATION_IS_ADDRESSED(command, mask)       (((command) < 32) ? (((mask) & COMMUNICATION_COMMAND_BIT(command)) != 0) : ((mask) == COMMUNICATION_ALL_COMMANDS))
 #define COMMUNICATION_READ                              0
 #define COMMUNICATION_WRITE                             1
 
@@ -40,7 +124,7 @@
 
 /**
  * Write commands
- * Max 31
+ * Max 30 in standard frames, 31 is reserved for extended frames that can carry any non-zero command
  */
 enum Communication_WriteCommands : uint8_t
 {
@@ -63,11 +147,33 @@ enum Communication_WriteCommands : uint8_t
   WriteCommand_CurrentRangeAuto = 16,
   WriteCommand_VoltageRangeAuto = 17,
   WriteCommand_Pins = 18,
+  WriteCommand_MeasurementStream = 19, /* data[0]: 0 = off (measurement on request), N = send average of every N measurements without request; the host must still send commands to feed the communication watchdog
+                                          data[1]: 0 or 1 = measurement messages, 2 to COMMUNICATION_BATCH_MAXIMUM_SAMPLES = batched measurement messages with this many samples */
+  WriteCommand_Batch = 20, /* data: sequence of at most COMMUNICATION_COMMAND_QUEUE_SIZE sub-commands, each is a standard header byte (RW bit ignored) followed by its data, usually sent in an extended frame
+                              all sub-commands are applied in order within one loop pass; a malformed batch or a nested batch is rejected as a whole */
+  WriteCommand_Acknowledge = 21, /* data[0]: 0 = write commands are not acknowledged, 1 = every write command is answered by an acknowledge message
+                                    (header, sequence, command, Communication_AcknowledgeStatus, micros() when applied, CRC); sequence counts queued commands incl. batch sub-commands
+                                    enabling requires Framing_SLIP or telemetry fields, otherwise the host cannot tell the acknowledge message from the fixed measurement message
+                                    and the command is ignored (Acknowledge_InvalidValue); WriteCommand_Framing and WriteCommand_TelemetryFields that would break this while acknowledging are ignored the same way */
+  WriteCommand_TelemetryFields = 22, /* data[0..1]: Communication_TelemetryFields to send instead of the fixed measurement message, 0 = fixed measurement message
+                                        the message is header, field mask, selected fields in the order of their bits, CRC; batched measurement messages are not affected */
+  WriteCommand_Framing = 23, /* data[0]: Communication_Framings of all following frames in both directions, the acknowledge message of this command is already framed by the new framing
+                                framing returns to Framing_Raw when the communication watchdog resets the port */
+  WriteCommand_BaudRate = 24, /* data[0..3]: new baud rate; the command is acknowledged at the present baud rate, then the port switches to the new one
+                                 the host confirms the new baud rate by sending any valid frame within COMMUNICATION_BAUDRATE_CONFIRM_TIMEOUT, otherwise the port returns to COMMUNICATION_BAUDRATE
+                                 UNO accepts baud rates from COMMUNICATION_BAUDRATE to F_CPU / 8 with zero error (500000, 1000000, 2000000 at 16 MHz), ZERO accepts any rate from COMMUNICATION_BAUDRATE (USB serial port) */
+  WriteCommand_Burst = 25, /* data[0]: ADC channel (0 = voltage, 1 = current), data[1..2]: number of samples, 0 = ADC_BURST_LENGTH, data[3]: reserved, 0
+                              captures the channel at the maximum data rate; voltage, current and temperature are not measured until the burst is done, read by ReadCommand_Burst
+                              on UNO the samples take the voltage and current filter histories: both channels are unfiltered and WriteCommand_Filter is refused for them until the burst is read */
+  WriteCommand_ChannelWeights = 26, /* data[0]: voltage channel weight, data[1]: current channel weight (1 to ADC_WEIGHT_MAXIMUM each), both 0 = weights by the control mode
+                                       the channel with the higher weight is converted more often and triggers the measurement, the achieved rates are in ReadCommand_State */
+  WriteCommand_Filter = 27, /* data[0]: ADC channel (0 = voltage, 1 = current, 2 = temperature), data[1]: Filter_Types, data[2]: length (IIR: shift), data[3]: reserved, 0
+                               the filter is used when the measurement speed filters the channel, it starts again from the last value */
 };
 
 /**
  * Read commands
- * Max 31
+ * Max 30 in standard frames, 31 is reserved for extended frames that can carry any non-zero command
  */
 enum Communication_ReadCommands : uint8_t
 {
@@ -75,7 +181,102 @@ enum Communication_ReadCommands : uint8_t
   ReadCommand_Measurement = 1,
   ReadCommand_IDN = 2,
   ReadCommand_QDC = 3,
-  ReadCommand_ErrorMessages = 4
+  ReadCommand_ErrorMessages = 4,
+  ReadCommand_Descriptor = 5, /* binary capability descriptor: header, data length, version, SN, calibration date, firmware version, board revision (each length + text),
+                                maximum set current, maximum measured current, maximum set voltage, maximum measured voltage, maximum power, voltmeter input resistance (uint32_t each),
+                                maximum temperature, ADC resolution, Communication_DescriptorBoards, V, I and T filter sizes,
+                                COMMUNICATION_EXTENDED_MAXIMUM_DATA_LENGTH, COMMUNICATION_COMMAND_QUEUE_SIZE, COMMUNICATION_BATCH_MAXIMUM_SAMPLES, ADC_BURST_LENGTH (uint16_t),
+                                Communication_Features (uint32_t), CRC */
+  ReadCommand_State = 6, /* binary state snapshot: header, data length, version, mode (write command number), set current, set voltage, set power, set resistance (uint32_t each), DAC (uint16_t),
+                           status flag, autorange (bit 0 current, bit 1 voltage), V, I and T channel (bits 0-2 PGA, bits 3-5 data rate, bit 6 autorange, bit 7 filtered),
+                           fan rules, LED rules, LED brightness, series resistance (uint16_t), pins, stream decimation, batch size, telemetry fields (uint16_t), acknowledge,
+                           voltage and current channel weight, ADC_WeightSources, V, I and T samples per second (uint16_t each), V, I and T filter (Filter_Types and length each),
+                           Communication_Statistics: timeouts, CRC errors, rejected commands, queue overflows, framing errors, baud rate fallbacks (uint16_t each, cleared by Communication_Init), CRC */
+  ReadCommand_Profile = 7, /* only with PROFILER defined; header, version, window in ms (uint32_t), number of fixed probes, number of tasks,
+                             fixed probes (Profiler_Probes: loop pass, ADC I2C write, ADC I2C read, DAC I2C write, ADC conversion ready to read latency) and then tasks in the order of priority,
+                             each probe: calls (uint32_t), minimum, maximum and mean time in us (uint16_t each),
+                             V, I and T channels: samples (uint32_t), missed samples, samples per second (uint16_t each),
+                             CPU cycles per sample of each Filter_Types measured at startup (uint16_t each), CRC; all values except the filter cycles are cleared after the message is sent
+                             task lateness and the control tick are in ReadCommand_Timing */
+  ReadCommand_Burst = 8, /* header, version, ADC_BurstStates, ADC channel, hardware range (RangeSwitcher ranges), requested samples, captured samples, missed samples (uint16_t each),
+                           time from the first to the last sample in us (uint32_t), captured samples in uV or uA (int32_t each, MEASUREMENT_BURST_MISSED_SAMPLE if missed; only when the burst is done), CRC;
+                           the samples are released after they were sent and the burst returns to Burst_Idle */
+  ReadCommand_Timing = 9 /* header, version, window in ms (uint32_t), number of tasks, tasks in the order of priority: runs (uint32_t), late runs, maximum lateness in us (uint16_t each),
+                            control tick: ticks (uint32_t), overruns, maximum jitter in us, jitter histogram (CONTROLTICK_HISTOGRAM_BINS, uint16_t each), CRC; all values are cleared after the message is sent */
+};
+
+/**
+ * Fields of the telemetry fields message, in the order they are sent (LSB first)
+ */
+enum Communication_TelemetryFields : uint16_t
+{
+  Field_Current = 1U << 0, /* uint32_t, uA (averaged when streamed) */
+  Field_Voltage = 1U << 1, /* uint32_t, uV (averaged when streamed) */
+  Field_Power = 1U << 2, /* uint32_t, uW */
+  Field_Resistance = 1U << 3, /* uint32_t, mOhm */
+  Field_UnfilteredCurrent = 1U << 4, /* uint32_t, uA */
+  Field_UnfilteredVoltage = 1U << 5, /* uint32_t, uV */
+  Field_UnfilteredPower = 1U << 6, /* uint32_t, uW */
+  Field_UnfilteredResistance = 1U << 7, /* uint32_t, mOhm */
+  Field_DAC = 1U << 8, /* uint16_t, DAC code */
+  Field_Temperature = 1U << 9, /* uint8_t, deg C */
+  Field_Status = 1U << 10, /* uint8_t, status flag word */
+  Field_Pins = 1U << 11, /* uint8_t, user pins */
+  Field_ErrorFlags = 1U << 12, /* uint32_t, error flags */
+  Field_Timestamp = 1U << 13, /* uint32_t, device micros() of the measurement (of the last averaged one when streamed), intentional wraparound */
+  Field_Sequence = 1U << 14 /* uint16_t, measurement sequence number (of the last averaged one when streamed), gaps show skipped measurements */
+};
+
+/**
+ * Board type in the capability descriptor
+ */
+enum Communication_DescriptorBoards : uint8_t
+{
+  Descriptor_UNO = 0,
+  Descriptor_ZERO = 1
+};
+
+/**
+ * Feature bits in the capability descriptor
+ */
+enum Communication_Features : uint32_t
+{
+  Feature_MeasurementStream = 1UL << 0, /* WriteCommand_MeasurementStream */
+  Feature_BatchedMeasurements = 1UL << 1, /* batch size in WriteCommand_MeasurementStream */
+  Feature_ExtendedFrames = 1UL << 2, /* COMMUNICATION_COMMAND_EXTENDED */
+  Feature_BatchCommands = 1UL << 3, /* WriteCommand_Batch */
+  Feature_CommandQueue = 1UL << 4, /* write commands are queued, not overwritten */
+  Feature_Acknowledge = 1UL << 5, /* WriteCommand_Acknowledge */
+  Feature_TelemetryFields = 1UL << 6, /* WriteCommand_TelemetryFields */
+  Feature_StateReadback = 1UL << 7, /* ReadCommand_State */
+  Feature_SLIPFraming = 1UL << 8, /* WriteCommand_Framing */
+  Feature_BaudRate = 1UL << 9, /* WriteCommand_BaudRate */
+  Feature_Profiler = 1UL << 10, /* ReadCommand_Profile */
+  Feature_Burst = 1UL << 11, /* WriteCommand_Burst, ReadCommand_Burst */
+  Feature_ChannelWeights = 1UL << 12, /* WriteCommand_ChannelWeights, sample rates in ReadCommand_State */
+  Feature_FilterBank = 1UL << 13, /* WriteCommand_Filter, filters in ReadCommand_State */
+  Feature_Timing = 1UL << 14 /* ReadCommand_Timing */
+};
+
+/**
+ * Framing of the frames on the serial line
+ */
+enum Communication_Framings : uint8_t
+{
+  Framing_Raw = 0, /* frames follow each other, receiver resynchronizes by searching for a header with valid CRC */
+  Framing_SLIP = 1 /* every frame is enclosed in COMMUNICATION_SLIP_END, its bytes are escaped (RFC 1055); a corrupted frame is dropped as a whole and the next frame is received correctly */
+};
+
+/**
+ * Status of an acknowledged write command
+ */
+enum Communication_AcknowledgeStatus : uint8_t
+{
+  Acknowledge_Applied = 0, /* command was applied, time is when the module applied it (e. g. when the DAC was set) */
+  Acknowledge_Rejected = 1, /* malformed batch, nothing was applied */
+  Acknowledge_Unknown = 2, /* no module handles the command */
+  Acknowledge_InvalidValue = 3, /* data out of range, command was ignored */
+  Acknowledge_Failed = 4 /* command was accepted but the hardware did not take the value (e. g. the DAC write failed), time is when the failure was detected */
 };
 
 /* </Enums> */ 
@@ -85,12 +286,23 @@ enum Communication_ReadCommands : uint8_t
 
 /**
  * Structure for handling information that are to be handled by the load (e. g. set current)
+ * Either a standalone write command or a sub-command from a batch
  */
-struct Communication_WriteCommand
+struct Communication_Command
 {
-  uint8_t commandCounter; /* "Unique" number of the received command for identification. Intentional wraparound. Useful for identification if the command has been processed. */
   uint8_t command; /* Number indicating what the load is supposed to do */
-  uint8_t data[COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH]; /* Generic data for the command - will be interpreted based on command number */
+  uint8_t dataLength; /* Number of received data bytes, data shorter than COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH are padded with zeroes */
+  uint8_t sequence; /* Sequence number of the command in the queue, intentional wraparound */
+  const uint8_t * data; /* Generic data for the command in the payload pool - will be interpreted based on command number */
+};
+
+/**
+ * Position of a module in the command queue
+ */
+struct Communication_WriteCommandCursor
+{
+  uint8_t position; /* Sequence number of the next command to read */
+  uint32_t commands; /* Mask of write commands addressed to the module, other commands are skipped */
 };
 
 /**
@@ -102,6 +314,41 @@ struct Communication_ReadCommand
   uint8_t command; /* Number indicating what the load is supposed to do */
 };
 
+/**
+ * Acknowledge that waits until it can be sent without splitting the response in progress
+ */
+struct Communication_PendingAcknowledge
+{
+  uint8_t sequence; /* Sequence number of the acknowledged command */
+  uint8_t command; /* Acknowledged command */
+  Communication_AcknowledgeStatus status;
+  uint32_t time; /* micros() when the command was acknowledged */
+};
+
+/**
+ * Part of a response that is transmitted in pieces over several loop passes
+ */
+struct Communication_ResponsePart
+{
+  const uint8_t * data; /* Bytes of the part, in flash memory or in RAM */
+  uint8_t length; /* Number of bytes */
+  bool flash; /* True if data are in flash memory */
+  bool checksum; /* True if the bytes are included in the CRC of the response */
+};
+
+/**
+ * Statistics of the receiving part of the communication
+ */
+struct Communication_Statistics
+{
+  uint16_t timeouts; /* Number of frames dropped because the rest of the frame did not arrive within COMMUNICATION_TIMEOUT */
+  uint16_t crcErrors; /* Number of frames dropped because of CRC mismatch */
+  uint16_t rejectedCommands; /* Number of malformed batch commands that were not applied */
+  uint16_t queueOverflows; /* Number of frames that had to wait in the receive buffer because the command queue was full */
+  uint16_t framingErrors; /* Number of SLIP frames dropped because of invalid escape, invalid length or overlong frame */
+  uint16_t baudRateFallbacks; /* Number of baud rate changes that were not confirmed by the host in time */
+};
+
 /* </Structs> */ 
 
 
@@ -123,11 +370,41 @@ void Communication_Do(void);
 void Communication_Reset(void);
 
 /**
- * Gets the present write command
+ * Registers the cursor of a module in the command queue and marks all write commands received so far as processed
+ * Must be called after Communication_Init
+ *
+ * @param cursor - Cursor of the calling module
+ * @param commands - Mask of write commands addressed to the module (COMMUNICATION_COMMAND_BIT of each command)
+ */
+void Communication_InitWriteCommandCursor(Communication_WriteCommandCursor * cursor, uint32_t commands);
+
+/**
+ * Gets the next write command addressed to the cursor owner that it has not processed yet
+ * The queue is not overwritten until all cursors pass the command so bursts of commands are not lost
+ *
+ * @param cursor - Cursor of the calling module, it is advanced past the returned command
+ *
+ * @return - Pointer to the command (valid until the next Communication_Do) or NULL if there is no new command
+ */
+const Communication_Command * Communication_GetNextWriteCommand(Communication_WriteCommandCursor * cursor);
+
+/**
+ * Sends acknowledge message for the write command if acknowledging is enabled
+ * Called by the module that applied the command, right after it was applied
+ * The message is queued and sent by Communication_Do when the response in progress is finished and the transmit buffer has space
  *
- * @return - Pointer to the write command
+ * @param command - The command
+ * @param status - Result of the command
  */
-const Communication_WriteCommand * Communication_GetWriteCommand(void);
+void Communication_AcknowledgeCommand(const Communication_Command * command, Communication_AcknowledgeStatus status);
+
+/**
+ * Sends acknowledge message prepared by the module if acknowledging is enabled
+ * Used by modules that acknowledge a command later than they read it, e. g. when the DAC write is finished
+ *
+ * @param pending - Sequence number and command of the acknowledged command, result and time when it was applied
+ */
+void Communication_Acknowledge(const Communication_PendingAcknowledge * pending);
 
 /**
  * Gets the present read command
@@ -136,6 +413,13 @@ const Communication_WriteCommand * Communication_GetWriteCommand(void);
  */
 const Communication_ReadCommand * Communication_GetReadCommand(void);
 
+/**
+ * Gets the receive statistics (timeouts and CRC drops)
+ *
+ * @return - Pointer to the statistics structure
+ */
+const Communication_Statistics * Communication_GetStatistics(void);
+
 /**
  * Returns error structure for this module
  *
@@ -154,6 +438,17 @@ const ErrorMessaging_Error * Communication_GetError(void);
  */
 uint16_t CRC16(const uint16_t polynomial, const uint8_t * data, uint8_t dataLength);
 
+/**
+ * Adds one byte to 16-bit cyclic redundancy check
+ *
+ * @param polynomial - CRC polynomial
+ * @param crc - CRC of the preceding data (0 for the first byte)
+ * @param data - byte to add
+ *
+ * @return - 16-bit CRC of the preceding data and the added byte
+ */
+uint16_t CRC16_AddByte(const uint16_t polynomial, uint16_t crc, uint8_t data);
+
 /* </Declarations (prototypes)> */ 
 
 #endif /* COMMUNICATION_H */
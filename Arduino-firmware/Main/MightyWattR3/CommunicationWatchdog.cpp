@@ -19,9 +19,9 @@
 
 /* <Module variables> */ 
 
-static const Communication_WriteCommand * writeCommand; /* Pointer to the write command where new write data from communication can be found */
+static Communication_WriteCommandCursor commandCursor; /* Position of this module in the received write commands */
 static const Communication_ReadCommand * readCommand; /* Pointer to the write command where new read data from communication can be found */
-static uint8_t writeCommandCounter, readCommandCounter; /* Number of the last received command from communication */
+static uint8_t readCommandCounter; /* Number of the last received command from communication */
 static uint32_t lastCommandMilliseconds; /* Time when the last command has been received */
 
 /* </Module variables> */ 
@@ -31,19 +31,18 @@ static uint32_t lastCommandMilliseconds; /* Time when the last command has been
 
 void CommunicationWatchdog_Init(void)
 {  
-  writeCommand = Communication_GetWriteCommand();
+  Communication_InitWriteCommandCursor(&commandCursor, COMMUNICATION_ALL_COMMANDS);
   readCommand = Communication_GetReadCommand();
-  writeCommandCounter = writeCommand->commandCounter;
   readCommandCounter = readCommand->commandCounter;
   lastCommandMilliseconds = millis();
 }
 
 void CommunicationWatchdog_Do(void)
 {
-  if (writeCommandCounter != writeCommand->commandCounter)
+  if (Communication_GetNextWriteCommand(&commandCursor) != NULL)
   {
     lastCommandMilliseconds = millis();
-    writeCommandCounter = writeCommand->commandCounter;
+    while (Communication_GetNextWriteCommand(&commandCursor) != NULL) {}; /* Any write command feeds the watchdog, skip the rest */
   }
  
   if (readCommandCounter != readCommand->commandCounter)
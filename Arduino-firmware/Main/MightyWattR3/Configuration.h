@@ -76,4 +76,9 @@
   #error Only one type of ADC can be defined
 #endif
 
+
+/* Diagnostics */
+
+//#define PROFILER                                  /* Measures execution times of the loop tasks and I2C transactions, read by ReadCommand_Profile */
+
 #endif /* CONFIGURATION_H */
@@ -20,6 +20,9 @@
 #include "CurrentSetter.h"
 #include "VoltageSetter.h"
 #include "RangeSwitcher.h"
+#include "FastPin.h"
+#include "ControlTick.h"
+#include "ADC.h"
 
 /* </Includes> */ 
 
@@ -30,11 +33,12 @@ static uint32_t setCurrent, setVoltage, setPower, setResistance; /* Values to be
 //static RangeSwitcher_CurrentRanges ammeterRangeWhenSet; /* Stores the ammeter range when voltage was set to DAC */
 //static Voltmeter_Ranges voltmeterRangeWhenSet; /* Stores the voltmeter range when voltage was set to DAC */
 void (* Control_Keep)(void); /* Pointer to the constant keeper function */
-static const Communication_WriteCommand * writeCommand; /* Pointer to the write command where new data from communication can be found */
-static uint8_t commandCounter = 0; /* Number of the last executed command from communication */
+static Communication_WriteCommands controlMode; /* Last applied mode command */
+static Communication_WriteCommands weightedMode; /* Mode whose ADC channel weights are set */
+static Communication_WriteCommandCursor commandCursor; /* Position of this module in the received write commands */
 static const Measurement_Values * measurementValues; /* Pointer to the latest measured voltage, current, power and resistance */
 static uint8_t measurementCounter; /* Number of the last processed measurement data */
-static uint32_t measurementTimer; /* Time of the last processed measurement data */
+static uint8_t stepMeasurementCounter; /* Number of the measurement data used by the last control step */
 static uint32_t lastCurrent, lastPower, lastResistance, lastVoltage, lastLastPower; /* Saved values for software modes */
 static ErrorMessaging_Error ControlError;
 const static ErrorMessaging_Error * CurrentSetterError;
@@ -43,12 +47,45 @@ static uint8_t currentSetterErrorCounter, voltageSetterErrorCounter;
 static Control_CCCVStates cccvState;
 static uint32_t stepSize; /* Software control loop step size */
 static bool MPPT_initialized;
+static Control_PendingAcknowledge pendingAcknowledges[CONTROL_ACKNOWLEDGE_QUEUE_SIZE]; /* In the order of the commands */
+static uint8_t pendingAcknowledgeCount;
+static uint8_t newAcknowledges; /* Acknowledges queued by the present Control_Do, their DAC writes are not all queued yet */
 
 /* </Module variables> */ 
 
 
 /* <Declarations (prototypes)> */ 
 
+/**
+ * Sets the ADC channel weights so that the quantity controlled by a software loop is measured more often
+ * Hardware loops do not use the measurement, voltage and current are measured in turn
+ *
+ * @param mode - applied mode write command
+ */
+void Control_SetChannelWeights(Communication_WriteCommands mode);
+
+/**
+ * Queues the acknowledge of an applied command
+ * It is sent when the DAC writes queued by the present Control_Do are finished, so the time and the result are those of the DAC
+ *
+ * @param command - applied command
+ * @param failedWrites - failed DAC writes at the start of Control_Do
+ */
+void Control_AcknowledgeApplied(const Communication_Command * command, uint8_t failedWrites);
+
+/**
+ * Sends the acknowledges whose DAC writes are finished, in the order of the commands
+ * A command whose DAC write failed is acknowledged with Acknowledge_Failed
+ */
+void Control_SendAcknowledges(void);
+
+/**
+ * Takes the control tick if a software control loop step is due
+ *
+ * @return - True if the keeper makes a step now, false otherwise
+ */
+bool Control_TakeStep(void);
+
 /**
  * Sets the present value of "setCurrent" to DAC
  */
@@ -203,9 +240,16 @@ void Control_Init(void)
 {
   pinMode(CONTROL_CCCV_PIN, OUTPUT);
   Control_StopLoad();
-  writeCommand = Communication_GetWriteCommand();
+  Communication_InitWriteCommandCursor(&commandCursor, COMMUNICATION_COMMAND_BIT(WriteCommand_ConstantCurrent) | COMMUNICATION_COMMAND_BIT(WriteCommand_ConstantVoltage) |
+    COMMUNICATION_COMMAND_BIT(WriteCommand_ConstantPowerCC) | COMMUNICATION_COMMAND_BIT(WriteCommand_ConstantPowerCV) |
+    COMMUNICATION_COMMAND_BIT(WriteCommand_ConstantResistanceCC) | COMMUNICATION_COMMAND_BIT(WriteCommand_ConstantResistanceCV) |
+    COMMUNICATION_COMMAND_BIT(WriteCommand_ConstantVoltageSoftware) | COMMUNICATION_COMMAND_BIT(WriteCommand_MPPT) |
+    COMMUNICATION_COMMAND_BIT(WriteCommand_SimpleAmmeter));
   measurementValues = Measurement_GetValues();
   measurementCounter = 0;
+  weightedMode = WriteCommand_Invalid;
+  pendingAcknowledgeCount = 0;
+  newAcknowledges = 0;
   ControlError.errorCounter = 0;
   ControlError.error = CurrentSetterError->error;
   CurrentSetterError = CurrentSetter_GetError();
@@ -214,89 +258,229 @@ void Control_Init(void)
 
 void Control_Do(void)
 {
-  /* Check new command */
-  if (writeCommand->commandCounter != commandCounter)
+  const Communication_Command * newCommand;
+  uint8_t failedWrites = DACC_GetFailedWrites();
+  uint8_t ticket = DACC_GetTicket();
+  uint8_t i;
+
+  /* Check new commands */
+  while ((newCommand = Communication_GetNextWriteCommand(&commandCursor)) != NULL)
   {
     /* LSB first */
-    switch (writeCommand->command)
+    switch (newCommand->command)
     {
       case WriteCommand_ConstantCurrent:
-        setCurrent = Data_GetULongFromUCharArray(writeCommand->data);
+        setCurrent = Data_GetULongFromUCharArray(newCommand->data);
         Control_SetCurrent();
         Control_Keep = &Control_KeepCurrent;
+        ControlTick_Start(0);
+        controlMode = (Communication_WriteCommands)newCommand->command;
+        Control_AcknowledgeApplied(newCommand, failedWrites);
       break;
       case WriteCommand_ConstantVoltage:
-        setVoltage = Data_GetULongFromUCharArray(writeCommand->data);
+        setVoltage = Data_GetULongFromUCharArray(newCommand->data);
         Control_SetVoltage();
         Control_Keep = &Control_KeepVoltage;
+        ControlTick_Start(0);
+        controlMode = (Communication_WriteCommands)newCommand->command;
+        Control_AcknowledgeApplied(newCommand, failedWrites);
       break;
       case WriteCommand_ConstantPowerCC:
-        setPower = Data_GetULongFromUCharArray(writeCommand->data);
+        setPower = Data_GetULongFromUCharArray(newCommand->data);
         Control_SetPowerCC();
         Control_Keep = &Control_KeepPowerCC;
+        ControlTick_Start(CONTROL_TICK_PERIOD_CC);
+        controlMode = (Communication_WriteCommands)newCommand->command;
+        Control_AcknowledgeApplied(newCommand, failedWrites);
       break;
       case WriteCommand_ConstantPowerCV:
-        setPower = Data_GetULongFromUCharArray(writeCommand->data);
+        setPower = Data_GetULongFromUCharArray(newCommand->data);
         Control_SetPowerCV();
         Control_Keep = &Control_KeepPowerCV;
+        ControlTick_Start(CONTROL_TICK_PERIOD_CV);
+        controlMode = (Communication_WriteCommands)newCommand->command;
+        Control_AcknowledgeApplied(newCommand, failedWrites);
       break;
       case WriteCommand_ConstantResistanceCC:
-        setResistance = Data_GetULongFromUCharArray(writeCommand->data);
+        setResistance = Data_GetULongFromUCharArray(newCommand->data);
         Control_SetResistanceCC();
         Control_Keep = &Control_KeepResistanceCC;
+        ControlTick_Start(CONTROL_TICK_PERIOD_CC);
+        controlMode = (Communication_WriteCommands)newCommand->command;
+        Control_AcknowledgeApplied(newCommand, failedWrites);
       break;
       case WriteCommand_ConstantResistanceCV:
-        setResistance = Data_GetULongFromUCharArray(writeCommand->data);
+        setResistance = Data_GetULongFromUCharArray(newCommand->data);
         Control_SetResistanceCV();
         Control_Keep = &Control_KeepResistanceCV;
+        ControlTick_Start(CONTROL_TICK_PERIOD_CV);
+        controlMode = (Communication_WriteCommands)newCommand->command;
+        Control_AcknowledgeApplied(newCommand, failedWrites);
       break;
       case WriteCommand_ConstantVoltageSoftware:
-        setVoltage = Data_GetULongFromUCharArray(writeCommand->data);
+        setVoltage = Data_GetULongFromUCharArray(newCommand->data);
         Control_SetVoltageSoftware();
         Control_Keep = &Control_KeepVoltageSoftware;
+        ControlTick_Start(CONTROL_TICK_PERIOD_CC);
+        controlMode = (Communication_WriteCommands)newCommand->command;
+        Control_AcknowledgeApplied(newCommand, failedWrites);
       break;
       case WriteCommand_MPPT:
-        //setCurrent = Data_GetULongFromUCharArray(writeCommand->data);            
-        setVoltage = Data_GetULongFromUCharArray(writeCommand->data);     
+        //setCurrent = Data_GetULongFromUCharArray(newCommand->data);            
+        setVoltage = Data_GetULongFromUCharArray(newCommand->data);     
         Control_SetMPPT();
         Control_Keep = &Control_KeepMPPT;     
+        ControlTick_Start(CONTROL_TICK_PERIOD_CV);
+        controlMode = (Communication_WriteCommands)newCommand->command;
+        Control_AcknowledgeApplied(newCommand, failedWrites);
       break;
       case WriteCommand_SimpleAmmeter:
         Control_SetMaxCurrent();
         Control_Keep = NULL; // No keeper necessary
+        ControlTick_Start(0);
+        controlMode = (Communication_WriteCommands)newCommand->command;
+        Control_AcknowledgeApplied(newCommand, failedWrites);
       break;      
       default:
       /* command handled by other modules */
       break;
     }
-    commandCounter = writeCommand->commandCounter;
   }  
+
+  if (controlMode != weightedMode) /* Mode was changed by a command or by stopping the load */
+  {
+    weightedMode = controlMode;
+    Control_SetChannelWeights(controlMode);
+  }
   
   if (Control_Keep != NULL)
   {
     Control_Keep();
   }
 
+  /* The commands of this pass are applied when the DAC writes queued until now are finished */
+  for (i = pendingAcknowledgeCount - newAcknowledges; i < pendingAcknowledgeCount; i++)
+  {
+    pendingAcknowledges[i].ticket = DACC_GetTicket();
+    pendingAcknowledges[i].written = (DACC_GetTicket() != ticket);
+  }
+  newAcknowledges = 0;
+  Control_SendAcknowledges();
+
   if (currentSetterErrorCounter != CurrentSetterError->errorCounter)
   {
     currentSetterErrorCounter = CurrentSetterError->errorCounter;
-    ControlError.errorCounter++;
-    ControlError.error = CurrentSetterError->error;
+    ErrorMessaging_Raise(&ControlError, CurrentSetterError->error);
   }
 
   if (voltageSetterErrorCounter != VoltageSetterError->errorCounter)
   {
     voltageSetterErrorCounter = VoltageSetterError->errorCounter;
-    ControlError.errorCounter++;
-    ControlError.error = VoltageSetterError->error;
+    ErrorMessaging_Raise(&ControlError, VoltageSetterError->error);
+  }
+}
+
+void Control_AcknowledgeApplied(const Communication_Command * command, uint8_t failedWrites)
+{
+  Control_PendingAcknowledge * pending;
+
+  if (pendingAcknowledgeCount >= CONTROL_ACKNOWLEDGE_QUEUE_SIZE)
+  {
+    /* Queue is full, wait for the DAC and send all */
+    DACC_Wait();
+    newAcknowledges = 0;
+    Control_SendAcknowledges();
+  }
+
+  pending = &pendingAcknowledges[pendingAcknowledgeCount];
+  pending->acknowledge.sequence = command->sequence;
+  pending->acknowledge.command = command->command;
+  pending->acknowledge.status = Acknowledge_Applied;
+  pending->acknowledge.time = micros();
+  pending->ticket = DACC_GetTicket();
+  pending->failedWrites = failedWrites;
+  pending->written = false;
+  pendingAcknowledgeCount++;
+  newAcknowledges++;
+}
+
+void Control_SendAcknowledges(void)
+{
+  uint8_t sent, i;
+
+  for (sent = 0; (sent < (pendingAcknowledgeCount - newAcknowledges)) && DACC_IsWritten(pendingAcknowledges[sent].ticket); sent++)
+  {
+    Control_PendingAcknowledge * pending = &pendingAcknowledges[sent];
+
+    if (DACC_GetFailedWrites() != pending->failedWrites)
+    {
+      pending->acknowledge.status = Acknowledge_Failed;
+      pending->acknowledge.time = micros();
+    }
+    else if (pending->written)
+    {
+      pending->acknowledge.time = DACC_GetWriteTime();
+    }
+    Communication_Acknowledge(&(pending->acknowledge));
+  }
+
+  for (i = sent; i < pendingAcknowledgeCount; i++)
+  {
+    pendingAcknowledges[i - sent] = pendingAcknowledges[i];
+  }
+  pendingAcknowledgeCount -= sent;
+}
+
+void Control_SetChannelWeights(Communication_WriteCommands mode)
+{
+  switch (mode)
+  {
+    case WriteCommand_ConstantPowerCC:
+    case WriteCommand_ConstantResistanceCC:
+      /* Current is stepped */
+      ADC_SetWeights(Weights_Mode, ADC_DEFAULT_WEIGHT, CONTROL_LEADING_CHANNEL_WEIGHT);
+    break;
+    case WriteCommand_ConstantPowerCV:
+    case WriteCommand_ConstantResistanceCV:
+    case WriteCommand_ConstantVoltageSoftware:
+    case WriteCommand_MPPT:
+      /* Voltage is stepped or is the controlled quantity */
+      ADC_SetWeights(Weights_Mode, CONTROL_LEADING_CHANNEL_WEIGHT, ADC_DEFAULT_WEIGHT);
+    break;
+    default:
+      ADC_SetWeights(Weights_Mode, ADC_DEFAULT_WEIGHT, ADC_DEFAULT_WEIGHT);
+    break;
   }
 }
 
+bool Control_IsStepDue(void)
+{
+  return ControlTick_IsDue() && (measurementValues->counter != stepMeasurementCounter);
+}
+
+bool Control_IsDue(void)
+{
+  return Control_IsStepDue() || ((pendingAcknowledgeCount > newAcknowledges) && DACC_IsWritten(pendingAcknowledges[0].ticket));
+}
+
+bool Control_TakeStep(void)
+{
+  if (Control_IsStepDue())
+  {
+    ControlTick_Take();
+    stepMeasurementCounter = measurementValues->counter;
+    return true;
+  }
+  return false;
+}
+
 void Control_StopLoad(void)
 {
   setCurrent = 0;
   CurrentSetter_SetZero();
   Control_Keep = &Control_KeepCurrent;
+  ControlTick_Start(0);
+  controlMode = WriteCommand_ConstantCurrent;
 }
 
 void Control_SetCurrent(void)
@@ -348,7 +532,7 @@ void Control_KeepPowerCC(void)
 {
   static Control_CurrentActions lastAction = Control_CurrentUp;
   
-  if (measurementValues->milliseconds - measurementTimer > CONTROL_BANDWIDTH_LIMIT_CC)
+  if (Control_TakeStep())
   {
     if ((setPower > 0) && (measurementValues->unfilteredVoltage > VOLTMETER_THRESHOLD_VOLTAGE))
     { 
@@ -360,7 +544,6 @@ void Control_KeepPowerCC(void)
       stepSize = 0;
       Control_LimitCurrentStepSize(&stepSize);
     }
-    measurementTimer = measurementValues->milliseconds;
   }
   CurrentSetter_Do();
 }
@@ -403,7 +586,7 @@ void Control_KeepPowerCV(void)
 {
   static Control_VoltageActions lastAction = Control_VoltageDown;
   
-  if (measurementValues->milliseconds - measurementTimer > CONTROL_BANDWIDTH_LIMIT_CV)
+  if (Control_TakeStep())
   {
     if ((setPower > 0) && (measurementValues->unfilteredVoltage > VOLTMETER_THRESHOLD_VOLTAGE))
     { 
@@ -415,7 +598,6 @@ void Control_KeepPowerCV(void)
       stepSize = 0;
       Control_LimitVoltageStepSize(&stepSize);
     }
-    measurementTimer = measurementValues->milliseconds;
   }
   VoltageSetter_Do();
 }
@@ -456,7 +638,7 @@ void Control_KeepResistanceCC(void)
 {
   static Control_CurrentActions lastAction = Control_CurrentUp;
   
-  if (measurementValues->milliseconds - measurementTimer > CONTROL_BANDWIDTH_LIMIT_CC)
+  if (Control_TakeStep())
   {    
     if (setResistance >= VOLTMETER_INPUT_RESISTANCE)
     {
@@ -470,7 +652,6 @@ void Control_KeepResistanceCC(void)
     {
       CurrentSetter_SetCurrent((uint32_t)(CURRENT_SETTER_MAXIMUM_HICURRENT - 1));
     } 
-    measurementTimer = measurementValues->milliseconds;    
   }  
   CurrentSetter_Do();
 }
@@ -511,7 +692,7 @@ void Control_KeepResistanceCV(void)
 {
   static Control_VoltageActions lastAction = Control_VoltageDown;
   
-  if (measurementValues->milliseconds - measurementTimer > CONTROL_BANDWIDTH_LIMIT_CV)
+  if (Control_TakeStep())
   {    
     if (setResistance >= VOLTMETER_INPUT_RESISTANCE)
     {
@@ -525,7 +706,6 @@ void Control_KeepResistanceCV(void)
     {
       VoltageSetter_SetVoltage(0);
     } 
-    measurementTimer = measurementValues->milliseconds;    
   }  
   VoltageSetter_Do();
 }
@@ -551,7 +731,7 @@ void Control_KeepVoltageSoftware(void)
 {
   static Control_CurrentActions lastAction = Control_CurrentUp;
   
-  if (measurementValues->milliseconds - measurementTimer > CONTROL_BANDWIDTH_LIMIT_CC)
+  if (Control_TakeStep())
   {    
     if (setVoltage == 0)
     {
@@ -566,7 +746,6 @@ void Control_KeepVoltageSoftware(void)
       Control_SWCC(setVoltage, &lastVoltage, measurementValues->unfilteredVoltage, &lastAction);
     }   
          
-    measurementTimer = measurementValues->milliseconds;
   }  
   CurrentSetter_Do();
 }
@@ -603,6 +782,7 @@ void Control_KeepMPPT(void)
   // initialization
   if (!MPPT_initialized)
   {
+    Control_TakeStep(); /* The tick is not used until the initialization is finished */
     if (measurementValues->counter == (uint8_t)(measurementCounter + 5))
     {      
       VoltageSetter_SetVoltage((measurementValues->unfilteredVoltage * 9) / 10); // set 90% of open-circuit voltage
@@ -618,7 +798,7 @@ void Control_KeepMPPT(void)
   }
 
   // main loop
-  if (measurementValues->milliseconds - measurementTimer > CONTROL_BANDWIDTH_LIMIT_CV)
+  if (Control_TakeStep())
   { 
     action = MPPTAction;
     if (measurementValues->unfilteredVoltage < VOLTMETER_THRESHOLD_VOLTAGE) /* Increase voltage on zero voltage */
@@ -677,7 +857,6 @@ void Control_KeepMPPT(void)
     lastMPPTAction = action;
     lastLastPower = lastPower;
     lastPower = measurementValues->unfilteredPower;
-    measurementTimer = measurementValues->milliseconds;
   }
   VoltageSetter_Do();  
 }
@@ -791,15 +970,15 @@ void Control_SetCCCV(Control_CCCVStates state)
   switch (state)
   {
     case Control_CCCV_CC:
-      digitalWrite(CONTROL_CCCV_PIN, LOW);
+      FastPin_Low<CONTROL_CCCV_PIN>();
       cccvState = state;
     break;
     case Control_CCCV_CV:
-      digitalWrite(CONTROL_CCCV_PIN, HIGH);
+      FastPin_High<CONTROL_CCCV_PIN>();
       cccvState = state;
     break;
     case Control_CCCV_CC_SimpleAmmeter:
-      digitalWrite(CONTROL_CCCV_PIN, LOW);
+      FastPin_Low<CONTROL_CCCV_PIN>();
       cccvState = state;
     break;
     default:
@@ -1029,6 +1208,31 @@ Control_CCCVStates Control_GetCCCV(void)
   return cccvState;
 }
 
+Communication_WriteCommands Control_GetMode(void)
+{
+  return controlMode;
+}
+
+uint32_t Control_GetSetCurrent(void)
+{
+  return setCurrent;
+}
+
+uint32_t Control_GetSetVoltage(void)
+{
+  return setVoltage;
+}
+
+uint32_t Control_GetSetPower(void)
+{
+  return setPower;
+}
+
+uint32_t Control_GetSetResistance(void)
+{
+  return setResistance;
+}
+
 const ErrorMessaging_Error * Control_GetError(void)
 {
   return &ControlError;
@@ -14,6 +14,7 @@
 
 #include "MightyWatt.h"
 #include "ErrorMessaging.h"
+#include "Communication.h"
 
 /* </Includes> */ 
 
@@ -22,8 +23,12 @@
 
 #define CONTROL_CCCV_PIN                   12
 #define CONTROL_CCCV_PIN_DEFAULT_STATE     CCCV_CC
-#define CONTROL_BANDWIDTH_LIMIT_CC         2 /* ms */
-#define CONTROL_BANDWIDTH_LIMIT_CV         20 /* ms */
+#define CONTROL_TICK_PERIOD_CC             5000 /* us, control step period of the software loops in CC mode, longer than the measurement period also with streaming
+                                                 replaces the 2 ms step limit of the measurement-driven loops: CP(CC), CR(CC) and software CV step 2.5 times less often
+                                                 and slew correspondingly slower, a full-range change of 16 maximum current steps takes 80 ms instead of 32 ms */
+#define CONTROL_TICK_PERIOD_CV             20000 /* us, control step period of the software loops in CV mode */
+#define CONTROL_LEADING_CHANNEL_WEIGHT     3 /* ADC conversions of the quantity a software loop controls per conversion of the other quantity */
+#define CONTROL_ACKNOWLEDGE_QUEUE_SIZE     4 /* Acknowledges of applied commands waiting for their DAC writes */
 
 #define CONTROL_MAXIMUM_HI_CURRENT_STEP    ((uint32_t)(CURRENTSETTER_SLOPE_HI / (uint32_t)16)) /* 1/16 of the range */
 #define CONTROL_MAXIMUM_LO_CURRENT_STEP    ((uint32_t)(CURRENTSETTER_SLOPE_LO / (uint32_t)16)) /* 1/16 of the range */
@@ -65,6 +70,22 @@ enum Control_VoltageActions : uint8_t
 /* </Enums> */ 
 
 
+/* <Structs> */ 
+
+/**
+ * Acknowledge of an applied command that is sent when the DAC writes of the command are finished
+ */
+struct Control_PendingAcknowledge
+{
+  Communication_PendingAcknowledge acknowledge;
+  uint8_t ticket; /* Last DAC write of the command, see DACC_GetTicket */
+  uint8_t failedWrites; /* Failed DAC writes before the command was applied */
+  bool written; /* True if the command wrote the DAC, the acknowledge gets the time of the write */
+};
+
+/* </Structs> */ 
+
+
 /* <Declarations (prototypes)> */ 
 
 /**
@@ -77,6 +98,21 @@ void Control_Init(void);
  */
 void Control_Do(void);
 
+/**
+ * Returns whether a software control loop step is due: the control tick came and a new measurement is available
+ *
+ * @return - True if Control_Do would make a step, false otherwise
+ */
+bool Control_IsStepDue(void);
+
+/**
+ * Returns whether Control_Do has work that must not wait for the next event:
+ * a software control loop step is due or the DAC writes of an acknowledged command are finished
+ *
+ * @return - True if Control_Do should run now, false otherwise
+ */
+bool Control_IsDue(void);
+
 /**
  * Sets the load to CC mode with zero current
  */
@@ -97,6 +133,41 @@ void Control_SetCCCV(Control_CCCVStates state);
  */
 Control_CCCVStates Control_GetCCCV(void);
 
+/**
+ * Returns the mode the load is kept in
+ *
+ * @return - Last applied mode write command (constant current with zero current after the load was stopped)
+ */
+Communication_WriteCommands Control_GetMode(void);
+
+/**
+ * Returns the set current
+ *
+ * @return - Set current in microamps
+ */
+uint32_t Control_GetSetCurrent(void);
+
+/**
+ * Returns the set voltage
+ *
+ * @return - Set voltage in microvolts
+ */
+uint32_t Control_GetSetVoltage(void);
+
+/**
+ * Returns the set power
+ *
+ * @return - Set power in microwatts
+ */
+uint32_t Control_GetSetPower(void);
+
+/**
+ * Returns the set resistance
+ *
+ * @return - Set resistance in milliohms
+ */
+uint32_t Control_GetSetResistance(void);
+
 /**
  * Returns error structure for this module
  *
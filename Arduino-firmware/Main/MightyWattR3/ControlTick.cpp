@@ -0,0 +1,176 @@
+/**
+ * ControlTick.cpp
+ * Hardware timer tick of the software control loops
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+/* <Includes> */
+
+#include "Arduino.h"
+#include "ControlTick.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static volatile bool TickDue; /* Set by the interrupt, cleared by ControlTick_Take */
+static volatile uint32_t TickTime; /* micros() of the last tick */
+static volatile uint32_t Ticks;
+static volatile uint16_t Overruns;
+static ControlTick_Statistics Statistics; /* Steps and histogram, ticks and overruns are copied in ControlTick_GetStatistics */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Handles the timer interrupt
+ */
+void ControlTick_Interrupt(void);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void ControlTick_Init(void)
+{
+  #ifdef ZERO
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID_TCC2_TC3; /* 48 MHz to TC3 */
+    while (GCLK->STATUS.bit.SYNCBUSY) {}
+    NVIC_EnableIRQ(TC3_IRQn);
+  #endif
+  ControlTick_Start(0);
+  ControlTick_ResetStatistics();
+}
+
+void ControlTick_Start(uint16_t period)
+{
+  if (period > CONTROLTICK_PERIOD_MAXIMUM)
+  {
+    period = CONTROLTICK_PERIOD_MAXIMUM;
+  }
+
+  noInterrupts();
+  #ifdef UNO
+    TCCR1B = 0; /* Stop the timer */
+    TIMSK1 = 0;
+    if (period > 0)
+    {
+      TCCR1A = 0;
+      TCNT1 = 0;
+      OCR1A = period * CONTROLTICK_CLOCKS_PER_US - 1;
+      TIFR1 = _BV(OCF1A); /* Clear a stale compare flag */
+      TIMSK1 = _BV(OCIE1A);
+      TCCR1B = _BV(WGM12) | _BV(CS11); /* CTC mode with top at OCR1A, prescaler 8 */
+    }
+  #elif defined(ZERO)
+    TC3->COUNT16.CTRLA.reg = 0; /* Stop the timer */
+    while (TC3->COUNT16.STATUS.bit.SYNCBUSY) {}
+    TC3->COUNT16.INTENCLR.reg = TC_INTENCLR_MC0;
+    if (period > 0)
+    {
+      TC3->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER_DIV16; /* Top at CC0 */
+      TC3->COUNT16.COUNT.reg = 0;
+      TC3->COUNT16.CC[0].reg = (uint32_t)period * CONTROLTICK_CLOCKS_PER_US - 1;
+      while (TC3->COUNT16.STATUS.bit.SYNCBUSY) {}
+      TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+      TC3->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+      TC3->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+      while (TC3->COUNT16.STATUS.bit.SYNCBUSY) {}
+    }
+  #endif
+  TickDue = false;
+  interrupts();
+}
+
+bool ControlTick_IsDue(void)
+{
+  return TickDue;
+}
+
+bool ControlTick_Take(void)
+{
+  uint32_t jitter;
+  uint8_t bin;
+
+  noInterrupts();
+  if (!TickDue)
+  {
+    interrupts();
+    return false;
+  }
+  TickDue = false;
+  jitter = micros() - TickTime;
+  interrupts();
+
+  Statistics.steps++;
+  if (jitter > Statistics.maximumJitter)
+  {
+    Statistics.maximumJitter = (jitter > 0xFFFF) ? 0xFFFF : jitter;
+  }
+  for (bin = 0; (bin < (CONTROLTICK_HISTOGRAM_BINS - 1)) && (jitter >= ((uint32_t)CONTROLTICK_HISTOGRAM_FIRST_BIN << bin)); bin++) {}
+  if (Statistics.histogram[bin] < 0xFFFF)
+  {
+    Statistics.histogram[bin]++;
+  }
+  return true;
+}
+
+const ControlTick_Statistics * ControlTick_GetStatistics(void)
+{
+  noInterrupts();
+  Statistics.ticks = Ticks; /* 32-bit read is not atomic on 8-bit MCU */
+  Statistics.overruns = Overruns;
+  interrupts();
+  return &Statistics;
+}
+
+void ControlTick_ResetStatistics(void)
+{
+  uint8_t i;
+
+  noInterrupts();
+  Ticks = 0;
+  Overruns = 0;
+  interrupts();
+  Statistics.ticks = 0;
+  Statistics.steps = 0;
+  Statistics.overruns = 0;
+  Statistics.maximumJitter = 0;
+  for (i = 0; i < CONTROLTICK_HISTOGRAM_BINS; i++)
+  {
+    Statistics.histogram[i] = 0;
+  }
+}
+
+void ControlTick_Interrupt(void)
+{
+  Ticks++;
+  if (TickDue && (Overruns < 0xFFFF))
+  {
+    Overruns++;
+  }
+  TickTime = micros();
+  TickDue = true;
+}
+
+#ifdef UNO
+ISR(TIMER1_COMPA_vect)
+{
+  ControlTick_Interrupt();
+}
+#elif defined(ZERO)
+void TC3_Handler(void)
+{
+  TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+  ControlTick_Interrupt();
+}
+#endif
+
+/* </Implementations> */
@@ -0,0 +1,96 @@
+/**
+ * ControlTick.h
+ * Hardware timer tick of the software control loops
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef CONTROLTICK_H
+#define CONTROLTICK_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define CONTROLTICK_PERIOD_MAXIMUM              20000U /* us, longest period that fits both timers */
+#define CONTROLTICK_HISTOGRAM_BINS              8 /* Bins of the jitter histogram, ReadCommand_Timing sends them in two parts of 8 bytes */
+#define CONTROLTICK_HISTOGRAM_FIRST_BIN         64U /* us, bin k counts jitter below CONTROLTICK_HISTOGRAM_FIRST_BIN << k, the last bin counts the rest */
+
+#ifdef UNO
+  #define CONTROLTICK_CLOCKS_PER_US             (F_CPU / 8000000UL) /* Timer1 with prescaler 8 */
+#elif defined(ZERO)
+  #define CONTROLTICK_CLOCKS_PER_US             (F_CPU / 16000000UL) /* TC3 with prescaler 16 */
+#endif
+
+/* </Defines> */
+
+
+/* <Structs> */
+
+/**
+ * Timing of the ticks since the last reset
+ * Jitter is the time between the timer tick and the start of the control step
+ */
+struct ControlTick_Statistics
+{
+  uint32_t ticks; /* Number of timer ticks */
+  uint32_t steps; /* Number of ticks taken by a control step */
+  uint16_t overruns; /* Ticks that came before the previous tick was taken, the previous tick is lost */
+  uint16_t maximumJitter; /* us, saturated */
+  uint16_t histogram[CONTROLTICK_HISTOGRAM_BINS]; /* Number of steps by their jitter, saturated */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the timer, the tick is stopped
+ */
+void ControlTick_Init(void);
+
+/**
+ * Starts the tick with a new period or stops it, a pending tick is dropped
+ *
+ * @param period - tick period in us, at most CONTROLTICK_PERIOD_MAXIMUM, 0 stops the tick
+ */
+void ControlTick_Start(uint16_t period);
+
+/**
+ * Returns whether a tick came and was not taken yet
+ *
+ * @return - True if a tick is pending, false otherwise
+ */
+bool ControlTick_IsDue(void);
+
+/**
+ * Takes the pending tick and adds its jitter to the histogram
+ *
+ * @return - True if a tick was pending, false otherwise
+ */
+bool ControlTick_Take(void);
+
+/**
+ * Gets the timing of the ticks
+ *
+ * @return - Pointer to a consistent copy of the statistics
+ */
+const ControlTick_Statistics * ControlTick_GetStatistics(void);
+
+/**
+ * Clears the statistics
+ */
+void ControlTick_ResetStatistics(void);
+
+/* </Declarations (prototypes)> */
+
+
+#endif /* CONTROLTICK_H */
@@ -67,8 +67,7 @@ void CurrentSetter_Do(void)
           dac = ((((uint64_t)((int32_t)presentCurrent + CURRENTSETTER_OFFSET_HI))) << 16) / CURRENTSETTER_SLOPE_HI;        
           if (dac > DAC_MAXIMUM) /* Set current higher than maximum */
           {
-            CurrentSetterError.errorCounter++;
-            CurrentSetterError.error = ErrorMessaging_CurrentSetter_SetCurrentOverload;
+            ErrorMessaging_Raise(&CurrentSetterError, ErrorMessaging_CurrentSetter_SetCurrentOverload);
             dac = DAC_MAXIMUM;
           }      
         }
@@ -100,8 +99,12 @@ void CurrentSetter_Do(void)
   /* Set calculated DAC value */
   if (!DACC_SetVoltage(dac & 0xFFFF))
   {
-    CurrentSetterError.errorCounter++;
-    CurrentSetterError.error = ErrorMessaging_CurrentSetter_SetCurrentOverload; 
+    ErrorMessaging_Raise(&CurrentSetterError, ErrorMessaging_CurrentSetter_SetCurrentOverload); 
+  }
+  /* The DAC write is only queued, the new value must be on the output before the range goes up or the phase changes */
+  if (((range == CurrentRange_HighCurrent) && (previousRange != range)) || (previousCCCVState != Control_CCCV_CC))
+  {
+    DACC_Wait();
   }
   /* Set range if high current */
   if (range == CurrentRange_HighCurrent)
@@ -162,6 +165,7 @@ void CurrentSetter_SetMaxCurrentThisRange(void)
 {
   /* Set maximum DAC */
   DACC_SetVoltage(DAC_MAXIMUM);
+  DACC_Wait();
   /* Set phase CC with autoranging for ammeter */
   Control_SetCCCV(Control_CCCV_CC_SimpleAmmeter);
 }
@@ -19,6 +19,7 @@
 /* <Module variables> */ 
 
 static uint16_t dacValue;
+static uint8_t failedWrites; /* Failed writes of the DAC driver when dacValue was last sent */
 static ErrorMessaging_Error dacError;
 const static ErrorMessaging_Error * AD569xRError;
 
@@ -31,6 +32,7 @@ void DACC_Init(void)
 {
   AD569xR_Init();
   dacValue = 0;
+  failedWrites = AD569xR_GetFailedWrites();
   dacError.errorCounter = 0;
   dacError.error = ErrorMessaging_DACC_UpperLimitReached;
   AD569xRError = AD569xR_GetError();
@@ -38,16 +40,16 @@ void DACC_Init(void)
 
 bool DACC_SetVoltage(uint16_t value)
 {        
-  if (dacValue != value) /* Only update value if different from previous value */
+  if ((dacValue != value) || (failedWrites != AD569xR_GetFailedWrites())) /* Only update value if different from previous value or if a write failed */
   {
+    failedWrites = AD569xR_GetFailedWrites();
     if (AD569xR_Set(value)) /* check command success */
     {
       dacValue = value;
     }
     else
     {
-      dacError.errorCounter++;
-      dacError.error = AD569xRError->error;
+      ErrorMessaging_Raise(&dacError, AD569xRError->error);
       return false;
     }     
   }
@@ -76,8 +78,7 @@ bool DACC_Plus(uint16_t value)
   }
   else if (DACC_SetVoltage(DAC_MAXIMUM))
   {
-    dacError.errorCounter++;
-    dacError.error = ErrorMessaging_DACC_UpperLimitReached;
+    ErrorMessaging_Raise(&dacError, ErrorMessaging_DACC_UpperLimitReached);
   }
   return result;
 }
@@ -91,12 +92,36 @@ bool DACC_Minus(uint16_t value)
   }
   else if (DACC_SetVoltage(0))
   {
-    dacError.errorCounter++;
-    dacError.error = ErrorMessaging_DACC_LowerLimitReached;
+    ErrorMessaging_Raise(&dacError, ErrorMessaging_DACC_LowerLimitReached);
   }
   return result;
 }
 
+void DACC_Wait(void)
+{
+  AD569xR_Wait();
+}
+
+uint8_t DACC_GetTicket(void)
+{
+  return AD569xR_GetTicket();
+}
+
+bool DACC_IsWritten(uint8_t ticket)
+{
+  return AD569xR_IsWritten(ticket);
+}
+
+uint8_t DACC_GetFailedWrites(void)
+{
+  return AD569xR_GetFailedWrites();
+}
+
+uint32_t DACC_GetWriteTime(void)
+{
+  return AD569xR_GetWriteTime();
+}
+
 uint16_t DACC_GetValue()
 {
   return dacValue;
@@ -71,6 +71,42 @@ bool DACC_Plus(uint16_t value);
  */
 bool DACC_Minus(uint16_t value);
 
+/**
+ * Waits until the set value is on the DAC output
+ * Must be called before a range or CC/CV change that relies on the new value
+ */
+void DACC_Wait(void);
+
+/**
+ * Gets the ticket of the last value sent to the DAC, see AD569xR_GetTicket
+ *
+ * @return - Ticket for DACC_IsWritten
+ */
+uint8_t DACC_GetTicket(void);
+
+/**
+ * Checks whether the values up to a ticket were written to the DAC or failed
+ *
+ * @param ticket - Ticket from DACC_GetTicket
+ *
+ * @return - True if the writes are finished
+ */
+bool DACC_IsWritten(uint8_t ticket);
+
+/**
+ * Gets the number of values that did not reach the DAC
+ *
+ * @return - Number of failed writes, intentional wraparound
+ */
+uint8_t DACC_GetFailedWrites(void);
+
+/**
+ * Gets the time when the last value reached the DAC
+ *
+ * @return - micros() of the end of the write
+ */
+uint32_t DACC_GetWriteTime(void);
+
 /**
  * Gets the present DAC value
  *
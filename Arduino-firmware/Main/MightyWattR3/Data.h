@@ -11,142 +11,196 @@
 
 /* <Includes> */ 
 
+#include "Arduino.h"
 #include "MightyWatt.h"
 
 /* </Includes> */ 
 
  
+/* <Defines> */
+
+#define DATA_READ_ATTEMPTS         4 /* Reads of a TSC that are retried after a publish interrupted them */
+#define DATA_BARRIER()             __asm__ __volatile__ ("" ::: "memory") /* Keeps the compiler from moving memory accesses across the sequence counter */
+
+/* </Defines> */
+
+
 /* <Structs> */ 
 
 /**
- * (T)ime(s)tamped (c)ounted (u)nchar
- * Timestamp should contain millisecond counter
- * Counter should update every time new value is written
+ * Filtered value together with the unfiltered value it was computed from
  */
-struct TSCUChar
+template <typename T>
+struct Data_Filtered
 {
-  uint32_t milliseconds;
-  uint8_t counter;
-  uint8_t value;
+  T value;
+  T unfilteredValue;
 };
 
 /**
- * (T)ime(s)tamped (c)ounted int8_t
- * Timestamp should contain millisecond counter
- * Counter should update every time new value is written
+ * (T)ime(s)tamped (c)ounted value of any type
+ * Only Data_Publish writes it, readers use Data_Read, Data_ReadNew, Data_GetValue and Data_GetCounter
+ * The sequence is incremented before and after the value is written (seqlock), it is odd while a publish is in progress.
+ * A reader that was interrupted by a publish sees a changed sequence and reads again,
+ * so the value is never torn and neither side disables interrupts.
+ * There must be only one producer, either an interrupt or the main loop.
+ * Timestamp first and sequence last leave no padding inside the struct on ZERO.
  */
-struct TSCChar
+template <typename T>
+struct TSC
 {
-  uint32_t milliseconds;
-  uint8_t counter;
-  int8_t value;
+  uint32_t milliseconds; /* millis() of the last publish */
+  T value;
+  volatile uint8_t sequence; /* Twice the number of publishes, odd while publishing */
 };
 
+typedef TSC<uint8_t> TSCUChar;
+typedef TSC< Data_Filtered<int32_t> > TSCADCLong;
+typedef TSC< Data_Filtered<uint32_t> > TSCADCULong;
+
+/* </Structs> */ 
+
+
+/* <Declarations (prototypes)> */ 
+
 /**
- * (T)ime(s)tamped (c)ounted (u)ninteger
- * Timestamp should contain millisecond counter
- * Counter should update every time new value is written
+ * Return an uint32_t number from array of unchars
+ *
+ * @param value[] - array of uint8_t from which to construct the result, LSB first
+ *
+ * @return - Value as an uint32_t
  */
-struct TSCUInt
+inline uint32_t Data_GetULongFromUCharArray(const uint8_t value[])
 {
-  uint32_t milliseconds;
-  uint8_t counter;
-  uint16_t value;
-};
+  return ((uint32_t)(value[3])) << 24 |
+         ((uint32_t)(value[2])) << 16 |
+         ((uint32_t)(value[1])) << 8 |
+          (uint32_t)(value[0]);
+}
 
 /**
- * (T)ime(s)tamped (c)ounted integer
- * Timestamp should contain millisecond counter
- * Counter should update every time new value is written
+ * Return an uint16_t number from array of unchars
+ *
+ * @param value[] - array of uint8_t from which to construct the result, LSB first
+ *
+ * @return - Value as an uint16_t
  */
-struct TSCInt
+inline uint16_t Data_GetUIntFromUCharArray(const uint8_t value[])
 {
-  uint32_t milliseconds;
-  uint8_t counter;
-  int16_t value;
-};
+  return ((uint16_t)(value[1])) << 8 |
+          (uint16_t)(value[0]);
+}
 
 /**
- * (T)ime(s)tamped (c)ounted (u)nint32_t
- * Timestamp should contain millisecond counter
- * Counter should update every time new value is written
+ * Clears the value, the timestamp and the counter, must not be called while the TSC is being read
+ *
+ * @param tsc - structure to clear
  */
-struct TSCULong
+template <typename T>
+inline void Data_Clear(TSC<T> * tsc)
 {
-  uint32_t milliseconds;
-  uint8_t counter;
-  uint32_t value;
-};
+  tsc->milliseconds = 0;
+  tsc->value = T();
+  tsc->sequence = 0;
+}
 
 /**
- * (T)ime(s)tamped (c)ounted int32_t
- * Timestamp should contain millisecond counter
- * Counter should update every time new value is written
+ * Writes a new value with the current timestamp and increments the counter
+ *
+ * @param tsc - structure to write
+ * @param value - new value
  */
-struct TSCLong
+template <typename T>
+inline void Data_Publish(TSC<T> * tsc, const T & value)
 {
-  uint32_t milliseconds;
-  uint8_t counter;
-  int32_t value;
-};
+  tsc->sequence++; /* Odd: publish in progress */
+  DATA_BARRIER();
+  tsc->value = value;
+  tsc->milliseconds = millis();
+  DATA_BARRIER();
+  tsc->sequence++;
+}
 
 /**
- * (T)ime(s)tamped (c)ounted ADC (u)int32_t
- * Timestamp should contain millisecond counter
- * Counter should update every time new value is written
+ * Returns the counter of publishes, a publish in progress is not counted yet
+ *
+ * @param tsc - structure to read
+ *
+ * @return - Counter that changes with every publish
  */
-struct TSCADCULong
+template <typename T>
+inline uint8_t Data_GetCounter(const TSC<T> * tsc)
 {
-  uint32_t milliseconds;
-  uint8_t counter;
-  uint32_t value;
-  uint32_t unfilteredValue;
-};
+  return tsc->sequence >> 1;
+}
 
 /**
- * (T)ime(s)tamped (c)ounted ADC int32_t
- * Timestamp should contain millisecond counter
- * Counter should update every time new value is written
+ * Copies a consistent value
+ * Fails only in an interrupt that interrupted the producer in the middle of a publish,
+ * or if DATA_READ_ATTEMPTS reads in a row were interrupted by a publish
+ *
+ * @param tsc - structure to read
+ * @param value - copy of the value
+ * @param counter - counter of the copied value, may be NULL
+ *
+ * @return - True if the copy is consistent, false otherwise (the copy is undefined)
  */
-struct TSCADCLong
+template <typename T>
+inline bool Data_Read(const TSC<T> * tsc, T * value, uint8_t * counter = NULL)
 {
-  uint32_t milliseconds;
-  uint8_t counter;
-  int32_t value;
-  int32_t unfilteredValue;
-};
-
-/* </Structs> */ 
-
-
-/* <Declarations (prototypes)> */ 
+  uint8_t attempt, sequence;
+
+  for (attempt = 0; attempt < DATA_READ_ATTEMPTS; attempt++)
+  {
+    sequence = tsc->sequence;
+    if (sequence & 1)
+    {
+      return false; /* The producer was interrupted by this reader and cannot finish */
+    }
+    DATA_BARRIER();
+    *value = tsc->value;
+    DATA_BARRIER();
+    if (sequence == tsc->sequence)
+    {
+      if (counter != NULL)
+      {
+        *counter = sequence >> 1;
+      }
+      return true;
+    }
+  }
+  return false;
+}
 
 /**
- * Return an uint32_t number from array of unchars
+ * Copies a consistent value if it was published after the last read
  *
- * @param value[] - array of uint8_t from which to construct the result, LSB first
+ * @param tsc - structure to read
+ * @param counter - counter of the last read value, updated when a new value is copied
+ * @param value - copy of the value
  *
- * @return - Value as an uint32_t
+ * @return - True if a new value was copied, false otherwise
  */
-inline uint32_t Data_GetULongFromUCharArray(const uint8_t value[])
+template <typename T>
+inline bool Data_ReadNew(const TSC<T> * tsc, uint8_t * counter, T * value)
 {
-  return ((uint32_t)(value[3])) << 24 |
-         ((uint32_t)(value[2])) << 16 |
-         ((uint32_t)(value[1])) << 8 |
-          (uint32_t)(value[0]);
+  return (Data_GetCounter(tsc) != *counter) && Data_Read(tsc, value, counter);
 }
 
 /**
- * Return an uint16_t number from array of unchars
+ * Returns a consistent copy of the value, for the main loop only (an interrupt cannot wait for the producer)
  *
- * @param value[] - array of uint8_t from which to construct the result, LSB first
+ * @param tsc - structure to read
  *
- * @return - Value as an uint16_t
+ * @return - Copy of the value
  */
-inline uint16_t Data_GetUIntFromUCharArray(const uint8_t value[])
+template <typename T>
+inline T Data_GetValue(const TSC<T> * tsc)
 {
-  return ((uint16_t)(value[1])) << 8 |
-          (uint16_t)(value[0]);
+  T value;
+
+  while (!Data_Read(tsc, &value)) {}
+  return value;
 }
 
 /* </Declarations (prototypes)> */ 
@@ -8,21 +8,9 @@
  
 /* <Includes> */ 
 
-#include "AD569xR.h"
-#include "ADC.h"
-#include "ADS1x15.h"
-#include "Ammeter.h"
-#include "Communication.h"
-#include "Control.h"
-#include "CurrentSetter.h"
-#include "DACC.h"
-#include "Limiter.h"
-#include "Measurement.h"
-#include "Thermometer.h"
-#include "VoltageSetter.h"
-#include "Voltmeter.h"
 #include "Flashreader.h"
 #include "ErrorMessaging.h"
+#include "Events.h"
 
 #include "Arduino.h"
 #include "MightyWatt.h"
@@ -60,16 +48,18 @@ static const char Thermometer_HardwareFault[] FLASHMEMORY = "Thermometer fault";
 static const char VoltageSetter_SetVoltageOverload[] FLASHMEMORY = "Requested voltage cannot be set";
 static const char Voltmeter_VoltageOverload[] FLASHMEMORY = "Voltmeter overload";
 static const char Voltmeter_NegativeVoltage[] FLASHMEMORY = "Voltmeter negative voltage detected";
+static const char I2C_TransactionFailed[] FLASHMEMORY = "I2C transaction failed";
 
-const char * ErrorMessaging_ErrorNames[] = 
+const char * const ErrorMessaging_ErrorNames[] FLASHMEMORY =
 {
   ADC_Overload, ADC_NotResponding, ADS1x15_ResultNotReady, AD569xR_Overload, Ammeter_CurrentOverload, Ammeter_NegativeCurrent,
   Communication_CommandTimeout, CurrentSetter_SetCurrentOverload, DACC_Overload, DACC_UpperLimitReached, DACC_LowerLimitReached,
   Limiter_CurrentOverload, Limiter_VoltageOverload, Limiter_PowerOverload, Limiter_SOAExceeded, Limiter_Overheat, Limiter_HardwareFault,
-  Measurement_Invalid, Thermometer_HardwareFault, VoltageSetter_SetVoltageOverload, Voltmeter_VoltageOverload, Voltmeter_NegativeVoltage
+  Measurement_Invalid, Thermometer_HardwareFault, VoltageSetter_SetVoltageOverload, Voltmeter_VoltageOverload, Voltmeter_NegativeVoltage,
+  I2C_TransactionFailed
 };
 
-const uint8_t ErrorMessaging_ErrorSizes[] =
+const uint8_t ErrorMessaging_ErrorSizes[] FLASHMEMORY =
 {
   sizeof(ADC_Overload) / sizeof(char),
   sizeof(ADC_NotResponding) / sizeof(char),
@@ -95,47 +85,12 @@ const uint8_t ErrorMessaging_ErrorSizes[] =
   sizeof(Thermometer_HardwareFault) / sizeof(char),
   sizeof(VoltageSetter_SetVoltageOverload) / sizeof(char),
   sizeof(Voltmeter_VoltageOverload) / sizeof(char),
-  sizeof(Voltmeter_NegativeVoltage) / sizeof(char)
+  sizeof(Voltmeter_NegativeVoltage) / sizeof(char),
+  
+  sizeof(I2C_TransactionFailed) / sizeof(char)
 };
 
-static const ErrorMessaging_Error * AD569xRError;
-static uint8_t AD569xRErrorCounter;
-
-static const ErrorMessaging_Error * ADCError[ADC_CHANNEL_COUNT];
-static uint8_t ADCErrorCounter[ADC_CHANNEL_COUNT];
-
-static const ErrorMessaging_Error * ADS1x15Error;
-static uint8_t ADS1x15ErrorCounter;
-
-static const ErrorMessaging_Error * AmmeterError;
-static uint8_t AmmeterErrorCounter;
-
-static const ErrorMessaging_Error * CommunicationError;
-static uint8_t CommunicationErrorCounter;
-
-static const ErrorMessaging_Error * ControlError;
-static uint8_t ControlErrorCounter;
-
-static const ErrorMessaging_Error * CurrentSetterError;
-static uint8_t CurrentSetterErrorCounter;
-
-static const ErrorMessaging_Error * DACError;
-static uint8_t DACErrorCounter;
-
-static const ErrorMessaging_Error * LimiterError;
-static uint8_t LimiterErrorCounter;
-
-static const ErrorMessaging_Error * MeasurementError;
-static uint8_t MeasurementErrorCounter;
-
-static const ErrorMessaging_Error * ThermometerError;
-static uint8_t ThermometerErrorCounter;
-
-static const ErrorMessaging_Error * VoltageSetterError;
-static uint8_t VoltageSetterErrorCounter;
-
-static const ErrorMessaging_Error * VoltmeterError;
-static uint8_t VoltmeterErrorCounter;
+static uint32_t pendingFlags; /* Errors raised since the last call of ErrorMessaging_GetErrorFlags */
 
 /* </Module variables> */ 
 
@@ -143,138 +98,23 @@ static uint8_t VoltmeterErrorCounter;
 /* <Implementations> */ 
 
 void ErrorMessaging_Init(void)
-{  
-  uint8_t i;
-  
-  AD569xRError = AD569xR_GetError();
-  AD569xRErrorCounter = AD569xRError->errorCounter;
-  
-  for (i = 0; i < ADC_CHANNEL_COUNT; i++)
-  {
-    ADCError[i] = ADC_GetError((ADC_Channels)i);
-    ADCErrorCounter[i] = ADCError[i]->errorCounter;
-  }
+{
+  pendingFlags = 0;
+}
 
-  ADS1x15Error = ADS1x15_GetError();
-  ADS1x15ErrorCounter = ADS1x15Error->errorCounter;
-  
-  AmmeterError = Ammeter_GetError();
-  AmmeterErrorCounter = AmmeterError->errorCounter;
-  
-  CommunicationError = Communication_GetError();
-  CommunicationErrorCounter = CommunicationError->errorCounter;
-  
-  ControlError = Control_GetError();
-  ControlErrorCounter = ControlError->errorCounter;
-  
-  CurrentSetterError = CurrentSetter_GetError();
-  CurrentSetterErrorCounter = CurrentSetterError->errorCounter;
-  
-  DACError = DACC_GetError();
-  DACErrorCounter = DACError->errorCounter;
-  
-  LimiterError = Limiter_GetError();
-  LimiterErrorCounter = LimiterError->errorCounter;
-  
-  MeasurementError = Measurement_GetError();
-  MeasurementErrorCounter = MeasurementError->errorCounter;
-  
-  ThermometerError = Thermometer_GetError();
-  ThermometerErrorCounter = ThermometerError->errorCounter;
-  
-  VoltageSetterError = VoltageSetter_GetError();
-  VoltageSetterErrorCounter = VoltageSetterError->errorCounter;
-  
-  VoltmeterError = Voltmeter_GetError();
-  VoltmeterErrorCounter = VoltmeterError->errorCounter;
+void ErrorMessaging_Raise(ErrorMessaging_Error * error, ErrorMessaging_Errors code)
+{
+  error->errorCounter++;
+  error->error = code;
+  pendingFlags |= 1UL << ((uint8_t)code);
+  Events_Publish(Event_Error);
 }
 
 uint32_t ErrorMessaging_GetErrorFlags(void)
 {
-  uint8_t i;
-  uint32_t flag = 0;  
-  
-  if (AD569xRErrorCounter != AD569xRError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(AD569xRError->error));
-    AD569xRErrorCounter = AD569xRError->errorCounter;
-  }
-  
-  for (i = 0; i < ADC_CHANNEL_COUNT; i++)
-  {
-    if (ADCErrorCounter[i] != ADCError[i]->errorCounter)
-    {
-      flag |= 1UL << ((uint8_t)(ADCError[i]->error));
-      ADCErrorCounter[i] = ADCError[i]->errorCounter;
-    }
-  }
-  
-  if (ADS1x15ErrorCounter != ADS1x15Error->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(ADS1x15Error->error));
-    ADS1x15ErrorCounter = ADS1x15Error->errorCounter;
-  }
-  
-  if (AmmeterErrorCounter != AmmeterError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(AmmeterError->error));
-    AmmeterErrorCounter = AmmeterError->errorCounter;
-  }
-  
-  if (CommunicationErrorCounter != CommunicationError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(CommunicationError->error));
-    CommunicationErrorCounter = CommunicationError->errorCounter;
-  }
-  
-  if (ControlErrorCounter != ControlError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(ControlError->error));
-    ControlErrorCounter = ControlError->errorCounter;
-  }
-  
-  if (CurrentSetterErrorCounter != CurrentSetterError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(CurrentSetterError->error));
-    CurrentSetterErrorCounter = CurrentSetterError->errorCounter;
-  }
-  
-  if (DACErrorCounter != DACError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(DACError->error));
-    DACErrorCounter = DACError->errorCounter;
-  }
-  
-  if (LimiterErrorCounter != LimiterError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(LimiterError->error));
-    LimiterErrorCounter = LimiterError->errorCounter;
-  }
-  
-  if (MeasurementErrorCounter != MeasurementError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(MeasurementError->error));
-    MeasurementErrorCounter = MeasurementError->errorCounter;
-  }
-  
-  if (ThermometerErrorCounter != ThermometerError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(ThermometerError->error));
-    ThermometerErrorCounter = ThermometerError->errorCounter;
-  }
-    
-  if (VoltageSetterErrorCounter != VoltageSetterError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(VoltageSetterError->error));
-    VoltageSetterErrorCounter = VoltageSetterError->errorCounter;
-  }
-  
-  if (VoltmeterErrorCounter != VoltmeterError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(VoltmeterError->error));
-    VoltmeterErrorCounter = VoltmeterError->errorCounter;
-  }
-  
+  uint32_t flag = pendingFlags;
+
+  pendingFlags = 0;
   return flag;
 }
 
@@ -285,7 +125,20 @@ uint8_t ErrorMessaging_ErrorNamesCount(void)
 
 void ErrorMessaging_GetError(uint8_t errorNumber, char * message)
 {
-  Flashreader_Read((uint8_t*)message, (uint8_t*)(ErrorMessaging_ErrorNames[errorNumber]), ErrorMessaging_ErrorSizes[errorNumber]);
+  Flashreader_Read((uint8_t*)message, (const uint8_t*)ErrorMessaging_GetErrorName(errorNumber), ErrorMessaging_GetErrorSize(errorNumber));
+}
+
+const char * ErrorMessaging_GetErrorName(uint8_t errorNumber)
+{
+  const char * name;
+
+  Flashreader_Read((uint8_t*)&name, (const uint8_t*)&(ErrorMessaging_ErrorNames[errorNumber]), sizeof(name));
+  return name;
+}
+
+uint8_t ErrorMessaging_GetErrorSize(uint8_t errorNumber)
+{
+  return Flashreader_ReadByte(&(ErrorMessaging_ErrorSizes[errorNumber]));
 }
 
 /* </Implementations> */
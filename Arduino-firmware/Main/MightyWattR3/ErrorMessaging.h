@@ -46,7 +46,8 @@ enum ErrorMessaging_Errors : uint8_t
   ErrorMessaging_Thermometer_HardwareFault,		/* critical */
   ErrorMessaging_VoltageSetter_SetVoltageOverload,	/* warning */
   ErrorMessaging_Voltmeter_VoltageOverload,		/* critical */
-  ErrorMessaging_Voltmeter_NegativeVoltage		/* critical */
+  ErrorMessaging_Voltmeter_NegativeVoltage,		/* critical */
+  ErrorMessaging_I2C_TransactionFailed    /* warning, appended to keep the flag bits of the other errors */
 };
 
 /* </Enums> */
@@ -69,9 +70,14 @@ struct ErrorMessaging_Error
 /* <Exported variables> */
 
 /**
- * Pointer to array of error names
+ * Pointer to array of error names, the array is in flash memory
  */
-extern const char * ErrorMessaging_ErrorNames[];
+extern const char * const ErrorMessaging_ErrorNames[];
+
+/**
+ * Pointer to array of error name sizes (including the terminating zero), the array is in flash memory
+ */
+extern const uint8_t ErrorMessaging_ErrorSizes[];
 
 /* </Exported variables> */
 
@@ -84,7 +90,15 @@ extern const char * ErrorMessaging_ErrorNames[];
 void ErrorMessaging_Init(void);
 
 /**
- * Gets a flag word indicating which errors are active
+ * Signals an error of a module, increments its error counter and publishes Event_Error
+ *
+ * @param error - error structure of the module
+ * @param code - error that has occured
+ */
+void ErrorMessaging_Raise(ErrorMessaging_Error * error, ErrorMessaging_Errors code);
+
+/**
+ * Gets a flag word indicating which errors were raised since the last call
  *
  * @return - flag word with active errors
  */
@@ -105,6 +119,24 @@ uint8_t ErrorMessaging_ErrorNamesCount(void);
  */
 void ErrorMessaging_GetError(uint8_t errorNumber, char * message);
 
+/**
+ * Gets the name of an error in flash memory
+ *
+ * @param errorNumber - the number of unique error
+ *
+ * @return - Pointer to the name in flash memory
+ */
+const char * ErrorMessaging_GetErrorName(uint8_t errorNumber);
+
+/**
+ * Gets the size of an error name
+ *
+ * @param errorNumber - the number of unique error
+ *
+ * @return - Size of the name including the terminating zero
+ */
+uint8_t ErrorMessaging_GetErrorSize(uint8_t errorNumber);
+
 /* </Declarations (prototypes)> */
 
 #endif /* ERRORMESSAGING_H */
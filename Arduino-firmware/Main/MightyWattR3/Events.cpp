@@ -0,0 +1,79 @@
+/**
+ * Events.cpp
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+/* <Includes> */
+
+#include "Arduino.h"
+#include "Events.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static Events_Subscription Subscriptions[EVENTS_SUBSCRIPTIONS_MAXIMUM];
+static uint8_t SubscriptionCount;
+
+/* </Module variables> */
+
+
+/* <Implementations> */
+
+void Events_Init(void)
+{
+  SubscriptionCount = 0;
+}
+
+uint8_t Events_Subscribe(uint16_t events)
+{
+  if (SubscriptionCount >= EVENTS_SUBSCRIPTIONS_MAXIMUM)
+  {
+    return EVENTS_NO_SUBSCRIPTION;
+  }
+  Subscriptions[SubscriptionCount].events = events;
+  Subscriptions[SubscriptionCount].pending = 0;
+  SubscriptionCount++;
+  return SubscriptionCount - 1;
+}
+
+void Events_Publish(uint16_t events)
+{
+  uint8_t i;
+  uint32_t now = micros();
+
+  for (i = 0; i < SubscriptionCount; i++)
+  {
+    if (events & Subscriptions[i].events)
+    {
+      if (Subscriptions[i].pending == 0)
+      {
+        Subscriptions[i].published = now; /* The oldest pending event tells how long the subscriber has been waiting */
+      }
+      Subscriptions[i].pending |= events & Subscriptions[i].events;
+    }
+  }
+}
+
+uint16_t Events_Take(uint8_t subscription, uint32_t * published)
+{
+  uint16_t events;
+
+  if (subscription >= SubscriptionCount)
+  {
+    return 0;
+  }
+  events = Subscriptions[subscription].pending;
+  if (events != 0)
+  {
+    *published = Subscriptions[subscription].published;
+    Subscriptions[subscription].pending = 0;
+  }
+  return events;
+}
+
+/* </Implementations> */
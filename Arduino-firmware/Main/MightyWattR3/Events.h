@@ -0,0 +1,103 @@
+/**
+ * Events.h
+ * Publish/subscribe event bus
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef EVENTS_H
+#define EVENTS_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define EVENTS_SUBSCRIPTIONS_MAXIMUM            14 /* Maximum number of subscriptions */
+#define EVENTS_NO_SUBSCRIPTION                  0xFF /* Handle returned when no subscription is left */
+#define EVENTS_ADC_SAMPLE(channel)              (1U << (channel)) /* Event of a new sample of an ADC channel */
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+/**
+ * Events published by the modules
+ */
+enum Events_Types : uint16_t
+{
+  Event_ADCVoltage = 1U << 0, /* new sample of ADC_V, EVENTS_ADC_SAMPLE(ADC_V) */
+  Event_ADCCurrent = 1U << 1, /* new sample of ADC_I, EVENTS_ADC_SAMPLE(ADC_I) */
+  Event_ADCTemperature = 1U << 2, /* new sample of ADC_T, EVENTS_ADC_SAMPLE(ADC_T) */
+  Event_Voltage = 1U << 3, /* new voltage from Voltmeter */
+  Event_Current = 1U << 4, /* new current from Ammeter */
+  Event_Temperature = 1U << 5, /* new temperature from Thermometer */
+  Event_Measurement = 1U << 6, /* new measurement values */
+  Event_Command = 1U << 7, /* new write command in the command queue */
+  Event_ReadCommand = 1U << 8, /* new read command */
+  Event_Error = 1U << 9 /* error raised by any module */
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * Subscription of a module to events
+ */
+struct Events_Subscription
+{
+  uint16_t events; /* Events_Types the module subscribed to */
+  uint16_t pending; /* Events_Types published since the module took them last time */
+  uint32_t published; /* micros() of the oldest pending event */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the module, removes all subscriptions
+ */
+void Events_Init(void);
+
+/**
+ * Registers a subscription, at most EVENTS_SUBSCRIPTIONS_MAXIMUM
+ * Handles of subsequent subscriptions are consecutive
+ *
+ * @param events - Events_Types ORed together
+ *
+ * @return - handle of the subscription, EVENTS_NO_SUBSCRIPTION if there is no subscription left
+ */
+uint8_t Events_Subscribe(uint16_t events);
+
+/**
+ * Publishes events to all subscriptions, a subscription without pending events records the time of publishing
+ *
+ * @param events - Events_Types ORed together
+ */
+void Events_Publish(uint16_t events);
+
+/**
+ * Takes the pending events of a subscription
+ *
+ * @param subscription - handle of the subscription
+ * @param published - micros() of the oldest taken event, unchanged if there is none
+ *
+ * @return - Events_Types published since the last call, 0 if none or the handle is not valid
+ */
+uint16_t Events_Take(uint8_t subscription, uint32_t * published);
+
+/* </Declarations (prototypes)> */
+
+
+#endif /* EVENTS_H */
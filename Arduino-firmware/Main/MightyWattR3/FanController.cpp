@@ -21,10 +21,9 @@
 
 /* <Module variables> */ 
 
-static const Communication_WriteCommand * writeCommand; /* Pointer to the write command where new data from communication can be found */
+static Communication_WriteCommandCursor commandCursor; /* Position of this module in the received write commands */
 static const Measurement_Values * measurementValues; /* Pointer to the latest measured voltage, current, power and resistance */
 static const TSCUChar * temperature; /* Pointer to structure where temperature can be found */
-static uint8_t commandCounter/*, measurementCounter, temperatureCounter*/; /* Number of the last executed command from communication, number of the last measurement data, number of the last temperature data */
 static FanController_Rules FanRules; /* Describes under which circumstances the fan will be on and off */
 void (* FanController_Keep)(void); /* Pointer to the constant keeper function */
 static uint32_t FanStartTime; /* Time when fan started, to avoid excessive on/off switching */
@@ -46,10 +45,9 @@ void FanController_KeepRule(void);
 
 void FanController_Init(void)
 {
-  writeCommand = Communication_GetWriteCommand();  
+  Communication_InitWriteCommandCursor(&commandCursor, COMMUNICATION_COMMAND_BIT(WriteCommand_FanRules));
   measurementValues = Measurement_GetValues();
   temperature = Thermometer_GetTemperature();
-  commandCounter = 0;
   FanRules = FAN_CONTROLLER_DEFAULT_RULE;
   FanController_Keep = &FanController_KeepRule;
   FanStartTime = 0;
@@ -57,28 +55,34 @@ void FanController_Init(void)
 
 void FanController_Do(void)
 {
-  /* Check new command */
-  if (writeCommand->commandCounter != commandCounter)
+  const Communication_Command * newCommand;
+
+  /* Check new commands */
+  while ((newCommand = Communication_GetNextWriteCommand(&commandCursor)) != NULL)
   {
     /* LSB first */
-    switch (writeCommand->command)
+    switch (newCommand->command)
     {
       case WriteCommand_FanRules:
       {
-        uint8_t newRules = (writeCommand->data)[0];
+        uint8_t newRules = (newCommand->data)[0];
         if (newRules < FAN_CONTROLLER_RULES_COUNT)
         {
           FanRules = (FanController_Rules)newRules;
           FanController_Keep = &FanController_KeepRule;
           FanStartTime = millis() - FAN_CONTROLLER_MINIMUM_ONTIME; /* allows immediate change upon receiving command */
-        }          
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
+        }
+        else
+        {
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_InvalidValue);
+        }
         break;
       }
       default:
       /* command handled by other modules */
       break;
     }
-    commandCounter = writeCommand->commandCounter;
   }  
   
   if (FanController_Keep != NULL)
@@ -94,39 +98,39 @@ void FanController_KeepRule(void)
   switch (FanRules)
   {
     case FanRule_AutoHigh:
-      if ((measurementCounter != measurementValues->counter) && (temperatureCounter != temperature->counter)) /* Only process new values */
+      if ((measurementCounter != measurementValues->counter) && (temperatureCounter != Data_GetCounter(temperature))) /* Only process new values */
       {
-        if ((temperature->value > FAN_CONTROLLER_AUTOHIGH_TEMP_UP) || (measurementValues->power > FAN_CONTROLLER_AUTOHIGH_P_UP))
+        if ((Data_GetValue(temperature) > FAN_CONTROLLER_AUTOHIGH_TEMP_UP) || (measurementValues->power > FAN_CONTROLLER_AUTOHIGH_P_UP))
         {
           Fan_Set(Fan_On);
           FanStartTime = millis();
         }
-        else if ((temperature->value < FAN_CONTROLLER_AUTOHIGH_TEMP_DOWN) && (measurementValues->power < FAN_CONTROLLER_AUTOHIGH_P_DOWN) && ((millis() - FanStartTime) > FAN_CONTROLLER_MINIMUM_ONTIME))
+        else if ((Data_GetValue(temperature) < FAN_CONTROLLER_AUTOHIGH_TEMP_DOWN) && (measurementValues->power < FAN_CONTROLLER_AUTOHIGH_P_DOWN) && ((millis() - FanStartTime) > FAN_CONTROLLER_MINIMUM_ONTIME))
         {
           Fan_Set(Fan_Off);  
         }
         /* Otherwise no change */
         
         measurementCounter = measurementValues->counter;
-        temperatureCounter = temperature->counter;
+        temperatureCounter = Data_GetCounter(temperature);
       }        
     break;
     case FanRule_AutoLow:
-      if ((measurementCounter != measurementValues->counter) && (temperatureCounter != temperature->counter)) /* Only process new values */
+      if ((measurementCounter != measurementValues->counter) && (temperatureCounter != Data_GetCounter(temperature))) /* Only process new values */
       {
-        if ((temperature->value > FAN_CONTROLLER_AUTOLOW_TEMP_UP) || (measurementValues->power > FAN_CONTROLLER_AUTOLOW_P_UP))
+        if ((Data_GetValue(temperature) > FAN_CONTROLLER_AUTOLOW_TEMP_UP) || (measurementValues->power > FAN_CONTROLLER_AUTOLOW_P_UP))
         {
           Fan_Set(Fan_On);
           FanStartTime = millis();
         }
-        else if ((temperature->value < FAN_CONTROLLER_AUTOLOW_TEMP_DOWN) && (measurementValues->power < FAN_CONTROLLER_AUTOLOW_P_DOWN) && ((millis() - FanStartTime) > FAN_CONTROLLER_MINIMUM_ONTIME))
+        else if ((Data_GetValue(temperature) < FAN_CONTROLLER_AUTOLOW_TEMP_DOWN) && (measurementValues->power < FAN_CONTROLLER_AUTOLOW_P_DOWN) && ((millis() - FanStartTime) > FAN_CONTROLLER_MINIMUM_ONTIME))
         {
           Fan_Set(Fan_Off);  
         }
         /* Otherwise no change */
         
         measurementCounter = measurementValues->counter;
-        temperatureCounter = temperature->counter;
+        temperatureCounter = Data_GetCounter(temperature);
       }
     break;
     case FanRule_AlwaysOn:
@@ -137,4 +141,9 @@ void FanController_KeepRule(void)
   }
 }
 
+FanController_Rules FanController_GetRules(void)
+{
+  return FanRules;
+}
+
 /* </Implementations> */ 
@@ -69,6 +69,13 @@ void FanController_Init(void);
  */
 void FanController_Do(void);
 
+/**
+ * Gets the present fan rules
+ *
+ * @return - Fan rules
+ */
+FanController_Rules FanController_GetRules(void);
+
 /* </Declarations (prototypes)> */ 
 
 
@@ -0,0 +1,186 @@
+/**
+ * FastPin.h
+ * Digital pin access resolved at compile time
+ *
+ * The port register and bit of a pin are computed from the template parameter,
+ * an access compiles to a single instruction (sbi/cbi/sbis on UNO, one store or load on ZERO)
+ * instead of the table lookups and interrupt locking of digitalWrite/digitalRead.
+ * The pin must be configured by pinMode first. Unlike digitalWrite, PWM on the pin is not disconnected.
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef FASTPIN_H
+#define FASTPIN_H
+
+/* <Includes> */
+
+#include "Arduino.h"
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#ifdef UNO
+  #define FASTPIN_COUNT                         20 /* D0-D13, A0-A5 */
+#elif defined(ZERO)
+  #define FASTPIN_COUNT                         20 /* D0-D13, A0-A5 */
+  #define FASTPIN_PA(bit)                       (bit) /* Pin code: port group * 32 + bit */
+  #define FASTPIN_PB(bit)                       (32 + (bit))
+#endif
+
+/* </Defines> */
+
+
+/* <Module variables> */
+
+#ifdef ZERO
+/**
+ * SAMD21 port and bit of the Arduino pins
+ */
+static constexpr uint8_t FastPin_Codes[FASTPIN_COUNT] =
+{
+  FASTPIN_PA(11), FASTPIN_PA(10),
+  #ifdef ARDUINO_SAM_ZERO /* Arduino.org M0 and M0 Pro have D2 and D4 swapped against the Zero */
+    FASTPIN_PA(8), FASTPIN_PA(9), FASTPIN_PA(14),
+  #else
+    FASTPIN_PA(14), FASTPIN_PA(9), FASTPIN_PA(8),
+  #endif
+  FASTPIN_PA(15), FASTPIN_PA(20), FASTPIN_PA(21), FASTPIN_PA(6), FASTPIN_PA(7),
+  FASTPIN_PA(18), FASTPIN_PA(16), FASTPIN_PA(19), FASTPIN_PA(17),
+  FASTPIN_PA(2), FASTPIN_PB(8), FASTPIN_PB(9), FASTPIN_PA(4), FASTPIN_PA(5), FASTPIN_PB(2)
+};
+#endif
+
+/* </Module variables> */
+
+
+/* <Implementations> */
+
+#ifdef UNO
+/**
+ * Gets the bit mask of a pin in its port
+ *
+ * @param pin - Arduino pin number
+ *
+ * @return - Bit mask
+ */
+constexpr uint8_t FastPin_Mask(uint8_t pin)
+{
+  return 1 << ((pin < 8) ? pin : ((pin < 14) ? (pin - 8) : (pin - 14))); /* D0-D7 on port D, D8-D13 on port B, A0-A5 on port C */
+}
+
+/**
+ * Gets the output register of a pin
+ *
+ * @param pin - Arduino pin number
+ *
+ * @return - Pointer to PORTx
+ */
+static inline volatile uint8_t * FastPin_OutputRegister(uint8_t pin)
+{
+  return (pin < 8) ? &PORTD : ((pin < 14) ? &PORTB : &PORTC);
+}
+
+/**
+ * Gets the input register of a pin
+ *
+ * @param pin - Arduino pin number
+ *
+ * @return - Pointer to PINx
+ */
+static inline volatile uint8_t * FastPin_InputRegister(uint8_t pin)
+{
+  return (pin < 8) ? &PIND : ((pin < 14) ? &PINB : &PINC);
+}
+#elif defined(ZERO)
+/**
+ * Gets the bit mask of a pin in its port group
+ *
+ * @param pin - Arduino pin number
+ *
+ * @return - Bit mask
+ */
+constexpr uint32_t FastPin_Mask(uint8_t pin)
+{
+  return 1UL << (FastPin_Codes[pin] & 0x1F);
+}
+
+/**
+ * Gets the port group of a pin
+ *
+ * @param pin - Arduino pin number
+ *
+ * @return - Pointer to the port group registers
+ */
+static inline PortGroup * FastPin_Group(uint8_t pin)
+{
+  return &(PORT->Group[FastPin_Codes[pin] >> 5]);
+}
+#endif
+
+/**
+ * Sets a pin output high
+ */
+template <uint8_t pin> static inline void FastPin_High(void)
+{
+  static_assert(pin < FASTPIN_COUNT, "FastPin: pin out of range");
+  #ifdef UNO
+    *FastPin_OutputRegister(pin) |= FastPin_Mask(pin); /* Single sbi, atomic */
+  #elif defined(ZERO)
+    FastPin_Group(pin)->OUTSET.reg = FastPin_Mask(pin);
+  #endif
+}
+
+/**
+ * Sets a pin output low
+ */
+template <uint8_t pin> static inline void FastPin_Low(void)
+{
+  static_assert(pin < FASTPIN_COUNT, "FastPin: pin out of range");
+  #ifdef UNO
+    *FastPin_OutputRegister(pin) &= (uint8_t)~FastPin_Mask(pin); /* Single cbi, atomic */
+  #elif defined(ZERO)
+    FastPin_Group(pin)->OUTCLR.reg = FastPin_Mask(pin);
+  #endif
+}
+
+/**
+ * Sets a pin output
+ *
+ * @param high - True for high level, false for low level
+ */
+template <uint8_t pin> static inline void FastPin_Write(bool high)
+{
+  if (high)
+  {
+    FastPin_High<pin>();
+  }
+  else
+  {
+    FastPin_Low<pin>();
+  }
+}
+
+/**
+ * Reads a pin input
+ *
+ * @return - True for high level, false for low level
+ */
+template <uint8_t pin> static inline bool FastPin_Read(void)
+{
+  static_assert(pin < FASTPIN_COUNT, "FastPin: pin out of range");
+  #ifdef UNO
+    return (*FastPin_InputRegister(pin) & FastPin_Mask(pin)) != 0;
+  #elif defined(ZERO)
+    return (FastPin_Group(pin)->IN.reg & FastPin_Mask(pin)) != 0;
+  #endif
+}
+
+/* </Implementations> */
+
+#endif /* FASTPIN_H */
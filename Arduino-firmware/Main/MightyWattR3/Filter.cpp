@@ -0,0 +1,184 @@
+/**
+ * Filter.cpp
+ * Integer filters of the ADC channels
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "Arduino.h"
+#include "Filter.h"
+
+/* </Includes> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Replaces the oldest sample of the median window by a new one, the sorted half of the history stays sorted
+ *
+ * @param filter - pointer to filter data
+ * @param value - new value to add
+ */
+void Filter_AddMedian(Filter_Data * filter, int32_t value);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+bool Filter_Setup(Filter_Data * filter, Filter_Types type, uint8_t length)
+{
+  switch (type)
+  {
+    case Filter_MovingAverage:
+    case Filter_Triangle:
+      if ((length == 0) || (length > filter->capacity) || (length > FILTER_LENGTH_MAXIMUM))
+      {
+        return false;
+      }
+      break;
+    case Filter_IIR:
+      if ((length == 0) || (length > FILTER_IIR_SHIFT_MAXIMUM))
+      {
+        return false;
+      }
+      break;
+    case Filter_Median:
+      if ((length < 3) || ((length & 1) == 0) || (length > FILTER_MEDIAN_LENGTH_MAXIMUM) || ((2 * length) > filter->capacity))
+      {
+        return false;
+      }
+      break;
+    default:
+      return false;
+  }
+
+  filter->type = type;
+  filter->length = length;
+  Filter_Reset(filter);
+  return true;
+}
+
+void Filter_Add(Filter_Data * filter, int32_t value)
+{
+  filter->lastValue = value;
+  switch (filter->type)
+  {
+    case Filter_MovingAverage:
+      filter->sum -= (filter->data)[filter->index];
+      (filter->data)[filter->index] = value;
+      filter->sum += value;
+      break;
+    case Filter_Triangle:
+      filter->triangleSum -= filter->sum;
+      filter->sum -= (filter->data)[filter->index];
+      (filter->data)[filter->index] = value;
+      filter->triangleSum += value * (int32_t)(filter->length);
+      filter->sum += value;
+      break;
+    case Filter_IIR:
+      if (filter->valid)
+      {
+        filter->iirState += ((value * (1L << FILTER_IIR_FRACTION_BITS)) - filter->iirState) >> filter->length;
+      }
+      else
+      {
+        filter->iirState = value * (1L << FILTER_IIR_FRACTION_BITS);
+        filter->valid = true;
+      }
+      return; /* No history */
+    case Filter_Median:
+      Filter_AddMedian(filter, value);
+      break;
+  }
+
+  filter->index++;
+  if (filter->index >= filter->length)
+  {
+    filter->index = 0;
+    filter->valid = true;
+  }
+}
+
+int32_t Filter_GetValue(const Filter_Data * filter)
+{
+  if (filter->valid)
+  {
+    switch (filter->type)
+    {
+      case Filter_MovingAverage:
+        return (filter->sum + (int32_t)(filter->length) / 2) / (int32_t)(filter->length);
+      case Filter_Triangle:
+      {
+        int32_t totalWeight = ((int32_t)(filter->length) * ((int32_t)(filter->length) + 1)) / 2;
+        return (filter->triangleSum + totalWeight / 2) / totalWeight;
+      }
+      case Filter_IIR:
+        return (filter->iirState + (1L << (FILTER_IIR_FRACTION_BITS - 1))) >> FILTER_IIR_FRACTION_BITS;
+      case Filter_Median:
+        return (filter->data)[filter->length + filter->length / 2]; /* Middle of the sorted half */
+    }
+  }
+  return Filter_GetUnfilteredValue(filter);
+}
+
+int32_t Filter_GetUnfilteredValue(const Filter_Data * filter)
+{
+  return filter->lastValue;
+}
+
+void Filter_Reset(Filter_Data * filter)
+{
+  bool hasValue = filter->valid || (filter->index > 0); /* False before the first sample */
+
+  filter->index = 0;
+  filter->sum = 0;
+  filter->triangleSum = 0;
+  filter->iirState = 0;
+  filter->valid = false;
+  memset(filter->data, 0, filter->capacity * sizeof(int32_t));
+
+  if (hasValue)
+  {
+    Filter_Add(filter, filter->lastValue); // add the last value
+  }
+}
+
+void Filter_AddMedian(Filter_Data * filter, int32_t value)
+{
+  int32_t * sorted = filter->data + filter->length;
+  uint8_t count = filter->valid ? filter->length : filter->index; /* Samples in the sorted half */
+  uint8_t i = 0;
+
+  if (filter->valid)
+  {
+    /* Remove the oldest sample */
+    int32_t oldest = (filter->data)[filter->index];
+    while (sorted[i] != oldest)
+    {
+      i++;
+    }
+    count--;
+    for (; i < count; i++)
+    {
+      sorted[i] = sorted[i + 1];
+    }
+  }
+
+  /* Insert the new sample */
+  i = count;
+  while ((i > 0) && (sorted[i - 1] > value))
+  {
+    sorted[i] = sorted[i - 1];
+    i--;
+  }
+  sorted[i] = value;
+  (filter->data)[filter->index] = value;
+}
+
+/* </Implementations> */
@@ -0,0 +1,117 @@
+/**
+ * Filter.h
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef FILTER_H
+#define FILTER_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define FILTER_TYPES_COUNT              4
+#define FILTER_LENGTH_MAXIMUM           64 /* Triangle sum of full-scale ADC samples still fits int32_t */
+#define FILTER_IIR_SHIFT_MAXIMUM        8  /* Time constant of 2**8 = 256 samples */
+#define FILTER_IIR_FRACTION_BITS        8  /* Fractional bits of the IIR state */
+#define FILTER_MEDIAN_LENGTH_MAXIMUM    15 /* The median window is kept sorted, a sample moves at most 2 * length values */
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+/**
+ * Filter types, all use integer math and have a per-sample cost bounded by their length
+ */
+enum Filter_Types : uint8_t
+{
+  Filter_MovingAverage = 0, /* mean of the last length samples */
+  Filter_Triangle = 1, /* triangle-weighted mean of the last length samples, the newest sample has the largest weight */
+  Filter_IIR = 2, /* single-pole low-pass y += (x - y) / 2**length, does not use the history */
+  Filter_Median = 3 /* median of the last length samples (odd), rejects spikes shorter than length / 2 + 1 samples */
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * Working data of a filter
+ */
+struct Filter_Data
+{
+  int32_t * data; /* History of samples, the median keeps them sorted in the second half of the history */
+  const uint8_t capacity; /* Number of elements of data */
+  Filter_Types type;
+  uint8_t length; /* Number of samples, shift of the IIR filter */
+  uint8_t index; /* Position of the next sample in the history */
+  bool valid; /* History is full or the IIR filter has a sample */
+  int32_t sum;
+  int32_t triangleSum;
+  int32_t iirState; /* Output of the IIR filter with FILTER_IIR_FRACTION_BITS fractional bits */
+  int32_t lastValue;
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Sets the filter type and length and resets the filter
+ *
+ * @param filter - pointer to filter data
+ * @param type - filter type
+ * @param length - number of samples: 1 to the capacity for moving average and triangle, odd 3 to FILTER_MEDIAN_LENGTH_MAXIMUM for median,
+ *                 shift 1 to FILTER_IIR_SHIFT_MAXIMUM for IIR
+ *
+ * @return - True if the filter was set, false if the type or length is invalid or does not fit into the history
+ */
+bool Filter_Setup(Filter_Data * filter, Filter_Types type, uint8_t length);
+
+/**
+ * Adds a value to the filter
+ *
+ * @param filter - pointer to filter data
+ * @param value - new value to add
+ */
+void Filter_Add(Filter_Data * filter, int32_t value);
+
+/**
+ * Gets the filtered value
+ *
+ * @param filter - pointer to filter data
+ *
+ * @return - filtered value if filter is valid, last value otherwise
+ */
+int32_t Filter_GetValue(const Filter_Data * filter);
+
+/**
+ * Gets the last added value to the filter
+ *
+ * @param filter - pointer to filter data
+ *
+ * @return - last value (unfiltered)
+ */
+int32_t Filter_GetUnfilteredValue(const Filter_Data * filter);
+
+/**
+ * Clears the history of the filter and adds the last value again if there was any
+ *
+ * @param filter - pointer to filter data
+ */
+void Filter_Reset(Filter_Data * filter);
+
+/* </Declarations (prototypes)> */
+
+#endif /* FILTER_H */
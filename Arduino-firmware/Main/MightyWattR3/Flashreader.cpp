@@ -35,4 +35,15 @@ void Flashreader_Read(uint8_t* to_ptr, const uint8_t* from_ptr, uint8_t array_le
   }
 }
 
+uint8_t Flashreader_ReadByte(const uint8_t* from_ptr)
+{
+  #ifdef UNO
+    return pgm_read_byte(from_ptr);
+  #elif defined(ZERO)
+    return *from_ptr;
+  #else
+    return 0;
+  #endif
+}
+
 /* </Implementations> */ 
@@ -30,6 +30,15 @@
  */
 void Flashreader_Read(uint8_t* to_ptr, const uint8_t* from_ptr, uint8_t array_length);
 
+/**
+ * Reads a byte from flash memory
+ *
+ * @param from_ptr - Pointer to the byte
+ *
+ * @return - The byte
+ */
+uint8_t Flashreader_ReadByte(const uint8_t* from_ptr);
+
 /* </Declarations (prototypes)> */
 
 #endif /* FLASHREADER_H */
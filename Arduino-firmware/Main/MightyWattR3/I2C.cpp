@@ -0,0 +1,436 @@
+/**
+ * I2C.cpp
+ * Interrupt-driven I2C transaction queue
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+/* <Includes> */
+
+#include "Arduino.h"
+#include "I2C.h"
+#ifdef UNO
+  #include <util/twi.h>
+#endif
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static I2C_Transaction Queue[I2C_QUEUE_SIZE];
+static volatile uint8_t QueueHead; /* Transaction on the bus or the next one to start */
+static volatile uint8_t QueueTail; /* Next free slot */
+static volatile bool Busy; /* The transaction at the head of the queue is on the bus */
+static volatile uint32_t ActiveStart; /* micros() when the active transaction started */
+static volatile uint8_t WriteIndex, ReadIndex; /* Progress of the active transaction */
+static volatile I2C_Statistics Statistics;
+static I2C_Statistics ReportedStatistics; /* Copy of the counters at the last check of I2C_Do */
+static ErrorMessaging_Error I2CError;
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Sets the bit rate and enables the bus hardware
+ */
+void I2C_InitHardware(void);
+
+/**
+ * Starts the transaction prepared by I2C_Begin on the bus, called with interrupts disabled
+ */
+void I2C_Start(void);
+
+/**
+ * Prepares the transaction at the head of the queue for the bus, called with interrupts disabled
+ *
+ * @return - True if there is a transaction to start, false if the queue is empty
+ */
+bool I2C_Begin(void);
+
+/**
+ * Finishes the transaction at the head of the queue and calls its callback, called with interrupts disabled
+ *
+ * @param status - result of the transaction
+ */
+void I2C_Finish(I2C_Status status);
+
+/**
+ * Releases a slave that holds SDA low by clocking SCL and generating a stop condition
+ */
+void I2C_RecoverBus(void);
+
+/**
+ * Finishes the active transaction with a stop condition and starts the next one, called from the interrupt
+ *
+ * @param status - result of the transaction
+ */
+void I2C_Stop(I2C_Status status);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void I2C_Init(void)
+{
+  noInterrupts();
+  #ifdef UNO
+    TWCR = 0; /* Abort the active transaction */
+  #endif
+  while (QueueHead != QueueTail) /* The owners of the dropped transactions are told by their callbacks */
+  {
+    I2C_Finish(I2C_Aborted);
+  }
+  QueueHead = 0;
+  QueueTail = 0;
+  Busy = false;
+  interrupts();
+
+  Statistics.transactions = 0;
+  Statistics.failures = 0;
+  Statistics.timeouts = 0;
+  Statistics.recoveries = 0;
+  ReportedStatistics.failures = 0;
+  ReportedStatistics.timeouts = 0;
+  I2CError.errorCounter = 0;
+  I2CError.error = ErrorMessaging_I2C_TransactionFailed;
+  I2C_InitHardware();
+}
+
+void I2C_Do(void)
+{
+  uint16_t failures, timeouts;
+
+  noInterrupts();
+  if (Busy && ((micros() - ActiveStart) > I2C_TIMEOUT))
+  {
+    #ifdef UNO
+      TWCR = 0; /* Abort, the TWI releases the bus */
+    #elif defined(ZERO)
+      I2C_SERCOM->I2CM.CTRLA.bit.ENABLE = 0; /* Abort, the SERCOM releases the bus */
+      while (I2C_SERCOM->I2CM.SYNCBUSY.bit.ENABLE) {}
+    #endif
+    Statistics.timeouts++;
+    I2C_Finish(I2C_Timeout);
+    interrupts();
+    I2C_RecoverBus();
+    noInterrupts();
+    if (I2C_Begin())
+    {
+      I2C_Start();
+    }
+  }
+  failures = Statistics.failures; /* 16-bit read is not atomic on 8-bit MCU */
+  timeouts = Statistics.timeouts;
+  interrupts();
+
+  if ((ReportedStatistics.failures != failures) || (ReportedStatistics.timeouts != timeouts))
+  {
+    ReportedStatistics.failures = failures;
+    ReportedStatistics.timeouts = timeouts;
+    ErrorMessaging_Raise(&I2CError, ErrorMessaging_I2C_TransactionFailed);
+  }
+}
+
+bool I2C_Queue(uint8_t address, const uint8_t * writeData, uint8_t writeLength, uint8_t readLength, void (* done)(const I2C_Transaction * transaction))
+{
+  uint8_t i;
+  uint32_t start = micros();
+  I2C_Transaction * transaction;
+
+  if ((writeLength > I2C_WRITE_MAXIMUM_LENGTH) || (readLength > I2C_READ_MAXIMUM_LENGTH) || ((writeLength == 0) && (readLength == 0)))
+  {
+    return false;
+  }
+
+  while (((QueueTail + 1) & I2C_QUEUE_MASK) == QueueHead) /* Queue is full, one slot is always free */
+  {
+    I2C_Do();
+    if ((micros() - start) > I2C_TIMEOUT)
+    {
+      noInterrupts();
+      Statistics.failures++; /* Reported by I2C_Do */
+      interrupts();
+      return false;
+    }
+  }
+
+  transaction = &(Queue[QueueTail]);
+  transaction->address = address;
+  transaction->writeLength = writeLength;
+  transaction->readLength = readLength;
+  for (i = 0; i < writeLength; i++)
+  {
+    transaction->writeData[i] = writeData[i];
+  }
+  transaction->done = done;
+  transaction->status = I2C_Queued;
+
+  noInterrupts();
+  QueueTail = (QueueTail + 1) & I2C_QUEUE_MASK;
+  if ((!Busy) && I2C_Begin())
+  {
+    I2C_Start();
+  }
+  interrupts();
+  return true;
+}
+
+void I2C_Flush(void)
+{
+  while (Busy)
+  {
+    I2C_Do(); /* Aborts a stuck transaction */
+  }
+}
+
+const I2C_Statistics * I2C_GetStatistics(void)
+{
+  return (const I2C_Statistics *)&Statistics;
+}
+
+const ErrorMessaging_Error * I2C_GetError(void)
+{
+  return &I2CError;
+}
+
+void I2C_InitHardware(void)
+{
+  #ifdef UNO
+    digitalWrite(SDA, HIGH); /* Internal pull-ups */
+    digitalWrite(SCL, HIGH);
+    TWSR = 0; /* Prescaler 1 */
+    TWBR = ((F_CPU / I2C_FREQUENCY) - 16) / 2;
+    TWCR = _BV(TWEN);
+  #elif defined(ZERO)
+    NVIC_DisableIRQ(I2C_SERCOM_IRQ);
+    PM->APBCMASK.reg |= I2C_SERCOM_APB;
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | I2C_SERCOM_CLOCK; /* 48 MHz to the SERCOM */
+    while (GCLK->STATUS.bit.SYNCBUSY) {}
+    I2C_SERCOM->I2CM.CTRLA.reg = SERCOM_I2CM_CTRLA_SWRST; /* Also aborts a transaction on the bus */
+    while (I2C_SERCOM->I2CM.CTRLA.bit.SWRST || I2C_SERCOM->I2CM.SYNCBUSY.bit.SWRST) {}
+    I2C_SERCOM->I2CM.CTRLA.reg = SERCOM_I2CM_CTRLA_MODE_I2C_MASTER; /* Smart mode off, every acknowledge is commanded by the interrupt */
+    I2C_SERCOM->I2CM.BAUD.reg = SERCOM_I2CM_BAUD_BAUD(I2C_BAUD);
+    I2C_SERCOM->I2CM.INTENSET.reg = SERCOM_I2CM_INTENSET_MB | SERCOM_I2CM_INTENSET_SB | SERCOM_I2CM_INTENSET_ERROR;
+    I2C_SERCOM->I2CM.CTRLA.bit.ENABLE = 1;
+    while (I2C_SERCOM->I2CM.SYNCBUSY.bit.ENABLE) {}
+    I2C_SERCOM->I2CM.STATUS.bit.BUSSTATE = 1; /* The bus state is unknown after enabling, force idle */
+    while (I2C_SERCOM->I2CM.SYNCBUSY.bit.SYSOP) {}
+    /* Pins to peripheral function C, pinMode in I2C_RecoverBus switches them back to GPIO */
+    PORT->Group[0].PINCFG[I2C_SDA_PORT_PIN].reg = PORT_PINCFG_PMUXEN | PORT_PINCFG_INEN;
+    PORT->Group[0].PINCFG[I2C_SCL_PORT_PIN].reg = PORT_PINCFG_PMUXEN | PORT_PINCFG_INEN;
+    PORT->Group[0].PMUX[I2C_SDA_PORT_PIN >> 1].reg = PORT_PMUX_PMUXE_C | PORT_PMUX_PMUXO_C;
+    NVIC_ClearPendingIRQ(I2C_SERCOM_IRQ);
+    NVIC_EnableIRQ(I2C_SERCOM_IRQ);
+  #endif
+}
+
+void I2C_Start(void)
+{
+  #ifdef UNO
+    TWCR = I2C_TWCR_CONTINUE | _BV(TWSTA);
+  #elif defined(ZERO)
+    I2C_Transaction * transaction = &(Queue[QueueHead]);
+
+    /* Start condition and address, the interrupt comes when the address is acknowledged (MB for write, SB with the first byte for read) */
+    I2C_SERCOM->I2CM.ADDR.reg = SERCOM_I2CM_ADDR_ADDR((transaction->address << 1) | ((transaction->writeLength > 0) ? 0 : 1));
+  #endif
+}
+
+bool I2C_Begin(void)
+{
+  if (QueueHead == QueueTail)
+  {
+    Busy = false;
+    return false;
+  }
+  Busy = true;
+  Queue[QueueHead].status = I2C_Active;
+  WriteIndex = 0;
+  ReadIndex = 0;
+  ActiveStart = micros();
+  return true;
+}
+
+void I2C_Finish(I2C_Status status)
+{
+  I2C_Transaction * transaction = &(Queue[QueueHead]);
+
+  transaction->status = status;
+  Statistics.transactions++;
+  if ((status == I2C_Nack) || (status == I2C_BusError))
+  {
+    Statistics.failures++;
+  }
+  if (transaction->done != NULL)
+  {
+    transaction->done(transaction);
+  }
+  QueueHead = (QueueHead + 1) & I2C_QUEUE_MASK;
+  Busy = false;
+}
+
+void I2C_RecoverBus(void)
+{
+  uint8_t i;
+
+  /* The pins are driven low as outputs and released as inputs (open drain) */
+  digitalWrite(SDA, LOW);
+  digitalWrite(SCL, LOW);
+  pinMode(SDA, INPUT);
+  for (i = 0; (i < I2C_RECOVERY_CLOCKS) && (digitalRead(SDA) == LOW); i++)
+  {
+    pinMode(SCL, OUTPUT);
+    delayMicroseconds(I2C_RECOVERY_HALF_PERIOD);
+    pinMode(SCL, INPUT);
+    delayMicroseconds(I2C_RECOVERY_HALF_PERIOD);
+  }
+  /* Stop condition: SDA goes high while SCL is high */
+  pinMode(SDA, OUTPUT);
+  delayMicroseconds(I2C_RECOVERY_HALF_PERIOD);
+  pinMode(SDA, INPUT);
+  delayMicroseconds(I2C_RECOVERY_HALF_PERIOD);
+  Statistics.recoveries++;
+  I2C_InitHardware();
+}
+
+#ifdef UNO
+void I2C_Stop(I2C_Status status)
+{
+  I2C_Finish(status);
+  if (I2C_Begin())
+  {
+    TWCR = I2C_TWCR_CONTINUE | _BV(TWSTO) | _BV(TWSTA); /* Stop followed by start of the next transaction */
+  }
+  else
+  {
+    TWCR = _BV(TWEN) | _BV(TWINT) | _BV(TWSTO);
+  }
+}
+
+ISR(TWI_vect)
+{
+  I2C_Transaction * transaction = &(Queue[QueueHead]);
+
+  switch (TW_STATUS)
+  {
+    case TW_START:
+    case TW_REP_START:
+      TWDR = (transaction->address << 1) | ((WriteIndex < transaction->writeLength) ? TW_WRITE : TW_READ);
+      TWCR = I2C_TWCR_CONTINUE;
+      break;
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+      if (WriteIndex < transaction->writeLength)
+      {
+        TWDR = transaction->writeData[WriteIndex];
+        WriteIndex++;
+        TWCR = I2C_TWCR_CONTINUE;
+      }
+      else if (transaction->readLength > 0)
+      {
+        TWCR = I2C_TWCR_CONTINUE | _BV(TWSTA); /* Repeated start for reading */
+      }
+      else
+      {
+        I2C_Stop(I2C_Done);
+      }
+      break;
+    case TW_MR_SLA_ACK:
+      TWCR = (transaction->readLength > 1) ? (I2C_TWCR_CONTINUE | _BV(TWEA)) : I2C_TWCR_CONTINUE; /* The last byte is not acknowledged */
+      break;
+    case TW_MR_DATA_ACK:
+      transaction->readData[ReadIndex] = TWDR;
+      ReadIndex++;
+      TWCR = ((ReadIndex + 1) < transaction->readLength) ? (I2C_TWCR_CONTINUE | _BV(TWEA)) : I2C_TWCR_CONTINUE;
+      break;
+    case TW_MR_DATA_NACK:
+      transaction->readData[ReadIndex] = TWDR;
+      ReadIndex++;
+      I2C_Stop(I2C_Done);
+      break;
+    case TW_MT_SLA_NACK:
+    case TW_MT_DATA_NACK:
+    case TW_MR_SLA_NACK:
+      I2C_Stop(I2C_Nack);
+      break;
+    default: /* Arbitration lost or bus error */
+      I2C_Stop(I2C_BusError);
+      break;
+  }
+}
+#elif defined(ZERO)
+void I2C_Stop(I2C_Status status)
+{
+  I2C_SERCOM->I2CM.CTRLB.reg = I2C_COMMAND_STOP; /* The acknowledge action applies only to a read */
+  while (I2C_SERCOM->I2CM.SYNCBUSY.bit.SYSOP) {}
+  I2C_Finish(status);
+  if (I2C_Begin())
+  {
+    I2C_Start(); /* The start condition waits until the stop is on the bus */
+  }
+}
+
+void SERCOM3_Handler(void)
+{
+  I2C_Transaction * transaction = &(Queue[QueueHead]);
+  uint8_t flags = I2C_SERCOM->I2CM.INTFLAG.reg;
+  uint16_t status = I2C_SERCOM->I2CM.STATUS.reg;
+
+  if (!Busy) /* Flag of a transaction aborted by I2C_Do */
+  {
+    I2C_SERCOM->I2CM.INTFLAG.reg = SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_SB | SERCOM_I2CM_INTFLAG_ERROR;
+  }
+  else if ((flags & SERCOM_I2CM_INTFLAG_ERROR) || (status & (SERCOM_I2CM_STATUS_ARBLOST | SERCOM_I2CM_STATUS_BUSERR)))
+  {
+    /* Arbitration lost or bus error, the master does not own the bus */
+    I2C_SERCOM->I2CM.INTFLAG.reg = SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_SB | SERCOM_I2CM_INTFLAG_ERROR;
+    I2C_Finish(I2C_BusError);
+    if (I2C_Begin())
+    {
+      I2C_Start();
+    }
+  }
+  else if (flags & SERCOM_I2CM_INTFLAG_MB) /* Address or data byte written */
+  {
+    if (status & SERCOM_I2CM_STATUS_RXNACK)
+    {
+      I2C_Stop(I2C_Nack);
+    }
+    else if (WriteIndex < transaction->writeLength)
+    {
+      I2C_SERCOM->I2CM.DATA.reg = transaction->writeData[WriteIndex]; /* Clears the flag */
+      WriteIndex++;
+    }
+    else if (transaction->readLength > 0)
+    {
+      I2C_SERCOM->I2CM.ADDR.reg = SERCOM_I2CM_ADDR_ADDR((transaction->address << 1) | 1); /* Repeated start for reading */
+    }
+    else
+    {
+      I2C_Stop(I2C_Done);
+    }
+  }
+  else if (flags & SERCOM_I2CM_INTFLAG_SB) /* Byte received, SCL is held until the acknowledge is commanded */
+  {
+    transaction->readData[ReadIndex] = I2C_SERCOM->I2CM.DATA.reg;
+    ReadIndex++;
+    if (ReadIndex < transaction->readLength)
+    {
+      I2C_SERCOM->I2CM.CTRLB.reg = I2C_COMMAND_READ;
+      while (I2C_SERCOM->I2CM.SYNCBUSY.bit.SYSOP) {}
+    }
+    else
+    {
+      I2C_Stop(I2C_Done); /* The last byte is not acknowledged */
+    }
+  }
+}
+#endif
+
+/* </Implementations> */
@@ -0,0 +1,151 @@
+/**
+ * I2C.h
+ * Interrupt-driven I2C transaction queue
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef I2C_H
+#define I2C_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+#include "ErrorMessaging.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define I2C_FREQUENCY                           100000UL /* Hz, SCL frequency */
+#ifdef UNO
+  #define I2C_QUEUE_SIZE                        4 /* Transactions waiting for the bus, must be a power of two; ADC conversion start, ADC result and DAC write at once */
+#elif defined(ZERO)
+  #define I2C_QUEUE_SIZE                        8 /* Transactions waiting for the bus, must be a power of two */
+#endif
+#define I2C_QUEUE_MASK                          (I2C_QUEUE_SIZE - 1)
+#define I2C_WRITE_MAXIMUM_LENGTH                3 /* Maximum number of bytes written by one transaction */
+#define I2C_READ_MAXIMUM_LENGTH                 2 /* Maximum number of bytes read by one transaction */
+#define I2C_TIMEOUT                             2000UL /* us, a transaction that does not finish in this time is aborted and the bus is recovered */
+#define I2C_RECOVERY_CLOCKS                     9 /* SCL pulses that release a slave holding SDA low */
+#define I2C_RECOVERY_HALF_PERIOD                5 /* us, half period of the recovery SCL pulses */
+
+#ifdef UNO
+  #define I2C_TWCR_CONTINUE                     (_BV(TWEN) | _BV(TWIE) | _BV(TWINT)) /* Clears the interrupt flag, the TWI continues with the next step */
+#elif defined(ZERO)
+  #define I2C_SERCOM                            SERCOM3 /* SDA on PA22 (pad 0), SCL on PA23 (pad 1), the pins of the Wire library */
+  #define I2C_SERCOM_IRQ                        SERCOM3_IRQn
+  #define I2C_SERCOM_CLOCK                      GCLK_CLKCTRL_ID_SERCOM3_CORE
+  #define I2C_SERCOM_APB                        PM_APBCMASK_SERCOM3
+  #define I2C_SDA_PORT_PIN                      22 /* PA22, even pin of the PMUX register */
+  #define I2C_SCL_PORT_PIN                      23 /* PA23, odd pin of the PMUX register */
+  #define I2C_BAUD                              ((F_CPU / (2 * I2C_FREQUENCY)) - 5) /* SCL low and high time for 48 MHz core clock, rise time neglected */
+  #define I2C_COMMAND_READ                      SERCOM_I2CM_CTRLB_CMD(2) /* Acknowledge the received byte and read the next one */
+  #define I2C_COMMAND_STOP                      (SERCOM_I2CM_CTRLB_ACKACT | SERCOM_I2CM_CTRLB_CMD(3)) /* Not acknowledge the last received byte and stop */
+#endif
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+/**
+ * Result of a transaction
+ */
+enum I2C_Status : uint8_t
+{
+  I2C_Queued, /* waiting for the bus */
+  I2C_Active, /* on the bus */
+  I2C_Done, /* finished successfully */
+  I2C_Nack, /* slave did not acknowledge */
+  I2C_BusError, /* arbitration lost or illegal bus condition */
+  I2C_Timeout, /* aborted after I2C_TIMEOUT, the bus was recovered */
+  I2C_Aborted /* dropped by I2C_Init before it finished */
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * One bus transaction: write, read, or write followed by a repeated start and read
+ */
+struct I2C_Transaction
+{
+  uint8_t address; /* 7-bit slave address */
+  uint8_t writeLength; /* Number of bytes to write */
+  uint8_t readLength; /* Number of bytes to read after the write */
+  uint8_t writeData[I2C_WRITE_MAXIMUM_LENGTH];
+  uint8_t readData[I2C_READ_MAXIMUM_LENGTH];
+  void (* done)(const struct I2C_Transaction * transaction); /* Completion callback or NULL */
+  volatile I2C_Status status;
+};
+
+/**
+ * Counters of the bus
+ */
+struct I2C_Statistics
+{
+  uint16_t transactions; /* Finished transactions, intentional wraparound */
+  uint16_t failures; /* Transactions that finished with NACK or bus error or could not be queued */
+  uint16_t timeouts; /* Transactions aborted after I2C_TIMEOUT */
+  uint16_t recoveries; /* Bus recoveries */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the bus, any queued or active transaction is dropped with I2C_Aborted
+ */
+void I2C_Init(void);
+
+/**
+ * Checks the timeout of the active transaction and signals failed transactions
+ */
+void I2C_Do(void);
+
+/**
+ * Queues a transaction, the bus starts with it as soon as the previous transactions are finished
+ * The callback is called from the interrupt, it must be short and must not queue transactions
+ * Every queued transaction calls its callback exactly once, also when it fails or is aborted
+ *
+ * @param address - 7-bit slave address
+ * @param writeData - bytes to write, copied to the queue
+ * @param writeLength - number of bytes to write, at most I2C_WRITE_MAXIMUM_LENGTH
+ * @param readLength - number of bytes to read, at most I2C_READ_MAXIMUM_LENGTH
+ * @param done - completion callback or NULL
+ *
+ * @return - True if queued, false if the queue stayed full for I2C_TIMEOUT
+ */
+bool I2C_Queue(uint8_t address, const uint8_t * writeData, uint8_t writeLength, uint8_t readLength, void (* done)(const I2C_Transaction * transaction));
+
+/**
+ * Waits until all queued transactions are finished or aborted
+ */
+void I2C_Flush(void);
+
+/**
+ * Gets the counters of the bus
+ *
+ * @return - Pointer to the counters
+ */
+const I2C_Statistics * I2C_GetStatistics(void);
+
+/**
+ * Returns error structure for this module
+ *
+ * @return - Pointer to constant error structure
+ */
+const ErrorMessaging_Error * I2C_GetError(void);
+
+/* </Declarations (prototypes)> */
+
+
+#endif /* I2C_H */
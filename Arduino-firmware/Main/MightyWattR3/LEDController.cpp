@@ -24,10 +24,10 @@
 
 /* <Module variables> */ 
 
-static const Communication_WriteCommand * writeCommand; /* Pointer to the write command where new data from communication can be found */
+static Communication_WriteCommandCursor commandCursor; /* Position of this module in the received write commands */
 static const Measurement_Values * measurementValues; /* Pointer to the latest measured voltage, current, power and resistance */
 static const TSCUChar * temperature; /* Pointer to structure where temperature can be found */
-static uint8_t commandCounter, measurementCounter, temperatureCounter; /* Number of the last executed command from communication, number of the last measurement data, number of the last temperature data */
+static uint8_t measurementCounter, temperatureCounter; /* Number of the last measurement data, number of the last temperature data */
 static uint8_t LEDBrightness; /* Indicates the brightness of the LED when on*/
 static uint8_t LEDLightRules; /* Describes under which circumstances the LED will light */
 void (* LEDController_Keep)(void); /* Pointer to the constant keeper function */
@@ -49,10 +49,9 @@ void LEDController_KeepRule(void);
 
 void LEDController_Init(void)
 {
-  writeCommand = Communication_GetWriteCommand();  
+  Communication_InitWriteCommandCursor(&commandCursor, COMMUNICATION_COMMAND_BIT(WriteCommand_LEDRules) | COMMUNICATION_COMMAND_BIT(WriteCommand_LEDBrightness));
   measurementValues = Measurement_GetValues();
   temperature = Thermometer_GetTemperature();
-  commandCounter = 0;
   measurementCounter = 0;
   temperatureCounter = 0;
   LEDBrightness = LED_CONTROLLER_DEFAULT_BRIGHTNESS;
@@ -62,24 +61,27 @@ void LEDController_Init(void)
 
 void LEDController_Do(void)
 {
-  /* Check new command */
-  if (writeCommand->commandCounter != commandCounter)
+  const Communication_Command * newCommand;
+
+  /* Check new commands */
+  while ((newCommand = Communication_GetNextWriteCommand(&commandCursor)) != NULL)
   {
     /* LSB first */
-    switch (writeCommand->command)
+    switch (newCommand->command)
     {
       case WriteCommand_LEDRules:
-        LEDLightRules = (writeCommand->data)[0];        
+        LEDLightRules = (newCommand->data)[0];        
         LEDController_Keep = &LEDController_KeepRule;
+        Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
       break;
       case WriteCommand_LEDBrightness:
-        LEDBrightness = (writeCommand->data)[0];
+        LEDBrightness = (newCommand->data)[0];
+        Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
       break;
       default:
       /* command handled by other modules */
       break;
     }
-    commandCounter = writeCommand->commandCounter;
   }  
   
   if (LEDController_Keep != NULL)
@@ -214,16 +216,16 @@ void LEDController_KeepRule(void)
     measurementCounter = measurementValues->counter;
   }
   
-  if (temperatureCounter != temperature->counter) /* Only process new values */
+  if (temperatureCounter != Data_GetCounter(temperature)) /* Only process new values */
   {
     /* Temperature rule */       
     if ((LEDLightRules & LEDRule_T50) > 0)
     {
-      if (temperature->value > LED_CONTROLLER_T50_UP)
+      if (Data_GetValue(temperature) > LED_CONTROLLER_T50_UP)
       {
         LEDWord |= LEDRule_T50; /* Set flag (temperature over threshold) */
       }
-      else if (temperature->value < LED_CONTROLLER_T50_DOWN)
+      else if (Data_GetValue(temperature) < LED_CONTROLLER_T50_DOWN)
       {
         LEDWord &= ~LEDRule_T50; /* Clear flag (temperature below hysteresis) */
       }            
@@ -232,7 +234,7 @@ void LEDController_KeepRule(void)
     {
       LEDWord &= ~LEDRule_T50;
     }
-    temperatureCounter = temperature->counter;
+    temperatureCounter = Data_GetCounter(temperature);
   }
   
   /* Apply rules */
@@ -246,4 +248,14 @@ void LEDController_KeepRule(void)
   }
 }
 
+uint8_t LEDController_GetRules(void)
+{
+  return LEDLightRules;
+}
+
+uint8_t LEDController_GetBrightness(void)
+{
+  return LEDBrightness;
+}
+
 /* </Implementations> */ 
@@ -83,6 +83,20 @@ void LEDController_Init(void);
  */
 void LEDController_Do(void);
 
+/**
+ * Gets the present LED rules
+ *
+ * @return - LEDController_Rules ORed together
+ */
+uint8_t LEDController_GetRules(void);
+
+/**
+ * Gets the brightness of the LED when on
+ *
+ * @return - Brightness
+ */
+uint8_t LEDController_GetBrightness(void);
+
 /* </Declarations (prototypes)> */ 
 
 #endif /* LEDCONTROLLER_H */
@@ -27,10 +27,10 @@
 
 /* <Module variables> */ 
 
-static const Communication_WriteCommand * writeCommand; /* Pointer to the write command where new data from communication can be found */
+static Communication_WriteCommandCursor commandCursor; /* Position of this module in the received write commands */
 static const Measurement_Values * measurementValues; /* Pointer to the latest measured voltage, current, power and resistance */
 static const TSCUChar * temperature; /* Pointer to structure where temperature can be found */
-static uint8_t commandCounter, temperatureCounter; /* Number of the last executed command from communication, number of the last temperature data */
+static uint8_t temperatureCounter; /* Number of the last temperature data */
 static uint8_t measurementErrorCounter, thermometerErrorCounter, ADCErrorCounter[ADC_CHANNEL_COUNT]; /* Error counters for measurement, thermometer and ADC modules */
 static uint16_t SeriesResistance; /* Series resistance for calculating allowed P in 4-wire mode, in mOhm (max 65.535 Ohm) */
 const static ErrorMessaging_Error * MeasurementError; /* Pointer to error structure from measurement */
@@ -59,7 +59,7 @@ void Limiter_Init(void)
 {
   uint8_t i;
   
-  writeCommand = Communication_GetWriteCommand();  
+  Communication_InitWriteCommandCursor(&commandCursor, COMMUNICATION_COMMAND_BIT(WriteCommand_SeriesResistance));
   measurementValues = Measurement_GetValues();
   temperature = Thermometer_GetTemperature();
   
@@ -87,20 +87,22 @@ void Limiter_Init(void)
 
 void Limiter_Do(void)
 {
-   /* Check new command */
-  if (writeCommand->commandCounter != commandCounter)
+  const Communication_Command * newCommand;
+
+   /* Check new commands */
+  while ((newCommand = Communication_GetNextWriteCommand(&commandCursor)) != NULL)
   {
     /* LSB first */
-    switch (writeCommand->command)
+    switch (newCommand->command)
     {
       case WriteCommand_SeriesResistance:
-        SeriesResistance = Data_GetUIntFromUCharArray(writeCommand->data);
+        SeriesResistance = Data_GetUIntFromUCharArray(newCommand->data);
+        Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
       break;
       default:
       /* command handled by other modules */
       break;
     }
-    commandCounter = writeCommand->commandCounter;
   }  
 
   Limiter_Keep();  
@@ -110,7 +112,14 @@ static void Limiter_Keep(void)
 {
   uint8_t i;
   bool fatalError = false;
-  static Measurement_Values lastValues; /* copy of last measurement values */
+  static struct
+  {
+    uint8_t counter;
+    uint32_t milliseconds;
+    uint32_t voltage;
+    uint32_t current;
+    uint32_t power;
+  } lastValues; /* copy of the last measurement values used by the integrators */
   static uint32_t voltageIntegral, currentIntegral, powerIntegral;
   uint32_t maximumPower; /* SOA-limited, mW */
   
@@ -150,18 +159,18 @@ static void Limiter_Keep(void)
   }
   
   /* Temperature check */
-  if (temperatureCounter != temperature->counter)
+  if (temperatureCounter != Data_GetCounter(temperature))
   {
-    if (temperature->value > LIMITER_MAXIMUM_TEMPERATURE)
+    if (Data_GetValue(temperature) > LIMITER_MAXIMUM_TEMPERATURE)
     {
       /* Overheat */
       fatalError = true;     
       LimiterError.error = ErrorMessaging_Limiter_Overheat;   
 //      Serial.print("Temperature: ");
-//      Serial.print(temperature->value);
+//      Serial.print(Data_GetValue(temperature));
 //      Serial.println(" °C");
     }    
-    temperatureCounter = temperature->counter;
+    temperatureCounter = Data_GetCounter(temperature);
   }  
   
   /* Voltage, current and power check */
@@ -232,7 +241,7 @@ static void Limiter_Keep(void)
   if (fatalError)
   {
     Control_StopLoad();
-    LimiterError.errorCounter++;
+    ErrorMessaging_Raise(&LimiterError, LimiterError.error);
   }
 }
 
@@ -241,4 +250,9 @@ const ErrorMessaging_Error * Limiter_GetError(void)
   return &LimiterError;
 }
 
+uint16_t Limiter_GetSeriesResistance(void)
+{
+  return SeriesResistance;
+}
+
 /* </Implementations> */ 
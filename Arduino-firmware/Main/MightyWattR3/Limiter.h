@@ -47,6 +47,13 @@ void Limiter_Do(void);
  */
 const ErrorMessaging_Error * Limiter_GetError(void);
 
+/**
+ * Gets the series resistance used in 4-wire mode
+ *
+ * @return - Series resistance in milliohms
+ */
+uint16_t Limiter_GetSeriesResistance(void);
+
 /* </Declarations (prototypes)> */ 
 
 #endif /* LIMITER_H */
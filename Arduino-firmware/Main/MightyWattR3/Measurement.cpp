@@ -14,20 +14,21 @@
 #include "Voltmeter.h"
 #include "Configuration.h"
 #include "Communication.h"
+#include "Events.h"
 
 /* </Includes> */ 
  
  
 /* <Module variables> */ 
 
-static const Communication_WriteCommand * writeCommand; /* Pointer to the write command where new data from communication can be found */
+static Communication_WriteCommandCursor commandCursor; /* Position of this module in the received write commands */
 static const TSCADCULong * voltage;
 static const TSCADCULong * current;
 static uint8_t voltageCounter, currentCounter, voltageErrorCounter, currentErrorCounter;
 static Measurement_Values measurementValues;
 static ErrorMessaging_Error MeasurementError;
-static uint8_t commandCounter;
 static bool invalidated; /* Indicates that the next measurement will be considered invalid */
+static uint8_t burstRange; /* Hardware range of the burst channel when the burst was started */
 
 #ifdef ADC_TYPE_ADS1015
 const ADC_RateRangingFilter MeasurementFast = {ADS1015_920SPS, false, false};
@@ -58,6 +59,8 @@ void Measurement_Init(void)
   currentCounter = 0;
   measurementValues.counter = 0;
   measurementValues.milliseconds = 0;
+  measurementValues.microseconds = 0;
+  measurementValues.sequence = 0;
   measurementValues.voltage = 0;
   measurementValues.current = 0;
   measurementValues.power = 0;
@@ -75,27 +78,79 @@ void Measurement_Init(void)
   MeasurementError.error = ErrorMessaging_Measurement_Invalid;
   MeasurementError.errorCounter = 0;
   
-  writeCommand = Communication_GetWriteCommand();
-  commandCounter = writeCommand->commandCounter;
+  Communication_InitWriteCommandCursor(&commandCursor, COMMUNICATION_COMMAND_BIT(WriteCommand_MeasurementSpeed) | COMMUNICATION_COMMAND_BIT(WriteCommand_Burst) |
+    COMMUNICATION_COMMAND_BIT(WriteCommand_ChannelWeights) | COMMUNICATION_COMMAND_BIT(WriteCommand_Filter));
 
   invalidated = false;
+  burstRange = 0;
 }
 
 void Measurement_Do(void)
 {  
-  /* Check new command */
-  if (writeCommand->commandCounter != commandCounter)
+  const Communication_Command * newCommand;
+
+  /* Check new commands */
+  while ((newCommand = Communication_GetNextWriteCommand(&commandCursor)) != NULL)
   {
     /* LSB first */
-    switch (writeCommand->command)
+    switch (newCommand->command)
     {
       case WriteCommand_MeasurementSpeed:
       {
-        uint8_t newSpeed = (writeCommand->data)[0];
+        uint8_t newSpeed = (newCommand->data)[0];
         if (newSpeed < MEASUREMENT_SPEEDS_COUNT)
         {
           Ammeter_SetSpeed((Measurement_Speeds)newSpeed);
           Voltmeter_SetSpeed((Measurement_Speeds)newSpeed);
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
+        }
+        else
+        {
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_InvalidValue);
+        }
+        break;
+      }
+      case WriteCommand_Burst:
+      {
+        ADC_Channels channel = (ADC_Channels)((newCommand->data)[0]);
+        uint16_t length = Data_GetUIntFromUCharArray(&((newCommand->data)[1]));
+        uint8_t range = (channel == ADC_V) ? (uint8_t)RangeSwitcher_GetVoltageRange() : (uint8_t)RangeSwitcher_GetCurrentRange();
+        if (length == 0)
+        {
+          length = ADC_BURST_LENGTH;
+        }
+        if (ADC_StartBurst(channel, length))
+        {
+          burstRange = range;
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
+        }
+        else
+        {
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_InvalidValue);
+        }
+        break;
+      }
+      case WriteCommand_ChannelWeights:
+      {
+        if (ADC_SetWeights(Weights_Host, (newCommand->data)[0], (newCommand->data)[1]))
+        {
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
+        }
+        else
+        {
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_InvalidValue);
+        }
+        break;
+      }
+      case WriteCommand_Filter:
+      {
+        if (ADC_SetFilter((ADC_Channels)((newCommand->data)[0]), (Filter_Types)((newCommand->data)[1]), (newCommand->data)[2]))
+        {
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
+        }
+        else
+        {
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_InvalidValue);
         }
         break;
       }
@@ -103,13 +158,16 @@ void Measurement_Do(void)
       /* command handled by other modules */
       break;
     }
-    commandCounter = writeCommand->commandCounter;
   }
 
-  if ((voltageCounter != voltage->counter) && (currentCounter != current->counter)) /* Calculate values when both voltage and current are updated */
+  Data_Filtered<uint32_t> newVoltage, newCurrent;
+  const ADC_ChannelWeights * weights = ADC_GetWeights();
+  bool newVoltageNeeded = (weights->voltage >= weights->current); /* The channel measured less often is taken as it is */
+  bool newCurrentNeeded = (weights->current >= weights->voltage);
+
+  if ((!newVoltageNeeded || (voltageCounter != Data_GetCounter(voltage))) && (!newCurrentNeeded || (currentCounter != Data_GetCounter(current))) &&
+      Data_Read(voltage, &newVoltage, &voltageCounter) && Data_Read(current, &newCurrent, &currentCounter)) /* Calculate values when the channels with the highest weight are updated */
   {       
-    voltageCounter = voltage->counter;
-    currentCounter = current->counter;
     
     if (invalidated)
     {
@@ -118,11 +176,11 @@ void Measurement_Do(void)
     else
     {    
       uint64_t resistance, unfilteredResistance = 0;
-      measurementValues.voltage = voltage->value;
-      measurementValues.current = current->value;
+      measurementValues.voltage = newVoltage.value;
+      measurementValues.current = newCurrent.value;
       measurementValues.power = (uint32_t)((((uint64_t)measurementValues.voltage) * ((uint64_t)measurementValues.current)) / 1000000ULL);
-      measurementValues.unfilteredVoltage = voltage->unfilteredValue;
-      measurementValues.unfilteredCurrent = current->unfilteredValue;
+      measurementValues.unfilteredVoltage = newVoltage.unfilteredValue;
+      measurementValues.unfilteredCurrent = newCurrent.unfilteredValue;
       measurementValues.unfilteredPower = (uint32_t)((((uint64_t)measurementValues.unfilteredVoltage) * ((uint64_t)measurementValues.unfilteredCurrent)) / 1000000ULL);
       if (measurementValues.current == 0) /* Zero current implies maximum input resistance, which is determined by voltmeter input resistance */
       {
@@ -160,13 +218,15 @@ void Measurement_Do(void)
       }
       measurementValues.unfilteredResistance = (uint32_t)unfilteredResistance;             
       measurementValues.counter++;
+      measurementValues.sequence++;
       measurementValues.milliseconds = millis();
+      measurementValues.microseconds = micros();
+      Events_Publish(Event_Measurement);
         
       if ((currentErrorCounter != AmmeterError->errorCounter) || (voltageErrorCounter != VoltmeterError->errorCounter))
       {
         /* Measurement invalid */
-        MeasurementError.error = ErrorMessaging_Measurement_Invalid;
-        MeasurementError.errorCounter++;
+        ErrorMessaging_Raise(&MeasurementError, ErrorMessaging_Measurement_Invalid);
         currentErrorCounter = AmmeterError->errorCounter;
         voltageErrorCounter = VoltmeterError->errorCounter;
       }
@@ -184,6 +244,31 @@ void Measurement_Invalidate(void)
   invalidated = true;
 }
 
+int32_t Measurement_GetBurstSample(uint16_t index)
+{
+  const ADC_Burst * burst = ADC_GetBurst();
+  int32_t adcVoltage;
+
+  if (ADC_IsBurstSampleMissed(index))
+  {
+    return MEASUREMENT_BURST_MISSED_SAMPLE;
+  }
+  adcVoltage = ADS1x15_Voltage(burst->samples[index], ADC_BURST_RANGE);
+  if (burst->channel == ADC_V)
+  {
+    return Voltmeter_GetVoltageFromADC(adcVoltage, (RangeSwitcher_VoltageRanges)burstRange);
+  }
+  else
+  {
+    return Ammeter_GetCurrentFromADC(adcVoltage, (RangeSwitcher_CurrentRanges)burstRange);
+  }
+}
+
+uint8_t Measurement_GetBurstRange(void)
+{
+  return burstRange;
+}
+
 const ErrorMessaging_Error * Measurement_GetError(void)
 {
   return &MeasurementError;
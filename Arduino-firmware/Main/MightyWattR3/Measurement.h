@@ -23,6 +23,7 @@
 /* <Defines> */ 
 
 #define MEASUREMENT_SPEEDS_COUNT        3
+#define MEASUREMENT_BURST_MISSED_SAMPLE ((int32_t)0x80000000) /* Burst sample that was not read */
 
 /* </Defines> */ 
 
@@ -56,7 +57,9 @@ enum Measurement_Speeds : uint8_t
 struct Measurement_Values
 {
   uint32_t milliseconds;
+  uint32_t microseconds; /* micros() when the values were calculated */
   uint8_t counter;
+  uint16_t sequence; /* Number of the measurement, intentional wraparound */
   uint32_t voltage;
   uint32_t current;
   uint32_t power;
@@ -103,6 +106,23 @@ const Measurement_Values * Measurement_GetValues(void);
  */
 void Measurement_Invalidate(void);
 
+/**
+ * Returns a sample of the last burst capture (ADC_GetBurst) as voltage or current
+ * The sample is calculated in the hardware range that was set when the burst was started
+ *
+ * @param index - index of the sample, lower than the burst count
+ *
+ * @return - Voltage in uV or current in uA by the burst channel, MEASUREMENT_BURST_MISSED_SAMPLE if the sample was missed
+ */
+int32_t Measurement_GetBurstSample(uint16_t index);
+
+/**
+ * Returns the hardware range of the last burst capture
+ *
+ * @return - RangeSwitcher_VoltageRanges or RangeSwitcher_CurrentRanges by the burst channel
+ */
+uint8_t Measurement_GetBurstRange(void);
+
 /**
  * Returns error structure for this module
  *
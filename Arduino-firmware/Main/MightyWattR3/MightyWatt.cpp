@@ -29,20 +29,55 @@
 #include "ErrorMessaging.h"
 #include "CommunicationWatchdog.h"
 #include "RangeSwitcher.h"
+#include "Scheduler.h"
+#include "Profiler.h"
+#include "Events.h"
+#include "I2C.h"
+#include "ControlTick.h"
 
 /* </Includes> */ 
 
 
+/* <Module variables> */ 
+
+/**
+ * Tasks in the order of priority
+ * The measurement and control chain runs first so that a new ADC sample is processed within the same pass
+ */
+static const Scheduler_Task Tasks[] FLASHMEMORY =
+{
+  {&ADC_Do, Trigger_Always, 0, 0},
+  {&I2C_Do, Trigger_Always, 0, 0},
+  {&Voltmeter_Do, Trigger_Events, Event_ADCVoltage | Event_Command, 0},
+  {&Ammeter_Do, Trigger_Events, Event_ADCCurrent, 0},
+  {&Thermometer_Do, Trigger_Events, Event_ADCTemperature, 0},
+  {&Measurement_Do, Trigger_Events, Event_Voltage | Event_Current | Event_Command, 0},
+  {&Control_Do, Trigger_Events, Event_ADCVoltage | Event_ADCCurrent | Event_Command, 0},
+  {&Limiter_Do, Trigger_Events, Event_Measurement | Event_Temperature | Event_Error | Event_Command, 0},
+  {&Communication_Do, Trigger_Always, 0, 0},
+  {&RangeSwitcher_Do, Trigger_Events, Event_Command, 0},
+  {&LEDController_Do, Trigger_Events, Event_Measurement | Event_Temperature | Event_Command, 0},
+  {&PinController_Do, Trigger_Events, Event_Command, 0},
+  {&FanController_Do, Trigger_Period, Event_Temperature | Event_Command, 1000}, /* power is checked once per period, not on every measurement */
+  {&CommunicationWatchdog_Do, Trigger_Period, Event_Command | Event_ReadCommand, 100}
+};
+
+/* </Module variables> */ 
+
+
 /* <Implementations> */ 
 
 void MightyWatt_Init(void)
 {
+  Events_Init();
   Communication_Init();
+  I2C_Init();
   ADC_Init();
   DACC_Init();
   LED_Init();
   Pin_Init();
   Fan_Init();
+  ControlTick_Init();
   RangeSwitcher_Init();
   Voltmeter_Init();  
   Ammeter_Init();
@@ -57,23 +92,17 @@ void MightyWatt_Init(void)
   Limiter_Init();
   ErrorMessaging_Init();
   CommunicationWatchdog_Init();
+  Scheduler_Init(Tasks, sizeof(Tasks) / sizeof(Tasks[0]));
+  Scheduler_SetUrgentTask(0, &ADC_IsSampleReady); /* ADC_Do (task 0) also runs between the other tasks when a conversion is finished */
+  Scheduler_SetUrgentTask(6, &Control_IsDue); /* Control_Do (task 6) makes the software control loop step right after the control tick and acknowledges commands right after their DAC writes */
+#ifdef PROFILER
+  Profiler_Init();
+#endif
 }
 
 void MightyWatt_Do(void)
 {
-  Communication_Do();
-  ADC_Do();
-  Voltmeter_Do();
-  Ammeter_Do();  
-  Thermometer_Do();
-  Measurement_Do();
-  RangeSwitcher_Do();
-  Control_Do();
-  LEDController_Do();
-  PinController_Do();
-  FanController_Do();
-  Limiter_Do();  
-  CommunicationWatchdog_Do();
+  Scheduler_Do();
 }
   
 /* </Implementations> */
@@ -25,8 +25,7 @@
 
 /* <Module variables> */ 
 
-static const Communication_WriteCommand * writeCommand; /* Pointer to the write command where new data from communication can be found */
-static uint8_t commandCounter; /* Number of the last executed command from communication */
+static Communication_WriteCommandCursor commandCursor; /* Position of this module in the received write commands */
 
 /* </Module variables> */ 
 
@@ -35,35 +34,36 @@ static uint8_t commandCounter; /* Number of the last executed command from commu
 
 void PinController_Init(void)
 {
-  writeCommand = Communication_GetWriteCommand();  
-  commandCounter = 0;
+  Communication_InitWriteCommandCursor(&commandCursor, COMMUNICATION_COMMAND_BIT(WriteCommand_Pins));
 }
 
 void PinController_Do(void)
 {
-  /* Check new command */
-  if (writeCommand->commandCounter != commandCounter)
+  const Communication_Command * newCommand;
+
+  /* Check new commands */
+  while ((newCommand = Communication_GetNextWriteCommand(&commandCursor)) != NULL)
   {
     /* LSB first */
-    switch (writeCommand->command)
+    switch (newCommand->command)
     {
       case WriteCommand_Pins:
-        if (PINCONTROLLER_ISSET((writeCommand->data)[0]))
+        if (PINCONTROLLER_ISSET((newCommand->data)[0]))
         {
           // set pins
-          Pin_Set(PinController_GetPins() | (writeCommand->data)[0] & 0x7F);
+          Pin_Set(PinController_GetPins() | (newCommand->data)[0] & 0x7F);
         }
         else
         {
           // reset pins
-          Pin_Set(PinController_GetPins() & ~((writeCommand->data)[0]) & 0x7F);
+          Pin_Set(PinController_GetPins() & ~((newCommand->data)[0]) & 0x7F);
         }
+        Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
       break;
       default:
       /* command handled by other modules */
       break;
     }
-    commandCounter = writeCommand->commandCounter;
   }  
 }
 
@@ -0,0 +1,183 @@
+/**
+ * Profiler.cpp
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+/* <Includes> */
+
+#include "Arduino.h"
+#include "Profiler.h"
+
+/* </Includes> */
+
+
+#ifdef PROFILER
+
+/* <Module variables> */
+
+static Profiler_Probe Probes[PROFILER_PROBES_COUNT];
+static Profiler_Channel Channels[ADC_CHANNEL_COUNT];
+static uint32_t WindowStart; /* millis() of the last reset */
+static uint16_t FilterCycles[FILTER_TYPES_COUNT]; /* CPU cycles per sample of each Filter_Types */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Adds a batch of PROFILER_FILTER_SAMPLES samples to every filter type and stores the cycles per sample,
+ * a single sample is shorter than the resolution of micros()
+ */
+void Profiler_MeasureFilters(void);
+
+/**
+ * Gets a sample for the filter benchmark, the samples are spread over the ADC range so that the median moves them
+ *
+ * @param index - index of the sample
+ *
+ * @return - Sample
+ */
+int32_t Profiler_GetFilterSample(uint16_t index);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void Profiler_Init(void)
+{
+  Profiler_MeasureFilters();
+  Profiler_Reset();
+}
+
+void Profiler_Reset(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < PROFILER_PROBES_COUNT; i++)
+  {
+    Probes[i].calls = 0;
+    Probes[i].totalTime = 0;
+    Probes[i].minimum = 0xFFFF;
+    Probes[i].maximum = 0;
+  }
+  for (i = 0; i < ADC_CHANNEL_COUNT; i++)
+  {
+    Channels[i].samples = 0;
+    Channels[i].missedSamples = 0;
+  }
+  WindowStart = millis();
+}
+
+void Profiler_Add(uint8_t probe, uint32_t time)
+{
+  uint16_t saturatedTime = (time > 0xFFFF) ? 0xFFFF : time;
+
+  if (probe >= PROFILER_PROBES_COUNT)
+  {
+    return;
+  }
+  Probes[probe].calls++;
+  Probes[probe].totalTime += time;
+  if (saturatedTime < Probes[probe].minimum)
+  {
+    Probes[probe].minimum = saturatedTime;
+  }
+  if (saturatedTime > Probes[probe].maximum)
+  {
+    Probes[probe].maximum = saturatedTime;
+  }
+}
+
+void Profiler_AddSample(uint8_t channel)
+{
+  Channels[channel].samples++;
+}
+
+void Profiler_AddMissedSample(uint8_t channel)
+{
+  Channels[channel].missedSamples++;
+}
+
+const Profiler_Probe * Profiler_GetProbe(uint8_t probe)
+{
+  return &(Probes[probe]);
+}
+
+uint16_t Profiler_GetMean(uint8_t probe)
+{
+  uint32_t mean;
+
+  if (Probes[probe].calls == 0)
+  {
+    return 0;
+  }
+  mean = Probes[probe].totalTime / Probes[probe].calls;
+  return (mean > 0xFFFF) ? 0xFFFF : mean;
+}
+
+const Profiler_Channel * Profiler_GetChannel(uint8_t channel)
+{
+  return &(Channels[channel]);
+}
+
+uint16_t Profiler_GetFilterCycles(uint8_t type)
+{
+  return FilterCycles[type];
+}
+
+uint32_t Profiler_GetWindow(void)
+{
+  return millis() - WindowStart;
+}
+
+void Profiler_MeasureFilters(void)
+{
+  int32_t history[2 * PROFILER_FILTER_LENGTH]; /* The median keeps the sorted samples in the second half */
+  Filter_Data filter = {history, 2 * PROFILER_FILTER_LENGTH};
+  volatile int32_t value; /* Keeps the compiler from dropping the filter output */
+  uint8_t type;
+  uint16_t i;
+  uint32_t start, overhead, time;
+
+  /* Time of the loop and of the samples alone */
+  start = micros();
+  for (i = 0; i < PROFILER_FILTER_SAMPLES; i++)
+  {
+    value = Profiler_GetFilterSample(i);
+  }
+  overhead = micros() - start;
+
+  for (type = 0; type < FILTER_TYPES_COUNT; type++)
+  {
+    Filter_Setup(&filter, (Filter_Types)type, (type == Filter_IIR) ? FILTER_IIR_SHIFT_MAXIMUM : PROFILER_FILTER_LENGTH);
+    for (i = 0; i < PROFILER_FILTER_LENGTH; i++)
+    {
+      Filter_Add(&filter, Profiler_GetFilterSample(i)); /* Full history like a running channel */
+    }
+    start = micros();
+    for (i = 0; i < PROFILER_FILTER_SAMPLES; i++)
+    {
+      Filter_Add(&filter, Profiler_GetFilterSample(i));
+      value = Filter_GetValue(&filter);
+    }
+    time = micros() - start;
+    time = (time > overhead) ? (time - overhead) : 0;
+    time = (time * (F_CPU / 1000000UL)) / PROFILER_FILTER_SAMPLES;
+    FilterCycles[type] = (time > 0xFFFF) ? 0xFFFF : time;
+  }
+  (void)value;
+}
+
+int32_t Profiler_GetFilterSample(uint16_t index)
+{
+  return (int32_t)((uint16_t)(index * 40503U) >> 1) - 16384;
+}
+
+/* </Implementations> */
+
+#endif /* PROFILER */
@@ -0,0 +1,174 @@
+/**
+ * Profiler.h
+ * Execution time profiler, enabled by PROFILER in Configuration.h
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+#include "Scheduler.h"
+#include "ADC.h"
+#include "Filter.h"
+
+/* </Includes> */
+
+
+/* <Enums> */
+
+/**
+ * Measured code sections
+ */
+enum Profiler_Probes : uint8_t
+{
+  Probe_Loop = 0, /* one pass of the main loop */
+  Probe_ADS1x15Send = 1, /* I2C write to ADC */
+  Probe_ADS1x15Read = 2, /* I2C read from ADC */
+  Probe_AD569xRSend = 3, /* I2C write to DAC */
+  Probe_ADCLatency = 4, /* time from the end of an ADC conversion until ADC_Do reads it */
+  Probe_Tasks = 5 /* first scheduler task, task i is measured by probe Probe_Tasks + i */
+};
+
+/* </Enums> */
+
+
+/* <Defines> */
+
+#define PROFILER_FIXED_PROBES_COUNT             Probe_Tasks
+#define PROFILER_PROBES_COUNT                   (PROFILER_FIXED_PROBES_COUNT + SCHEDULER_TASKS_MAXIMUM)
+#define PROFILER_FILTER_SAMPLES                 256 /* Samples of the filter benchmark, one micros() step of 4 us is 1/4 cycle per sample on UNO */
+#define PROFILER_FILTER_LENGTH                  FILTER_MEDIAN_LENGTH_MAXIMUM /* Filter length of the benchmark, IIR uses FILTER_IIR_SHIFT_MAXIMUM */
+
+#ifdef PROFILER
+  #define PROFILER_BEGIN()                      uint32_t profilerStart = micros()
+  #define PROFILER_END(probe)                   Profiler_Add((probe), micros() - profilerStart)
+  #define PROFILER_ADD(probe, time)             Profiler_Add((probe), (time))
+  #define PROFILER_SAMPLE(channel)              Profiler_AddSample(channel)
+  #define PROFILER_MISSED_SAMPLE(channel)       Profiler_AddMissedSample(channel)
+#else
+  #define PROFILER_BEGIN()
+  #define PROFILER_END(probe)
+  #define PROFILER_ADD(probe, time)
+  #define PROFILER_SAMPLE(channel)
+  #define PROFILER_MISSED_SAMPLE(channel)
+#endif
+
+/* </Defines> */
+
+
+/* <Structs> */
+
+/**
+ * Execution time of a code section since the last reset
+ */
+struct Profiler_Probe
+{
+  uint32_t calls; /* Number of executions */
+  uint32_t totalTime; /* us, sum of all executions */
+  uint16_t minimum; /* us, saturated */
+  uint16_t maximum; /* us, saturated */
+};
+
+/**
+ * Samples of an ADC channel since the last reset
+ */
+struct Profiler_Channel
+{
+  uint32_t samples; /* Number of converted samples */
+  uint16_t missedSamples; /* Number of conversions that did not finish within ADC_TIMEOUT */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+#ifdef PROFILER
+
+/**
+ * Initializes the module and measures the filters, takes a few ms
+ */
+void Profiler_Init(void);
+
+/**
+ * Clears all probes and channels and starts a new measurement window
+ */
+void Profiler_Reset(void);
+
+/**
+ * Adds one execution of a code section
+ *
+ * @param probe - Profiler_Probes
+ * @param time - execution time in us
+ */
+void Profiler_Add(uint8_t probe, uint32_t time);
+
+/**
+ * Adds one converted sample of an ADC channel
+ *
+ * @param channel - ADC channel
+ */
+void Profiler_AddSample(uint8_t channel);
+
+/**
+ * Adds one missed sample of an ADC channel
+ *
+ * @param channel - ADC channel
+ */
+void Profiler_AddMissedSample(uint8_t channel);
+
+/**
+ * Gets the execution times of a code section
+ *
+ * @param probe - Profiler_Probes
+ *
+ * @return - Pointer to the probe
+ */
+const Profiler_Probe * Profiler_GetProbe(uint8_t probe);
+
+/**
+ * Gets the mean execution time of a code section
+ *
+ * @param probe - Profiler_Probes
+ *
+ * @return - Mean execution time in us, saturated, 0 if the section was not executed
+ */
+uint16_t Profiler_GetMean(uint8_t probe);
+
+/**
+ * Gets the samples of an ADC channel
+ *
+ * @param channel - ADC channel
+ *
+ * @return - Pointer to the channel
+ */
+const Profiler_Channel * Profiler_GetChannel(uint8_t channel);
+
+/**
+ * Gets the time of adding a sample to a filter and getting its value, measured by Profiler_Init
+ *
+ * @param type - Filter_Types
+ *
+ * @return - CPU cycles per sample, saturated
+ */
+uint16_t Profiler_GetFilterCycles(uint8_t type);
+
+/**
+ * Gets the length of the measurement window
+ *
+ * @return - Time since the last reset in ms
+ */
+uint32_t Profiler_GetWindow(void);
+
+#endif /* PROFILER */
+
+/* </Declarations (prototypes)> */
+
+
+#endif /* PROFILER_H */
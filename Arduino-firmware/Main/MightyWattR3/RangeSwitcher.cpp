@@ -13,6 +13,7 @@
 #include "Arduino.h"
 #include "RangeSwitcher.h"
 #include "Communication.h"
+#include "FastPin.h"
 //#include "Measurement.h"
 //#include "CurrentSetter.h"
 //#include "VoltageSetter.h"
@@ -25,8 +26,7 @@
 static RangeSwitcher_CurrentRanges currentRange = CURRENT_DEFAULT_HARDWARE_RANGE;
 static RangeSwitcher_VoltageRanges voltageRange = VOLTAGE_DEFAULT_HARDWARE_RANGE;
 static bool currentRangeAuto, voltageRangeAuto; /* Defines whether the load can use autoranging by voltage setter and current setter. If true, it can, if false, the range will be fixed on high range */
-static const Communication_WriteCommand * writeCommand; /* Pointer to the write command where new data from communication can be found */
-static uint8_t commandCounter; /* Number of the last executed command from communication */
+static Communication_WriteCommandCursor commandCursor; /* Position of this module in the received write commands */
 static bool currentRangeChanged, voltageRangeChanged; /* True if range was changed since last time */
 
 /* </Module variables> */ 
@@ -42,31 +42,33 @@ void RangeSwitcher_Init(void)
   RangeSwitcher_SetVoltageRange(VOLTAGE_DEFAULT_HARDWARE_RANGE);
   currentRangeAuto = true;
   voltageRangeAuto = true;
-  writeCommand = Communication_GetWriteCommand();
-  commandCounter = 0;
+  Communication_InitWriteCommandCursor(&commandCursor, COMMUNICATION_COMMAND_BIT(WriteCommand_CurrentRangeAuto) | COMMUNICATION_COMMAND_BIT(WriteCommand_VoltageRangeAuto));
   currentRangeChanged = false;
   voltageRangeChanged = false;
 }
 
 void RangeSwitcher_Do(void)
 {
-  /* Check new command */
-  if (writeCommand->commandCounter != commandCounter)
+  const Communication_Command * newCommand;
+
+  /* Check new commands */
+  while ((newCommand = Communication_GetNextWriteCommand(&commandCursor)) != NULL)
   {
     /* LSB first */
-    switch (writeCommand->command)
+    switch (newCommand->command)
     {
       case WriteCommand_CurrentRangeAuto:
-        currentRangeAuto = ((writeCommand->data)[0]) > 0;
+        currentRangeAuto = ((newCommand->data)[0]) > 0;
+        Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
       break;
       case WriteCommand_VoltageRangeAuto:
-        voltageRangeAuto = ((writeCommand->data)[0]) > 0;
+        voltageRangeAuto = ((newCommand->data)[0]) > 0;
+        Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
       break;
       default:
       /* command handled by other modules */
       break;
     }
-    commandCounter = writeCommand->commandCounter;
   }  
 }
 
@@ -78,10 +80,10 @@ void RangeSwitcher_SetCurrentRange(RangeSwitcher_CurrentRanges range)
   switch (currentRange)
   {
     case CurrentRange_LowCurrent:
-      digitalWrite(CURRENT_GAIN_PIN, HIGH);
+      FastPin_High<CURRENT_GAIN_PIN>();
     break;
     case CurrentRange_HighCurrent:
-      digitalWrite(CURRENT_GAIN_PIN, LOW);
+      FastPin_Low<CURRENT_GAIN_PIN>();
     break;
     default:
     break;
@@ -96,10 +98,10 @@ void RangeSwitcher_SetVoltageRange(RangeSwitcher_VoltageRanges range)
   switch (voltageRange)
   {
     case VoltageRange_LowVoltage:
-      digitalWrite(VOLTAGE_GAIN_PIN, HIGH);
+      FastPin_High<VOLTAGE_GAIN_PIN>();
     break;
     case VoltageRange_HighVoltage:
-      digitalWrite(VOLTAGE_GAIN_PIN, LOW);
+      FastPin_Low<VOLTAGE_GAIN_PIN>();
     break;
     default:
     break;
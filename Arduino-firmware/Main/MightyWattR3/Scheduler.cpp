@@ -0,0 +1,185 @@
+/**
+ * Scheduler.cpp
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+/* <Includes> */
+
+#include "Arduino.h"
+#include "Scheduler.h"
+#include "Flashreader.h"
+#include "Profiler.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static const Scheduler_Task * Tasks; /* Task table in flash memory in the order of priority */
+static uint8_t TaskCount;
+static Scheduler_TaskStatistics Statistics[SCHEDULER_TASKS_MAXIMUM];
+static uint32_t LastRun[SCHEDULER_TASKS_MAXIMUM]; /* micros() of the last run of each task */
+static uint8_t FirstSubscription; /* Handle of the events subscription of the first task, the other tasks follow */
+static uint8_t UrgentTasks[SCHEDULER_URGENT_TASKS_MAXIMUM];
+static bool (* UrgentTaskIsDue[SCHEDULER_URGENT_TASKS_MAXIMUM])(void); /* Conditions of the urgent tasks */
+static uint8_t UrgentTaskCount;
+static bool FirstPass; /* Every task runs in the first pass */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Runs a task and updates its run counters
+ *
+ * @param task - index of the task in the task table
+ * @param now - micros() when the task was found due
+ * @param lateness - us, time between the task becoming due and now
+ */
+void Scheduler_Run(uint8_t task, uint32_t now, uint32_t lateness);
+
+/**
+ * Gets the period of a task from the task table
+ *
+ * @param task - index of the task in the task table
+ *
+ * @return - Period of the task in us
+ */
+uint32_t Scheduler_GetPeriod(uint8_t task);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void Scheduler_Init(const Scheduler_Task * tasks, uint8_t taskCount)
+{
+  uint8_t i, subscription;
+  uint16_t events;
+
+  Tasks = tasks;
+  UrgentTaskCount = 0;
+  TaskCount = (taskCount > SCHEDULER_TASKS_MAXIMUM) ? SCHEDULER_TASKS_MAXIMUM : taskCount;
+  for (i = 0; i < TaskCount; i++)
+  {
+    LastRun[i] = micros();
+    Flashreader_Read((uint8_t *)&events, (const uint8_t *)&(tasks[i].events), sizeof(events));
+    subscription = Events_Subscribe(events);
+    if (i == 0)
+    {
+      FirstSubscription = subscription;
+    }
+  }
+  FirstPass = true;
+  Scheduler_ResetStatistics();
+}
+
+void Scheduler_Do(void)
+{
+  uint8_t i, j, triggers;
+  uint32_t passStart = micros();
+  uint32_t now, lateness, published;
+  PROFILER_BEGIN();
+
+  for (i = 0; i < TaskCount; i++)
+  {
+    triggers = Flashreader_ReadByte(&(Tasks[i].triggers));
+    now = micros();
+
+    if ((FirstSubscription != EVENTS_NO_SUBSCRIPTION) && (Events_Take(FirstSubscription + i, &published) != 0))
+    {
+      lateness = now - published; /* The task waited since its oldest event was published */
+    }
+    else if ((triggers & Trigger_Always) || FirstPass)
+    {
+      lateness = now - passStart; /* The task waits for the higher priority tasks in this pass */
+    }
+    else if ((triggers & Trigger_Period) && ((now - LastRun[i]) >= Scheduler_GetPeriod(i)))
+    {
+      lateness = (now - LastRun[i]) - Scheduler_GetPeriod(i);
+    }
+    else
+    {
+      continue; /* Task is not due */
+    }
+
+    Scheduler_Run(i, now, lateness);
+
+    for (j = 0; j < UrgentTaskCount; j++)
+    {
+      if ((i != UrgentTasks[j]) && UrgentTaskIsDue[j]())
+      {
+        Scheduler_Run(UrgentTasks[j], micros(), 0); /* Runs right after the condition is noticed */
+      }
+    }
+  }
+  FirstPass = false;
+  PROFILER_END(Probe_Loop);
+}
+
+void Scheduler_SetUrgentTask(uint8_t task, bool (* isDue)(void))
+{
+  if ((task < TaskCount) && (UrgentTaskCount < SCHEDULER_URGENT_TASKS_MAXIMUM))
+  {
+    UrgentTasks[UrgentTaskCount] = task;
+    UrgentTaskIsDue[UrgentTaskCount] = isDue;
+    UrgentTaskCount++;
+  }
+}
+
+uint8_t Scheduler_GetTaskCount(void)
+{
+  return TaskCount;
+}
+
+const Scheduler_TaskStatistics * Scheduler_GetStatistics(uint8_t task)
+{
+  return &(Statistics[task]);
+}
+
+void Scheduler_ResetStatistics(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < TaskCount; i++)
+  {
+    Statistics[i].runs = 0;
+    Statistics[i].lateRuns = 0;
+    Statistics[i].maximumLateness = 0;
+  }
+}
+
+void Scheduler_Run(uint8_t task, uint32_t now, uint32_t lateness)
+{
+  void (* run)(void);
+
+  LastRun[task] = now;
+  Statistics[task].runs++;
+  if (lateness > SCHEDULER_LATE_THRESHOLD)
+  {
+    Statistics[task].lateRuns++;
+  }
+  if (lateness > Statistics[task].maximumLateness)
+  {
+    Statistics[task].maximumLateness = (lateness > 0xFFFF) ? 0xFFFF : lateness;
+  }
+
+  Flashreader_Read((uint8_t *)&run, (const uint8_t *)&(Tasks[task].run), sizeof(run));
+  PROFILER_BEGIN();
+  run();
+  PROFILER_END(Probe_Tasks + task);
+}
+
+uint32_t Scheduler_GetPeriod(uint8_t task)
+{
+  uint16_t period;
+
+  Flashreader_Read((uint8_t *)&period, (const uint8_t *)&(Tasks[task].period), sizeof(period));
+  return period * 1000UL;
+}
+
+/* </Implementations> */
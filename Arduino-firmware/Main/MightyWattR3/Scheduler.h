@@ -0,0 +1,120 @@
+/**
+ * Scheduler.h
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+#include "Events.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define SCHEDULER_TASKS_MAXIMUM                 14 /* Maximum number of tasks in the task table */
+#define SCHEDULER_URGENT_TASKS_MAXIMUM          2 /* Maximum number of urgent tasks */
+#define SCHEDULER_LATE_THRESHOLD                1000UL /* us, a task that starts later than this after it became due is counted as late */
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+/**
+ * Conditions that make a task due besides its events, a task is due if any of its conditions is fulfilled
+ */
+enum Scheduler_Triggers : uint8_t
+{
+  Trigger_Events = 0, /* only the subscribed events */
+  Trigger_Always = 1 << 0, /* every loop pass */
+  Trigger_Period = 1 << 1 /* period elapsed since the last run */
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * Task of the scheduler
+ */
+struct Scheduler_Task
+{
+  void (* run)(void); /* Executable "Do" function of a module */
+  uint8_t triggers; /* Scheduler_Triggers ORed together */
+  uint16_t events; /* Events_Types ORed together, the task runs after any of them was published */
+  uint16_t period; /* ms, used with Trigger_Period */
+};
+
+/**
+ * Run counters of a task
+ */
+struct Scheduler_TaskStatistics
+{
+  uint32_t runs; /* Number of runs */
+  uint16_t lateRuns; /* Number of runs that started more than SCHEDULER_LATE_THRESHOLD after the task became due */
+  uint16_t maximumLateness; /* us, longest time between the task becoming due and its start, saturated */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the module and subscribes the tasks to their events, Events_Init must be called before
+ *
+ * @param tasks - table of tasks in flash memory (FLASHMEMORY) in the order of priority, the first task runs first in every loop pass
+ * @param taskCount - number of tasks in the table, at most SCHEDULER_TASKS_MAXIMUM
+ */
+void Scheduler_Init(const Scheduler_Task * tasks, uint8_t taskCount);
+
+/**
+ * Runs one loop pass: every task that is due, in the order of priority
+ * A task that is due because of an event published by a higher priority task (e.g. new ADC sample) runs within the same pass
+ */
+void Scheduler_Do(void);
+
+/**
+ * Adds a task that is also run between any two other tasks when its condition is fulfilled
+ * Used for data that is flagged by an interrupt and must not wait for the next loop pass (e.g. finished ADC conversion)
+ * Urgent tasks are checked in the order they were added, at most SCHEDULER_URGENT_TASKS_MAXIMUM
+ *
+ * @param task - index of the task in the task table
+ * @param isDue - condition of the task, it is checked after every task and must be fast
+ */
+void Scheduler_SetUrgentTask(uint8_t task, bool (* isDue)(void));
+
+/**
+ * Gets the number of tasks
+ *
+ * @return - Number of tasks in the task table
+ */
+uint8_t Scheduler_GetTaskCount(void);
+
+/**
+ * Gets the run counters of a task
+ *
+ * @param task - index of the task in the task table
+ *
+ * @return - Pointer to the run counters
+ */
+const Scheduler_TaskStatistics * Scheduler_GetStatistics(uint8_t task);
+
+/**
+ * Clears the run counters of all tasks
+ */
+void Scheduler_ResetStatistics(void);
+
+/* </Declarations (prototypes)> */
+
+
+#endif /* SCHEDULER_H */
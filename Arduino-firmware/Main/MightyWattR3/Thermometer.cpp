@@ -14,6 +14,7 @@
 #include "ADC.h"
 #include "DACC.h"
 #include "Measurement.h"
+#include "Events.h"
 
 /* </Includes> */ 
 
@@ -34,34 +35,33 @@ void Thermometer_Init(void)
 { 
   ADC_SetupChannel(ADC_T, Measurement_Speed[Measurement_Fast]);
   ADCRaw = ADC_GetVoltage(ADC_T);
-  adcCounter = ADCRaw->counter;
-  temperature.counter = 0;
-  temperature.value = 0;
-  temperature.milliseconds = 0;
+  adcCounter = Data_GetCounter(ADCRaw);
+  Data_Clear(&temperature);
   thermometerError.errorCounter = 0;
   thermometerError.error = ErrorMessaging_Thermometer_HardwareFault;
 }
 
 void Thermometer_Do(void)
 {   
-  if (adcCounter != ADCRaw->counter) /* Process only new reading from ADC */
+  Data_Filtered<int32_t> raw;
+  uint8_t newCounter;
+
+  if ((adcCounter != Data_GetCounter(ADCRaw)) && Data_Read(ADCRaw, &raw, &newCounter)) /* Process only new reading from ADC */
   {  
     float rawTemperature;
     int32_t thermistorResistance; 
-    if ((ADCRaw->value <= 0) || (THERMOMETER_REFERENCE_VOLTAGE_IN_ADC_LSB <= ADCRaw->value))
+    if ((raw.value <= 0) || (THERMOMETER_REFERENCE_VOLTAGE_IN_ADC_LSB <= raw.value))
     {
       /* ERROR */
-      thermometerError.errorCounter++;
-      thermometerError.error = ErrorMessaging_Thermometer_HardwareFault;
+      ErrorMessaging_Raise(&thermometerError, ErrorMessaging_Thermometer_HardwareFault);
       return;
     }
     /* calculate resistance of the thermistor */
-    thermistorResistance = (THERMISTOR_R * (int64_t)(ADCRaw->value)) / THERMOMETER_REFERENCE_VOLTAGE_IN_ADC_LSB;
+    thermistorResistance = (THERMISTOR_R * (int64_t)(raw.value)) / THERMOMETER_REFERENCE_VOLTAGE_IN_ADC_LSB;
     if (thermistorResistance <= 0)
     {
       /* ERROR */      
-      thermometerError.errorCounter++;
-      thermometerError.error = ErrorMessaging_Thermometer_HardwareFault;
+      ErrorMessaging_Raise(&thermometerError, ErrorMessaging_Thermometer_HardwareFault);
       return;
     }
     
@@ -76,10 +76,9 @@ void Thermometer_Do(void)
       rawTemperature = 255;
     }
     
-    temperature.value = (uint8_t)rawTemperature;    
-    adcCounter = ADCRaw->counter;
-    temperature.counter++;
-    temperature.milliseconds = millis();
+    adcCounter = newCounter;
+    Data_Publish(&temperature, (uint8_t)rawTemperature);
+    Events_Publish(Event_Temperature);
   }
 }
 
@@ -65,8 +65,7 @@ void VoltageSetter_Do(void)
         dac = ((((uint64_t)((int32_t)presentVoltage + VOLTSETTER_OFFSET_HI))) << 16) / VOLTSETTER_SLOPE_HI;
         if (dac > DAC_MAXIMUM) /* Set voltage higher than maximum */
         {
-          VoltageSetterError.errorCounter++;
-          VoltageSetterError.error = ErrorMessaging_VoltageSetter_SetVoltageOverload;
+          ErrorMessaging_Raise(&VoltageSetterError, ErrorMessaging_VoltageSetter_SetVoltageOverload);
           dac = DAC_MAXIMUM;
         }
       }
@@ -93,9 +92,13 @@ void VoltageSetter_Do(void)
   /* Set calculated DAC value */
   if (!DACC_SetVoltage(dac & 0xFFFF))
   {
-    VoltageSetterError.errorCounter++;
-    VoltageSetterError.error = ErrorMessaging_VoltageSetter_SetVoltageOverload; 
+    ErrorMessaging_Raise(&VoltageSetterError, ErrorMessaging_VoltageSetter_SetVoltageOverload); 
   }  
+  /* The DAC write is only queued, the new value must be on the output before the range goes down or the phase changes */
+  if (((range == VoltageRange_LowVoltage) && (previousRange != range)) || (previousCCCVState != Control_CCCV_CV))
+  {
+    DACC_Wait();
+  }
   /* Set range if low voltage */
   if (range == VoltageRange_LowVoltage)
   {
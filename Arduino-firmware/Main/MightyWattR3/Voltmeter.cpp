@@ -17,6 +17,8 @@
 #include "DACC.h"
 #include "RangeSwitcher.h"
 #include "Control.h"
+#include "Events.h"
+#include "FastPin.h"
 
 /* </Includes> */ 
 
@@ -50,10 +52,10 @@ void Voltmeter_SetMode(Voltmeter_Modes mode);
 static TSCADCULong voltage; /* contains voltage in microvolts */
 static Voltmeter_Modes voltmeter_mode; /* 2-terminal or 4-terminal */
 static const TSCADCLong * ADCRaw;
-static uint8_t adcCounter, adcErrorCounter, commandCounter;
+static uint8_t adcCounter, adcErrorCounter;
 static ErrorMessaging_Error VoltmeterError;
 const static ErrorMessaging_Error * ADCError;
-const static Communication_WriteCommand * writeCommand;
+static Communication_WriteCommandCursor commandCursor; /* Position of this module in the received write commands */
 static bool resetFilter;
 
 /* </Module variables> */ 
@@ -67,16 +69,13 @@ void Voltmeter_Init(void)
   Voltmeter_SetSpeed(VOLTMETER_DEFAULT_MEASUREMENT_SPEED);
   Voltmeter_SetMode(VOLTMETER_DEFAULT_MODE);
   ADCRaw = ADC_GetVoltage(ADC_V);
-  adcCounter = ADCRaw->counter;
-  voltage.counter = 0;
-  voltage.milliseconds = 0;
-  voltage.value = 0;
+  adcCounter = Data_GetCounter(ADCRaw);
+  Data_Clear(&voltage);
   VoltmeterError.errorCounter = 0;
   VoltmeterError.error = ErrorMessaging_Voltmeter_VoltageOverload;
   ADCError = ADC_GetError(ADC_V);
   adcErrorCounter = ADCError->errorCounter;
-  writeCommand = Communication_GetWriteCommand();
-  commandCounter = writeCommand->commandCounter;
+  Communication_InitWriteCommandCursor(&commandCursor, COMMUNICATION_COMMAND_BIT(WriteCommand_4Wire));
   resetFilter = false;  
 }
 
@@ -88,11 +87,11 @@ void Voltmeter_Do(void)
 
 void Voltmeter_ProcessADC(void)
 {
+  Data_Filtered<int32_t> raw;
   RangeSwitcher_VoltageRanges range = RangeSwitcher_GetVoltageRange();
   
-  if (adcCounter != ADCRaw->counter) /* Process only new reading from ADC */
+  if (Data_ReadNew(ADCRaw, &adcCounter, &raw)) /* Process only new reading from ADC */
   {  
-    adcCounter = ADCRaw->counter;
 
     if (resetFilter)
     {
@@ -113,14 +112,13 @@ void Voltmeter_ProcessADC(void)
           adcErrorCounter = ADCError->errorCounter;
           if (ADCError->error == ErrorMessaging_ADC_Overload)
           {
-            VoltmeterError.errorCounter++;
-            VoltmeterError.error = ErrorMessaging_Voltmeter_VoltageOverload;
+            ErrorMessaging_Raise(&VoltmeterError, ErrorMessaging_Voltmeter_VoltageOverload);
           }
         }
 
         /* calculate new voltage value and save it to local variable "voltage" */ 
-        signedVoltage = (((int64_t)(VOLTMETER_SLOPE_HI)) * ((int64_t)(ADCRaw->value))) / (DAC_REFERENCE_VOLTAGE * ADC_RECIPROCAL_LSB) + VOLTMETER_OFFSET_HI;
-        signedUnfilteredVoltage = (((int64_t)(VOLTMETER_SLOPE_HI)) * ((int64_t)(ADCRaw->unfilteredValue))) / (DAC_REFERENCE_VOLTAGE * ADC_RECIPROCAL_LSB) + VOLTMETER_OFFSET_HI;
+        signedVoltage = Voltmeter_GetVoltageFromADC(raw.value, VoltageRange_HighVoltage);
+        signedUnfilteredVoltage = Voltmeter_GetVoltageFromADC(raw.unfilteredValue, VoltageRange_HighVoltage);
       break;
       case VoltageRange_LowVoltage:
         /* ADC overload in low voltage range will only switch to high voltage range*/
@@ -135,8 +133,8 @@ void Voltmeter_ProcessADC(void)
           }      
         }
         /* calculate new voltage value and save it to local variable "voltage" */
-        signedVoltage = (((int64_t)(VOLTMETER_SLOPE_LO)) * ((int64_t)(ADCRaw->value))) / (DAC_REFERENCE_VOLTAGE * ADC_RECIPROCAL_LSB) + VOLTMETER_OFFSET_LO;
-        signedUnfilteredVoltage = (((int64_t)(VOLTMETER_SLOPE_LO)) * ((int64_t)(ADCRaw->unfilteredValue))) / (DAC_REFERENCE_VOLTAGE * ADC_RECIPROCAL_LSB) + VOLTMETER_OFFSET_LO;
+        signedVoltage = Voltmeter_GetVoltageFromADC(raw.value, VoltageRange_LowVoltage);
+        signedUnfilteredVoltage = Voltmeter_GetVoltageFromADC(raw.unfilteredValue, VoltageRange_LowVoltage);
       break;
       default:
       return;
@@ -145,8 +143,7 @@ void Voltmeter_ProcessADC(void)
     if (signedUnfilteredVoltage < VOLTMETER_MINIMUM_VOLTAGE)
     {
       /* Signal negative voltage */
-      VoltmeterError.errorCounter++;
-      VoltmeterError.error = ErrorMessaging_Voltmeter_NegativeVoltage;
+      ErrorMessaging_Raise(&VoltmeterError, ErrorMessaging_Voltmeter_NegativeVoltage);
     }
 
     uint32_t newFilteredVoltage;
@@ -188,37 +185,42 @@ void Voltmeter_ProcessADC(void)
 
     if (false == resetFilter)
     {
-      voltage.value = newFilteredVoltage;
-      voltage.unfilteredValue = newUnfilteredVoltage;
-      voltage.counter++;
-      voltage.milliseconds = millis();
+      Data_Filtered<uint32_t> newVoltage = {newFilteredVoltage, newUnfilteredVoltage};
+      Data_Publish(&voltage, newVoltage);
+      Events_Publish(Event_Voltage);
     }
   }
 }
 
 void Voltmeter_ProcessCommunication(void)
 {
+  const Communication_Command * newCommand;
+
   /* Process new communication command - set mode*/
-  if (commandCounter != writeCommand->commandCounter)
+  while ((newCommand = Communication_GetNextWriteCommand(&commandCursor)) != NULL)
   {
     /* LSB first */
-    switch (writeCommand->command)
+    switch (newCommand->command)
     {
       case WriteCommand_4Wire:
-        if ((writeCommand->data)[0] == 0)
+        if ((newCommand->data)[0] == 0)
         {
           Voltmeter_SetMode(Voltmeter_2Terminal);
         }
-        else if ((writeCommand->data)[0] == 1)
+        else if ((newCommand->data)[0] == 1)
         {
           Voltmeter_SetMode(Voltmeter_4Terminal);
         }
+        else
+        {
+          Communication_AcknowledgeCommand(newCommand, Acknowledge_InvalidValue);
+          break;
+        }
+        Communication_AcknowledgeCommand(newCommand, Acknowledge_Applied);
       break;
       default:
       break;
     }
-    
-    commandCounter = writeCommand->commandCounter;
   }
 }
 
@@ -234,10 +236,10 @@ void Voltmeter_SetMode(Voltmeter_Modes mode)
   switch (voltmeter_mode)
   {
     case Voltmeter_2Terminal:
-      digitalWrite(VOLTMETER_4TERMINAL_PIN, LOW);
+      FastPin_Low<VOLTMETER_4TERMINAL_PIN>();
     break;
     case Voltmeter_4Terminal:
-      digitalWrite(VOLTMETER_4TERMINAL_PIN, HIGH);
+      FastPin_High<VOLTMETER_4TERMINAL_PIN>();
     break;
     default:
     break;
@@ -254,6 +256,18 @@ Voltmeter_Modes Voltmeter_GetMode(void)
   return voltmeter_mode;
 }
 
+int32_t Voltmeter_GetVoltageFromADC(int32_t adcVoltage, RangeSwitcher_VoltageRanges range)
+{
+  if (range == VoltageRange_HighVoltage)
+  {
+    return (((int64_t)(VOLTMETER_SLOPE_HI)) * ((int64_t)adcVoltage)) / (DAC_REFERENCE_VOLTAGE * ADC_RECIPROCAL_LSB) + VOLTMETER_OFFSET_HI;
+  }
+  else
+  {
+    return (((int64_t)(VOLTMETER_SLOPE_LO)) * ((int64_t)adcVoltage)) / (DAC_REFERENCE_VOLTAGE * ADC_RECIPROCAL_LSB) + VOLTMETER_OFFSET_LO;
+  }
+}
+
 const ErrorMessaging_Error * Voltmeter_GetError(void)
 {
   return &VoltmeterError;
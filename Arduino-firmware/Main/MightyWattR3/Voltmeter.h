@@ -15,6 +15,7 @@
 #include "Configuration.h"
 #include "Measurement.h"
 #include "ErrorMessaging.h"
+#include "RangeSwitcher.h"
  
 /* </Includes> */ 
  
@@ -94,6 +95,16 @@ Voltmeter_Modes Voltmeter_GetMode(void);
  */
 const TSCADCULong * Voltmeter_GetVoltage(void);
 
+/**
+ * Calculates the voltage from an ADC voltage
+ *
+ * @param adcVoltage - ADC voltage (ADS1x15_Voltage)
+ * @param range - hardware voltage range the ADC voltage was measured in
+ *
+ * @return - Voltage in microvolts, negative values are not clipped
+ */
+int32_t Voltmeter_GetVoltageFromADC(int32_t adcVoltage, RangeSwitcher_VoltageRanges range);
+
 /**
  * Returns error structure for this module
  *
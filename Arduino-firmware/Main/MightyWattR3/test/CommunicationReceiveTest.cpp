@@ -0,0 +1,305 @@
+/**
+ * CommunicationReceiveTest.cpp
+ * Feeds fragmented and corrupted raw frames to the receiving part of the communication module
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+/* <Includes> */
+
+#include "Test.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define TEST_STREAM_COMMANDS            24
+#define TEST_STREAM_MAXIMUM_LENGTH      (TEST_STREAM_COMMANDS * TEST_FRAME_MAXIMUM_LENGTH)
+#define TEST_RESYNCHRONIZATION_PASSES   1000 /* Enough for several COMMUNICATION_TIMEOUT of false headers */
+
+/* </Defines> */
+
+
+/* <Module variables> */
+
+static const uint8_t dataLengths[] = {0, 1, 2, COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH, 10, COMMUNICATION_EXTENDED_MAXIMUM_DATA_LENGTH};
+static uint32_t randomState = 1;
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Moves the received bytes to the buffer and processes the complete frames, declared in Communication.cpp
+ */
+void Communication_Receive(void);
+
+/**
+ * Pseudo-random numbers that are the same in every run
+ *
+ * @return - Next number, 0 to 255
+ */
+uint8_t TestReceive_Random(void);
+
+/**
+ * Fills a command with random data
+ *
+ * @param command - the command to fill
+ * @param commandNumber - number of the command
+ * @param dataLength - number of data bytes
+ */
+void TestReceive_SetCommand(Test_Command * command, uint8_t commandNumber, uint8_t dataLength);
+
+/**
+ * Sends a valid frame one byte per loop pass
+ */
+void TestReceive_ByteByByte(void);
+
+/**
+ * Sends frames of all lengths split at random positions over many loop passes
+ */
+void TestReceive_Fragmented(void);
+
+/**
+ * Sends a frame split at every position, the first part must return immediately without a command
+ */
+void TestReceive_PartialFrame(void);
+
+/**
+ * Sends a frame with a wrong CRC followed by a valid one in the same chunk
+ */
+void TestReceive_CorruptedCRC(void);
+
+/**
+ * Sends bytes that are not a frame before a valid frame
+ */
+void TestReceive_Garbage(void);
+
+/**
+ * Sends a truncated frame, the rest does not arrive within COMMUNICATION_TIMEOUT
+ */
+void TestReceive_Timeout(void);
+
+/**
+ * Flips every bit of a frame one at a time, the valid frames that follow must be received
+ */
+void TestReceive_EveryBitFlipped(void);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+int main(void)
+{
+  TestReceive_ByteByByte();
+  TestReceive_Fragmented();
+  TestReceive_PartialFrame();
+  TestReceive_CorruptedCRC();
+  TestReceive_Garbage();
+  TestReceive_Timeout();
+  TestReceive_EveryBitFlipped();
+  return Test_Finish("CommunicationReceiveTest");
+}
+
+uint8_t TestReceive_Random(void)
+{
+  randomState = randomState * 1103515245UL + 12345UL;
+  return (randomState >> 16) & 0xFF;
+}
+
+void TestReceive_SetCommand(Test_Command * command, uint8_t commandNumber, uint8_t dataLength)
+{
+  uint8_t i;
+
+  command->command = commandNumber;
+  command->dataLength = dataLength;
+  for (i = 0; i < dataLength; i++)
+  {
+    command->data[i] = TestReceive_Random();
+  }
+}
+
+void TestReceive_ByteByByte(void)
+{
+  Test_Command command;
+  uint8_t frame[TEST_FRAME_MAXIMUM_LENGTH];
+  uint8_t i, length;
+
+  Test_Init();
+  TestReceive_SetCommand(&command, WriteCommand_ConstantCurrent, COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH);
+  length = Test_ComposeFrame(frame, &command);
+  for (i = 0; i < length; i++)
+  {
+    TEST_CHECK(Test_GetCommand() == NULL);
+    Stubs_Receive(frame + i, 1);
+    Test_Run(1);
+  }
+  TEST_CHECK(Test_IsEqual(Test_GetCommand(), &command));
+  TEST_CHECK(Test_GetCommand() == NULL);
+  TEST_CHECK(Communication_GetStatistics()->crcErrors == 0);
+  TEST_CHECK(Communication_GetStatistics()->timeouts == 0);
+}
+
+void TestReceive_Fragmented(void)
+{
+  Test_Command commands[TEST_STREAM_COMMANDS];
+  uint8_t stream[TEST_STREAM_MAXIMUM_LENGTH];
+  uint16_t length = 0, sent = 0, chunk;
+  uint8_t i, received = 0;
+  const Communication_Command * command;
+
+  Test_Init();
+  for (i = 0; i < TEST_STREAM_COMMANDS; i++)
+  {
+    TestReceive_SetCommand(&commands[i], (i & 1) ? WriteCommand_ConstantVoltage : 40, dataLengths[i % sizeof(dataLengths)]);
+    length += Test_ComposeFrame(stream + length, &commands[i]);
+  }
+
+  while (sent < length)
+  {
+    chunk = 1 + TestReceive_Random() % 7;
+    if (chunk > length - sent)
+    {
+      chunk = length - sent;
+    }
+    Stubs_Receive(stream + sent, chunk);
+    sent += chunk;
+    Test_Run(1);
+    while ((command = Test_GetCommand()) != NULL)
+    {
+      TEST_CHECK(received < TEST_STREAM_COMMANDS);
+      if (received < TEST_STREAM_COMMANDS)
+      {
+        TEST_CHECK(Test_IsEqual(command, &commands[received]));
+      }
+      received++;
+    }
+  }
+  Test_Run(1);
+  TEST_CHECK(Test_GetCommand() == NULL);
+  TEST_CHECK(received == TEST_STREAM_COMMANDS);
+  TEST_CHECK(Communication_GetStatistics()->crcErrors == 0);
+  TEST_CHECK(Communication_GetStatistics()->rejectedCommands == 0);
+}
+
+void TestReceive_PartialFrame(void)
+{
+  Test_Command command;
+  uint8_t frame[TEST_FRAME_MAXIMUM_LENGTH];
+  uint8_t split, length;
+  uint32_t start;
+
+  TestReceive_SetCommand(&command, 40, COMMUNICATION_EXTENDED_MAXIMUM_DATA_LENGTH);
+  length = Test_ComposeFrame(frame, &command);
+  for (split = 1; split < length; split++)
+  {
+    Test_Init();
+    Stubs_Receive(frame, split);
+    start = micros();
+    Communication_Receive();
+    TEST_CHECK(micros() == start); /* Does not wait for the rest of the frame */
+    TEST_CHECK(Stubs_GetPendingBytes() == 0);
+    TEST_CHECK(Test_GetCommand() == NULL);
+
+    Stubs_Receive(frame + split, length - split);
+    Communication_Receive();
+    TEST_CHECK(micros() == start);
+    TEST_CHECK(Test_IsEqual(Test_GetCommand(), &command));
+    TEST_CHECK(Test_GetCommand() == NULL);
+  }
+}
+
+void TestReceive_CorruptedCRC(void)
+{
+  Test_Command corrupted, valid;
+  uint8_t stream[2 * TEST_FRAME_MAXIMUM_LENGTH];
+  uint8_t length;
+
+  Test_Init();
+  TestReceive_SetCommand(&corrupted, WriteCommand_ConstantCurrent, COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH);
+  TestReceive_SetCommand(&valid, WriteCommand_ConstantVoltage, COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH);
+  length = Test_ComposeFrame(stream, &corrupted);
+  stream[length - 1] ^= 0x01;
+  length += Test_ComposeFrame(stream + length, &valid);
+  Stubs_Receive(stream, length);
+  Test_Run(1);
+  TEST_CHECK(Test_IsEqual(Test_GetCommand(), &valid));
+  TEST_CHECK(Test_GetCommand() == NULL);
+  TEST_CHECK(Communication_GetStatistics()->crcErrors == 1);
+}
+
+void TestReceive_Garbage(void)
+{
+  static const uint8_t garbage[] = {0x00, 0x80, 0x55, 0xAA, 0xFF, 0x7F};
+  Test_Command valid;
+  uint8_t frame[TEST_FRAME_MAXIMUM_LENGTH];
+  uint8_t length;
+
+  Test_Init();
+  TestReceive_SetCommand(&valid, WriteCommand_ConstantCurrent, COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH);
+  length = Test_ComposeFrame(frame, &valid);
+  Stubs_Receive(garbage, sizeof(garbage));
+  Stubs_Receive(frame, length);
+  Test_Run(TEST_RESYNCHRONIZATION_PASSES);
+  TEST_CHECK(Test_IsEqual(Test_GetCommand(), &valid));
+  TEST_CHECK(Test_GetCommand() == NULL);
+}
+
+void TestReceive_Timeout(void)
+{
+  Test_Command truncated, valid;
+  uint8_t frame[TEST_FRAME_MAXIMUM_LENGTH];
+  uint8_t length;
+
+  Test_Init();
+  TestReceive_SetCommand(&truncated, WriteCommand_ConstantCurrent, COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH);
+  TestReceive_SetCommand(&valid, WriteCommand_ConstantVoltage, COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH);
+  length = Test_ComposeFrame(frame, &truncated);
+  Stubs_Receive(frame, length - 2);
+  Test_Run(COMMUNICATION_TIMEOUT / 2);
+  TEST_CHECK(Communication_GetStatistics()->timeouts == 0); /* Slow sender is not a timeout */
+  Test_Run(COMMUNICATION_TIMEOUT);
+  TEST_CHECK(Communication_GetStatistics()->timeouts == 1);
+
+  length = Test_ComposeFrame(frame, &valid);
+  Stubs_Receive(frame, length);
+  Test_Run(TEST_RESYNCHRONIZATION_PASSES);
+  TEST_CHECK(Test_IsEqual(Test_GetCommand(), &valid));
+  TEST_CHECK(Test_GetCommand() == NULL);
+}
+
+void TestReceive_EveryBitFlipped(void)
+{
+  Test_Command corrupted, valid[2];
+  uint8_t stream[3 * TEST_FRAME_MAXIMUM_LENGTH];
+  uint8_t i, bit, length, corruptedLength;
+
+  TestReceive_SetCommand(&corrupted, WriteCommand_ConstantCurrent, COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH);
+  TestReceive_SetCommand(&valid[0], WriteCommand_4Wire, 1);
+  TestReceive_SetCommand(&valid[1], WriteCommand_ConstantVoltage, COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH);
+  corruptedLength = Test_ComposeFrame(stream, &corrupted);
+
+  for (i = 0; i < corruptedLength; i++)
+  {
+    for (bit = 0; bit < 8; bit++)
+    {
+      Test_Init();
+      length = Test_ComposeFrame(stream, &corrupted);
+      stream[i] ^= (1 << bit);
+      length += Test_ComposeFrame(stream + length, &valid[0]);
+      length += Test_ComposeFrame(stream + length, &valid[1]);
+      Stubs_Receive(stream, length);
+      Test_Run(TEST_RESYNCHRONIZATION_PASSES);
+      TEST_CHECK(Test_IsEqual(Test_GetCommand(), &valid[0]));
+      TEST_CHECK(Test_IsEqual(Test_GetCommand(), &valid[1]));
+      TEST_CHECK(Test_GetCommand() == NULL);
+    }
+  }
+}
+
+/* </Implementations> */
@@ -0,0 +1,313 @@
+/**
+ * SLIPTest.cpp
+ * Injects corrupted bytes into SLIP frames, the receiver must recover within one frame
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+/* <Includes> */
+
+#include "Test.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define TEST_SLIP_PASSES                2 /* SLIP frames do not wait for a timeout, the next frame is received at once */
+#define TEST_SLIP_STREAM_COMMANDS       30
+#define TEST_SLIP_GARBAGE_LENGTH        (2 * COMMUNICATION_FRAME_MAXIMUM_LENGTH)
+
+/* </Defines> */
+
+
+/* <Module variables> */
+
+static Test_Command corrupted, valid;
+static uint8_t corruptedFrame[TEST_SLIP_MAXIMUM_LENGTH], validFrame[TEST_SLIP_MAXIMUM_LENGTH];
+static uint8_t corruptedLength, validLength;
+static uint32_t randomState = 7;
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Pseudo-random numbers that are the same in every run
+ *
+ * @return - Next number, 0 to 255
+ */
+uint8_t TestSLIP_Random(void);
+
+/**
+ * Initializes the communication module and switches it to SLIP framing by a raw frame
+ */
+void TestSLIP_Init(void);
+
+/**
+ * Sends the stream, then checks that only the valid command was received
+ *
+ * @param stream - corrupted frame followed by the valid frame
+ * @param length - length of the stream
+ */
+void TestSLIP_CheckRecovery(const uint8_t * stream, uint16_t length);
+
+/**
+ * Replaces every byte of the corrupted frame but the delimiters by a few other values, one at a time
+ */
+void TestSLIP_Substitution(void);
+
+/**
+ * Removes every byte of the corrupted frame but the delimiters, one at a time
+ */
+void TestSLIP_Deletion(void);
+
+/**
+ * Inserts a delimiter, an escape or a plain byte between every two bytes of the corrupted frame, one at a time
+ */
+void TestSLIP_Insertion(void);
+
+/**
+ * Loses the delimiter between two frames, or leaves an escape before it
+ */
+void TestSLIP_Delimiters(void);
+
+/**
+ * Sends a long run of bytes without a delimiter before the valid frame
+ */
+void TestSLIP_Overlong(void);
+
+/**
+ * Sends frames split at random positions, every third frame has a flipped bit, all other frames must be received in order
+ */
+void TestSLIP_FragmentedStream(void);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+int main(void)
+{
+  uint8_t frame[TEST_FRAME_MAXIMUM_LENGTH];
+  uint8_t i, length;
+
+  /* Data with both special bytes so that escaping is exercised */
+  corrupted.command = WriteCommand_ConstantCurrent;
+  corrupted.dataLength = COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH;
+  corrupted.data[0] = COMMUNICATION_SLIP_END;
+  corrupted.data[1] = 0x12;
+  corrupted.data[2] = COMMUNICATION_SLIP_ESC;
+  corrupted.data[3] = 0x34;
+  length = Test_ComposeFrame(frame, &corrupted);
+  corruptedLength = Test_EncodeSLIP(corruptedFrame, frame, length);
+
+  valid.command = 40;
+  valid.dataLength = 8;
+  for (i = 0; i < valid.dataLength; i++)
+  {
+    valid.data[i] = (i & 1) ? COMMUNICATION_SLIP_ESC : COMMUNICATION_SLIP_END;
+  }
+  length = Test_ComposeFrame(frame, &valid);
+  validLength = Test_EncodeSLIP(validFrame, frame, length);
+
+  TestSLIP_Substitution();
+  TestSLIP_Deletion();
+  TestSLIP_Insertion();
+  TestSLIP_Delimiters();
+  TestSLIP_Overlong();
+  TestSLIP_FragmentedStream();
+  return Test_Finish("SLIPTest");
+}
+
+uint8_t TestSLIP_Random(void)
+{
+  randomState = randomState * 1103515245UL + 12345UL;
+  return (randomState >> 16) & 0xFF;
+}
+
+void TestSLIP_Init(void)
+{
+  Test_Command framing;
+  uint8_t frame[TEST_FRAME_MAXIMUM_LENGTH];
+  uint8_t length;
+
+  Test_Init();
+  framing.command = WriteCommand_Framing;
+  framing.dataLength = 1;
+  framing.data[0] = Framing_SLIP;
+  length = Test_ComposeFrame(frame, &framing);
+  Stubs_Receive(frame, length);
+  Test_Run(1);
+  TEST_CHECK(Test_IsEqual(Test_GetCommand(), &framing));
+}
+
+void TestSLIP_CheckRecovery(const uint8_t * stream, uint16_t length)
+{
+  Stubs_Receive(stream, length);
+  Test_Run(TEST_SLIP_PASSES);
+  TEST_CHECK(Test_IsEqual(Test_GetCommand(), &valid));
+  TEST_CHECK(Test_GetCommand() == NULL);
+}
+
+void TestSLIP_Substitution(void)
+{
+  uint8_t stream[2 * TEST_SLIP_MAXIMUM_LENGTH];
+  uint8_t i, j;
+  uint8_t values[5];
+
+  for (i = 1; i < corruptedLength - 1; i++)
+  {
+    values[0] = corruptedFrame[i] ^ 0x01;
+    values[1] = corruptedFrame[i] ^ 0x80;
+    values[2] = COMMUNICATION_SLIP_END;
+    values[3] = COMMUNICATION_SLIP_ESC;
+    values[4] = 0x00;
+    for (j = 0; j < sizeof(values); j++)
+    {
+      if (values[j] == corruptedFrame[i])
+      {
+        continue;
+      }
+      TestSLIP_Init();
+      memcpy(stream, corruptedFrame, corruptedLength);
+      stream[i] = values[j];
+      memcpy(stream + corruptedLength, validFrame, validLength);
+      TestSLIP_CheckRecovery(stream, corruptedLength + validLength);
+    }
+  }
+}
+
+void TestSLIP_Deletion(void)
+{
+  uint8_t stream[2 * TEST_SLIP_MAXIMUM_LENGTH];
+  uint8_t i;
+
+  for (i = 1; i < corruptedLength - 1; i++)
+  {
+    TestSLIP_Init();
+    memcpy(stream, corruptedFrame, i);
+    memcpy(stream + i, corruptedFrame + i + 1, corruptedLength - i - 1);
+    memcpy(stream + corruptedLength - 1, validFrame, validLength);
+    TestSLIP_CheckRecovery(stream, corruptedLength - 1 + validLength);
+  }
+}
+
+void TestSLIP_Insertion(void)
+{
+  static const uint8_t values[] = {COMMUNICATION_SLIP_END, COMMUNICATION_SLIP_ESC, 0x55};
+  uint8_t stream[2 * TEST_SLIP_MAXIMUM_LENGTH];
+  uint8_t i, j;
+
+  for (i = 2; i < corruptedLength - 1; i++)
+  {
+    for (j = 0; j < sizeof(values); j++)
+    {
+      TestSLIP_Init();
+      memcpy(stream, corruptedFrame, i);
+      stream[i] = values[j];
+      memcpy(stream + i + 1, corruptedFrame + i, corruptedLength - i);
+      memcpy(stream + corruptedLength + 1, validFrame, validLength);
+      TestSLIP_CheckRecovery(stream, corruptedLength + 1 + validLength);
+    }
+  }
+}
+
+void TestSLIP_Delimiters(void)
+{
+  uint8_t stream[2 * TEST_SLIP_MAXIMUM_LENGTH];
+
+  /* Delimiter between the frames lost, the leading delimiter of the valid frame still ends the first one */
+  TestSLIP_Init();
+  memcpy(stream, corruptedFrame, corruptedLength - 1);
+  memcpy(stream + corruptedLength - 1, validFrame, validLength);
+  Stubs_Receive(stream, corruptedLength - 1 + validLength);
+  Test_Run(TEST_SLIP_PASSES);
+  TEST_CHECK(Test_IsEqual(Test_GetCommand(), &corrupted));
+  TEST_CHECK(Test_IsEqual(Test_GetCommand(), &valid));
+  TEST_CHECK(Test_GetCommand() == NULL);
+
+  /* Escape before the delimiter */
+  TestSLIP_Init();
+  memcpy(stream, corruptedFrame, corruptedLength - 1);
+  stream[corruptedLength - 1] = COMMUNICATION_SLIP_ESC;
+  stream[corruptedLength] = COMMUNICATION_SLIP_END;
+  memcpy(stream + corruptedLength + 1, validFrame, validLength);
+  TestSLIP_CheckRecovery(stream, corruptedLength + 1 + validLength);
+  TEST_CHECK(Communication_GetStatistics()->framingErrors == 1);
+}
+
+void TestSLIP_Overlong(void)
+{
+  uint8_t stream[TEST_SLIP_GARBAGE_LENGTH + TEST_SLIP_MAXIMUM_LENGTH];
+  uint16_t i;
+
+  TestSLIP_Init();
+  stream[0] = COMMUNICATION_SLIP_END;
+  for (i = 1; i < TEST_SLIP_GARBAGE_LENGTH; i++)
+  {
+    stream[i] = 0x55;
+  }
+  memcpy(stream + TEST_SLIP_GARBAGE_LENGTH, validFrame, validLength);
+  TestSLIP_CheckRecovery(stream, TEST_SLIP_GARBAGE_LENGTH + validLength);
+  TEST_CHECK(Communication_GetStatistics()->framingErrors == 1);
+}
+
+void TestSLIP_FragmentedStream(void)
+{
+  Test_Command commands[TEST_SLIP_STREAM_COMMANDS];
+  uint8_t stream[TEST_SLIP_STREAM_COMMANDS * TEST_SLIP_MAXIMUM_LENGTH];
+  uint8_t frame[TEST_FRAME_MAXIMUM_LENGTH];
+  uint16_t length = 0, sent = 0, chunk;
+  uint8_t i, j, frameLength, expected = 0;
+  const Communication_Command * command;
+
+  TestSLIP_Init();
+  for (i = 0; i < TEST_SLIP_STREAM_COMMANDS; i++)
+  {
+    commands[i].command = (i & 1) ? WriteCommand_ConstantVoltage : 40;
+    commands[i].dataLength = (i & 1) ? COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH : (TestSLIP_Random() % (COMMUNICATION_EXTENDED_MAXIMUM_DATA_LENGTH + 1));
+    for (j = 0; j < commands[i].dataLength; j++)
+    {
+      commands[i].data[j] = TestSLIP_Random();
+    }
+    frameLength = Test_ComposeFrame(frame, &commands[i]);
+    if ((i % 3) == 2)
+    {
+      frame[TestSLIP_Random() % frameLength] ^= 1 << (TestSLIP_Random() & 7);
+    }
+    length += Test_EncodeSLIP(stream + length, frame, frameLength);
+  }
+
+  while (sent < length)
+  {
+    chunk = 1 + TestSLIP_Random() % 16;
+    if (chunk > length - sent)
+    {
+      chunk = length - sent;
+    }
+    Stubs_Receive(stream + sent, chunk);
+    sent += chunk;
+    Test_Run(1);
+    while ((command = Test_GetCommand()) != NULL)
+    {
+      while ((expected % 3) == 2)
+      {
+        expected++; /* Corrupted frame must be skipped */
+      }
+      TEST_CHECK(expected < TEST_SLIP_STREAM_COMMANDS);
+      if (expected < TEST_SLIP_STREAM_COMMANDS)
+      {
+        TEST_CHECK(Test_IsEqual(command, &commands[expected]));
+      }
+      expected++;
+    }
+  }
+  TEST_CHECK(expected == TEST_SLIP_STREAM_COMMANDS - ((TEST_SLIP_STREAM_COMMANDS % 3) == 0 ? 1 : 0));
+  TEST_CHECK(Communication_GetStatistics()->crcErrors + Communication_GetStatistics()->framingErrors == TEST_SLIP_STREAM_COMMANDS / 3);
+}
+
+/* </Implementations> */
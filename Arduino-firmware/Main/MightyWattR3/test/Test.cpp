@@ -0,0 +1,161 @@
+/**
+ * Test.cpp
+ * Common parts of the host tests of the communication module
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+/* <Includes> */
+
+#include <stdio.h>
+#include "Test.h"
+#include "ErrorMessaging.h"
+#include "Events.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static Communication_WriteCommandCursor cursor; /* Reads all commands like a module that handles all of them */
+static uint16_t checks, failures;
+static uint32_t currentTime; /* ms */
+
+/* </Module variables> */
+
+
+/* <Implementations> */
+
+void Test_Init(void)
+{
+  currentTime = 0;
+  Stubs_SetMillis(currentTime);
+  Events_Init();
+  ErrorMessaging_Init();
+  Communication_Init();
+  Communication_InitWriteCommandCursor(&cursor, COMMUNICATION_ALL_COMMANDS);
+}
+
+void Test_Check(bool condition, const char * text, const char * file, int line)
+{
+  checks++;
+  if (!condition)
+  {
+    failures++;
+    printf("%s:%d: check failed: %s\n", file, line, text);
+  }
+}
+
+int Test_Finish(const char * name)
+{
+  printf("%s: %u checks, %u failed\n", name, checks, failures);
+  return (failures == 0) ? 0 : 1;
+}
+
+uint8_t Test_ComposeFrame(uint8_t * frame, const Test_Command * command)
+{
+  uint8_t i, length = 0;
+  uint16_t crc;
+
+  if ((command->command < COMMUNICATION_COMMAND_EXTENDED) && (command->dataLength <= 2))
+  {
+    frame[length++] = 0x80 | (command->dataLength << 5) | command->command;
+  }
+  else if ((command->command < COMMUNICATION_COMMAND_EXTENDED) && (command->dataLength == COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH))
+  {
+    frame[length++] = 0x80 | (3 << 5) | command->command;
+  }
+  else
+  {
+    frame[length++] = 0x80 | COMMUNICATION_COMMAND_EXTENDED;
+    frame[length++] = command->command;
+    frame[length++] = command->dataLength;
+  }
+  for (i = 0; i < command->dataLength; i++)
+  {
+    frame[length++] = command->data[i];
+  }
+  crc = 0;
+  for (i = 0; i < length; i++)
+  {
+    crc = CRC16_AddByte(COMMUNICATION_CRC_POLYNOMIAL_VALUE, crc, frame[i]);
+  }
+  frame[length++] = crc & 0xFF;
+  frame[length++] = (crc >> 8) & 0xFF;
+  return length;
+}
+
+uint8_t Test_EncodeSLIP(uint8_t * encoded, const uint8_t * frame, uint8_t length)
+{
+  uint8_t i, encodedLength = 0;
+
+  encoded[encodedLength++] = COMMUNICATION_SLIP_END;
+  for (i = 0; i < length; i++)
+  {
+    if (frame[i] == COMMUNICATION_SLIP_END)
+    {
+      encoded[encodedLength++] = COMMUNICATION_SLIP_ESC;
+      encoded[encodedLength++] = COMMUNICATION_SLIP_ESC_END;
+    }
+    else if (frame[i] == COMMUNICATION_SLIP_ESC)
+    {
+      encoded[encodedLength++] = COMMUNICATION_SLIP_ESC;
+      encoded[encodedLength++] = COMMUNICATION_SLIP_ESC_ESC;
+    }
+    else
+    {
+      encoded[encodedLength++] = frame[i];
+    }
+  }
+  encoded[encodedLength++] = COMMUNICATION_SLIP_END;
+  return encodedLength;
+}
+
+void Test_Run(uint16_t passes)
+{
+  uint16_t i;
+  uint32_t passStart;
+
+  for (i = 0; i < passes; i++)
+  {
+    passStart = micros();
+    Communication_Do();
+    TEST_CHECK(micros() == passStart); /* Neither receiving nor sending waits, the stub port advances the time only for a waiting loop */
+    currentTime += TEST_PASS_MILLISECONDS;
+    Stubs_SetMillis(currentTime);
+  }
+}
+
+const Communication_Command * Test_GetCommand(void)
+{
+  return Communication_GetNextWriteCommand(&cursor);
+}
+
+bool Test_IsEqual(const Communication_Command * received, const Test_Command * sent)
+{
+  uint8_t i;
+
+  if ((received == NULL) || (received->command != sent->command) || (received->dataLength != sent->dataLength))
+  {
+    return false;
+  }
+  for (i = 0; i < sent->dataLength; i++)
+  {
+    if (received->data[i] != sent->data[i])
+    {
+      return false;
+    }
+  }
+  for (; i < COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH; i++)
+  {
+    if (received->data[i] != 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* </Implementations> */
@@ -0,0 +1,120 @@
+/**
+ * Test.h
+ * Common parts of the host tests of the communication module
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+/* <Includes> */
+
+#include "Arduino.h"
+#include "Communication.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define TEST_FRAME_MAXIMUM_LENGTH       COMMUNICATION_FRAME_MAXIMUM_LENGTH
+#define TEST_SLIP_MAXIMUM_LENGTH        (2 * TEST_FRAME_MAXIMUM_LENGTH + 2) /* Every byte escaped and both delimiters */
+#define TEST_PASS_MILLISECONDS          1 /* Time between two loop passes */
+#define TEST_CHECK(condition)           Test_Check((condition), #condition, __FILE__, __LINE__)
+
+/* </Defines> */
+
+
+/* <Structs> */
+
+/**
+ * Write command as the host sends it and as a module should receive it
+ */
+struct Test_Command
+{
+  uint8_t command;
+  uint8_t dataLength;
+  uint8_t data[COMMUNICATION_EXTENDED_MAXIMUM_DATA_LENGTH];
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the communication module, the test cursor and the time
+ */
+void Test_Init(void);
+
+/**
+ * Records the result of a check, a failed check is printed
+ *
+ * @param condition - result of the check
+ * @param text - the checked expression
+ * @param file - source file of the check
+ * @param line - line of the check
+ */
+void Test_Check(bool condition, const char * text, const char * file, int line);
+
+/**
+ * Prints the number of failed checks
+ *
+ * @param name - name of the test
+ *
+ * @return - Exit code of the test, 0 if all checks passed
+ */
+int Test_Finish(const char * name);
+
+/**
+ * Composes a write frame of the command, standard frame if the command and the data fit into it, extended frame otherwise
+ *
+ * @param frame - filled with the frame, at least TEST_FRAME_MAXIMUM_LENGTH bytes
+ * @param command - the command
+ *
+ * @return - Length of the frame
+ */
+uint8_t Test_ComposeFrame(uint8_t * frame, const Test_Command * command);
+
+/**
+ * Encodes a frame for SLIP framing, including both delimiters
+ *
+ * @param encoded - filled with the encoded frame, at least TEST_SLIP_MAXIMUM_LENGTH bytes
+ * @param frame - the frame
+ * @param length - length of the frame
+ *
+ * @return - Length of the encoded frame
+ */
+uint8_t Test_EncodeSLIP(uint8_t * encoded, const uint8_t * frame, uint8_t length);
+
+/**
+ * Runs the loop of the communication module, time advances by TEST_PASS_MILLISECONDS in every pass
+ * Checks that every pass returns without millis and micros advancing, that is without waiting for data
+ *
+ * @param passes - number of passes
+ */
+void Test_Run(uint16_t passes);
+
+/**
+ * Gets the next write command received by the test cursor
+ *
+ * @return - Pointer to the command or NULL if there is no new command
+ */
+const Communication_Command * Test_GetCommand(void);
+
+/**
+ * Compares a received command with the sent one, data shorter than COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH must be padded with zeroes
+ *
+ * @param received - received command, may be NULL
+ * @param sent - sent command
+ *
+ * @return - True if they are equal
+ */
+bool Test_IsEqual(const Communication_Command * received, const Test_Command * sent);
+
+/* </Declarations (prototypes)> */
+
+#endif /* TEST_H */
@@ -0,0 +1,162 @@
+/**
+ * Arduino.cpp
+ * Host stub of the Arduino core for the tests
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+/* <Includes> */
+
+#include <stdio.h>
+#include <deque>
+#include <vector>
+#include "Arduino.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+#define STUBS_TX_BUFFER_SIZE 64 /* Serial transmit buffer of the UNO */
+#define STUBS_IDLE_POLLS 2 /* Polls of the empty serial port in a loop pass that take no time, more polls wait for data */
+#define STUBS_POLL_MICROSECONDS 100 /* Time of a poll that waits for data */
+
+HardwareSerial Serial;
+HardwareSerial SerialUSB;
+static std::deque<uint8_t> received;
+static std::vector<uint8_t> transmitted;
+static uint32_t currentTime; /* us */
+static uint16_t emptyPolls; /* Polls of the empty serial port since the last received byte or the last Stubs_SetMillis */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Counts a poll of the empty serial port, a loop that keeps polling it waits for data and the time advances
+ */
+void Stubs_PollEmpty(void);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void HardwareSerial::begin(unsigned long baudRate)
+{
+  emptyPolls = 0;
+}
+
+void HardwareSerial::end(void)
+{
+}
+
+void HardwareSerial::flush(void)
+{
+}
+
+int HardwareSerial::available(void)
+{
+  if (received.empty())
+  {
+    Stubs_PollEmpty();
+  }
+  return received.size();
+}
+
+int HardwareSerial::availableForWrite(void)
+{
+  return STUBS_TX_BUFFER_SIZE - 1; /* The host drains the buffer immediately */
+}
+
+int HardwareSerial::read(void)
+{
+  int data;
+
+  if (received.empty())
+  {
+    Stubs_PollEmpty();
+    return -1;
+  }
+  data = received.front();
+  received.pop_front();
+  return data;
+}
+
+size_t HardwareSerial::write(uint8_t data)
+{
+  transmitted.push_back(data);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t * data, size_t length)
+{
+  transmitted.insert(transmitted.end(), data, data + length);
+  return length;
+}
+
+HardwareSerial::operator bool(void)
+{
+  return true;
+}
+
+uint32_t millis(void)
+{
+  return currentTime / 1000;
+}
+
+uint32_t micros(void)
+{
+  return currentTime;
+}
+
+char * ultoa(unsigned long value, char * text, int radix)
+{
+  sprintf(text, "%lu", value); /* Only decimal numbers are printed */
+  return text;
+}
+
+void Stubs_Receive(const uint8_t * data, size_t length)
+{
+  received.insert(received.end(), data, data + length);
+  emptyPolls = 0;
+}
+
+size_t Stubs_GetPendingBytes(void)
+{
+  return received.size();
+}
+
+const uint8_t * Stubs_GetTransmitted(size_t * length)
+{
+  *length = transmitted.size();
+  return transmitted.data();
+}
+
+void Stubs_ClearTransmitted(void)
+{
+  transmitted.clear();
+}
+
+void Stubs_SetMillis(uint32_t newTime)
+{
+  currentTime = newTime * 1000;
+  emptyPolls = 0;
+}
+
+void Stubs_PollEmpty(void)
+{
+  if (emptyPolls < STUBS_IDLE_POLLS)
+  {
+    emptyPolls++;
+  }
+  else
+  {
+    currentTime += STUBS_POLL_MICROSECONDS;
+  }
+}
+
+/* </Implementations> */
@@ -0,0 +1,104 @@
+/**
+ * Arduino.h
+ * Host stub of the Arduino core for the tests, only what the communication module needs
+ * Time does not run by itself, tests set it with Stubs_SetMillis
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+/* <Includes> */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define F_CPU 16000000UL /* Arduino UNO */
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+/* </Defines> */
+
+
+/* <Classes> */
+
+/**
+ * Serial port that reads the bytes queued by Stubs_Receive and records the written bytes
+ * Polling the empty port more than twice in a loop pass is waiting for data, every such poll advances millis and micros
+ */
+class HardwareSerial
+{
+  public:
+    void begin(unsigned long baudRate);
+    void end(void);
+    void flush(void);
+    int available(void);
+    int availableForWrite(void);
+    int read(void);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t * data, size_t length);
+    operator bool(void);
+};
+
+/* </Classes> */
+
+
+/* <Declarations (prototypes)> */
+
+extern HardwareSerial Serial;
+extern HardwareSerial SerialUSB;
+
+uint32_t millis(void);
+uint32_t micros(void);
+char * ultoa(unsigned long value, char * text, int radix);
+
+/**
+ * Queues bytes that the serial port receives, they are read by the next Serial.read calls
+ *
+ * @param data - received bytes
+ * @param length - number of bytes
+ */
+void Stubs_Receive(const uint8_t * data, size_t length);
+
+/**
+ * Gets the number of received bytes that were not read yet
+ *
+ * @return - Number of bytes
+ */
+size_t Stubs_GetPendingBytes(void);
+
+/**
+ * Gets the bytes written to the serial port since the last Stubs_ClearTransmitted
+ *
+ * @param length - filled with the number of bytes
+ *
+ * @return - Pointer to the bytes
+ */
+const uint8_t * Stubs_GetTransmitted(size_t * length);
+
+/**
+ * Forgets the bytes written to the serial port
+ */
+void Stubs_ClearTransmitted(void);
+
+/**
+ * Sets the time returned by millis and micros, starts a new loop pass
+ *
+ * @param time - time in ms
+ */
+void Stubs_SetMillis(uint32_t time);
+
+/* </Declarations (prototypes)> */
+
+#endif /* ARDUINO_H */
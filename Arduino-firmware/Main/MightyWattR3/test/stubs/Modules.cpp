@@ -0,0 +1,226 @@
+/**
+ * Modules.cpp
+ * Fixed values of the modules that the communication module reads, the tests do not exercise them
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+/* <Includes> */
+
+#include "Arduino.h"
+#include "ADC.h"
+#include "Control.h"
+#include "ControlTick.h"
+#include "DACC.h"
+#include "Fan.h"
+#include "FanController.h"
+#include "LED.h"
+#include "LEDController.h"
+#include "Limiter.h"
+#include "Measurement.h"
+#include "PinController.h"
+#include "RangeSwitcher.h"
+#include "Scheduler.h"
+#include "Thermometer.h"
+#include "Voltmeter.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static Measurement_Values measurementValues;
+static TSCUChar temperature;
+static ADC_Burst burst;
+static ADC_ChannelWeights weights = {ADC_DEFAULT_WEIGHT, ADC_DEFAULT_WEIGHT};
+static ADS1x15_ChannelSetting channelSetting;
+static int32_t filterData[1];
+static Filter_Data filter = {filterData, 1};
+static Scheduler_TaskStatistics taskStatistics;
+static ControlTick_Statistics tickStatistics;
+
+/* </Module variables> */
+
+
+/* <Implementations> */
+
+const Measurement_Values * Measurement_GetValues(void)
+{
+  return &measurementValues;
+}
+
+uint8_t Measurement_GetBurstRange(void)
+{
+  return 0;
+}
+
+int32_t Measurement_GetBurstSample(uint16_t index)
+{
+  return 0;
+}
+
+const TSCUChar * Thermometer_GetTemperature(void)
+{
+  return &temperature;
+}
+
+const ADC_Burst * ADC_GetBurst(void)
+{
+  return &burst;
+}
+
+void ADC_ReleaseBurst(void)
+{
+}
+
+const Filter_Data * ADC_GetFilter(ADC_Channels adcChannel)
+{
+  return &filter;
+}
+
+const ADC_ChannelWeights * ADC_GetWeights(void)
+{
+  return &weights;
+}
+
+ADC_WeightSources ADC_GetWeightSource(void)
+{
+  return Weights_Mode;
+}
+
+uint16_t ADC_GetSampleRate(ADC_Channels adcChannel)
+{
+  return 0;
+}
+
+const ADS1x15_ChannelSetting * ADC_GetChannelSetting(ADC_Channels adcChannel)
+{
+  return &channelSetting;
+}
+
+bool ADC_IsChannelFiltered(ADC_Channels adcChannel)
+{
+  return false;
+}
+
+uint16_t DACC_GetValue()
+{
+  return 0;
+}
+
+Communication_WriteCommands Control_GetMode(void)
+{
+  return WriteCommand_ConstantCurrent;
+}
+
+Control_CCCVStates Control_GetCCCV(void)
+{
+  return (Control_CCCVStates)0;
+}
+
+uint32_t Control_GetSetCurrent(void)
+{
+  return 0;
+}
+
+uint32_t Control_GetSetVoltage(void)
+{
+  return 0;
+}
+
+uint32_t Control_GetSetPower(void)
+{
+  return 0;
+}
+
+uint32_t Control_GetSetResistance(void)
+{
+  return 0;
+}
+
+Voltmeter_Modes Voltmeter_GetMode(void)
+{
+  return (Voltmeter_Modes)0;
+}
+
+RangeSwitcher_CurrentRanges RangeSwitcher_GetCurrentRange(void)
+{
+  return (RangeSwitcher_CurrentRanges)0;
+}
+
+RangeSwitcher_VoltageRanges RangeSwitcher_GetVoltageRange(void)
+{
+  return (RangeSwitcher_VoltageRanges)0;
+}
+
+bool RangeSwitcher_CanAutorangeCurrent(void)
+{
+  return true;
+}
+
+bool RangeSwitcher_CanAutorangeVoltage(void)
+{
+  return true;
+}
+
+uint8_t PinController_GetPins(void)
+{
+  return 0;
+}
+
+FanController_Rules FanController_GetRules(void)
+{
+  return (FanController_Rules)0;
+}
+
+uint8_t LEDController_GetRules(void)
+{
+  return 0;
+}
+
+uint8_t LEDController_GetBrightness(void)
+{
+  return 0;
+}
+
+uint16_t Limiter_GetSeriesResistance(void)
+{
+  return 0;
+}
+
+Fan_States Fan_Get(void)
+{
+  return (Fan_States)0;
+}
+
+bool LED_Get(void)
+{
+  return false;
+}
+
+uint8_t Scheduler_GetTaskCount(void)
+{
+  return 0;
+}
+
+const Scheduler_TaskStatistics * Scheduler_GetStatistics(uint8_t task)
+{
+  return &taskStatistics;
+}
+
+void Scheduler_ResetStatistics(void)
+{
+}
+
+const ControlTick_Statistics * ControlTick_GetStatistics(void)
+{
+  return &tickStatistics;
+}
+
+void ControlTick_ResetStatistics(void)
+{
+}
+
+/* </Implementations> */
@@ -0,0 +1,19 @@
+/**
+ * pgmspace.h
+ * Host stub of the AVR flash memory access, data stay in RAM
+ *
+ * 2026-10-17
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef PGMSPACE_H
+#define PGMSPACE_H
+
+#define PROGMEM
+#define pgm_read_byte(x) (*(const uint8_t *)(x))
+#define pgm_read_word(x) (*(const uint16_t *)(x))
+#define pgm_read_dword(x) (*(const uint32_t *)(x))
+#define pgm_read_ptr(x) (*(void * const *)(x))
+
+#endif /* PGMSPACE_H */